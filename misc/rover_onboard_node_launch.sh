@@ -9,6 +9,7 @@ pkill navsat_transform
 pkill ekf_localization
 pkill diagnostics
 pkill static_transform_publisher
+pkill nodelet
 
 
 #Point to ROS master on the network
@@ -22,6 +23,16 @@ else
 fi
 
 
+#Pass "nodelets" as the second argument to run abridge, obstacle detection and
+#mobility in one nodelet manager, so sensor and obstacle messages between them
+#are passed as pointers instead of being serialised
+useNodelets=false
+if [ "$2" == "nodelets" ]
+then
+    useNodelets=true
+fi
+
+
 #Set prefix to fully qualify transforms for each robot
 rosparam set tf_prefix $HOSTNAME
 
@@ -47,8 +58,15 @@ findDevicePath() {
 #Startup ROS packages/processes
 nohup rosrun tf static_transform_publisher __name:=$HOSTNAME\_BASE2CAM 0.12 -0.03 0.195 -1.57 0 -2.22 /$HOSTNAME/base_link /$HOSTNAME/camera_link 100 &
 nohup rosrun usb_cam usb_cam_node __name:=$HOSTNAME\_CAMERA /$HOSTNAME\_CAMERA/image_raw:=/$HOSTNAME/camera/image _camera_info_url:=file://${HOME}/rover_workspace/camera_info/head_camera.yaml _image_width:=320 _image_height:=240 &
-nohup rosrun mobility mobility &
-nohup rosrun obstacle_detection obstacle &
+if [ "$useNodelets" == true ]
+then
+    nohup rosrun nodelet nodelet manager __name:=$HOSTNAME\_NODELET_MANAGER &
+    nohup rosrun nodelet nodelet load mobility/MobilityNodelet $HOSTNAME\_NODELET_MANAGER __name:=$HOSTNAME\_MOBILITY &
+    nohup rosrun nodelet nodelet load obstacle_detection/ObstacleNodelet $HOSTNAME\_NODELET_MANAGER __name:=$HOSTNAME\_OBSTACLE &
+else
+    nohup rosrun mobility mobility &
+    nohup rosrun obstacle_detection obstacle &
+fi
 nohup rosrun diagnostics diagnostics &
 
 rosparam set /$HOSTNAME\_TARGET/sensor_frame_id /$HOSTNAME/camera_link
@@ -61,7 +79,12 @@ if [ -z "$microcontrollerDevicePath" ]
 then
     echo "Error: Microcontroller device not found"
 else
-    nohup rosrun abridge abridge _device:=/dev/$microcontrollerDevicePath &
+    if [ "$useNodelets" == true ]
+    then
+        nohup rosrun nodelet nodelet load abridge/ABridgeNodelet $HOSTNAME\_NODELET_MANAGER __name:=$HOSTNAME\_ABRIDGE _device:=/dev/$microcontrollerDevicePath &
+    else
+        nohup rosrun abridge abridge _device:=/dev/$microcontrollerDevicePath &
+    fi
 fi
 
 gpsDevicePath=$(findDevicePath u-blox)
@@ -105,6 +128,7 @@ while true; do
 	rosnode kill $HOSTNAME\_DIAGNOSTICS
 	rosnode kill $HOSTNAME\_BASE2CAM
 	rosnode kill $HOSTNAME\_UBLOX
+	rosnode kill $HOSTNAME\_NODELET_MANAGER
 
 	exit 1
     fi
@@ -0,0 +1,22 @@
+#ifndef ABRIDGENODE_H
+#define	ABRIDGENODE_H
+
+#include <ros/ros.h>
+
+#include <string>
+
+// Entry points shared by the abridge node and the abridge nodelet. The serial
+// port and messages are global, so a process hosts at most one abridge.
+namespace abridge {
+
+    // Opens the serial port named by the device parameter, advertises the
+    // sensor topics of the rover publishedName and starts the serial, sensor
+    // and command threads. Sensor polling and command intake keep their own
+    // callback queues under a nodelet manager too.
+    void start(ros::NodeHandle& nodeHandle, ros::NodeHandle& param, const std::string& publishedName);
+
+    // Stops the threads, closes the port and shuts down the topics
+    void stop();
+}
+
+#endif	/* ABRIDGENODE_H */
@@ -0,0 +1,94 @@
+#ifndef BINARYPROTOCOL_H
+#define	BINARYPROTOCOL_H
+
+#include <stdint.h>
+
+#include <telemetryParser.h>
+
+// Optional binary framing used between abridge and the Arduino in place of the
+// comma separated ASCII lines. Every packet is laid out as
+//
+//   [sync 0xA5][payload length][type][payload ...][crc16 low][crc16 high]
+//
+// The CRC is CRC-16/CCITT (poly 0x1021, init 0xFFFF) over the length, type and
+// payload bytes. Multi byte values are little endian. Numbers are sent as
+// signed 16 bit fixed point, see the scale factors in binaryProtocol.cpp.
+//
+// abridge offers the protocol with a HELLO packet when the port is opened. An
+// Arduino that understands it answers with HELLO_ACK, anything else (including
+// the ASCII firmware) is left on the ASCII protocol.
+
+const uint8_t binarySyncByte = 0xA5;
+const uint8_t binaryProtocolVersion = 1;
+const int binaryPacketOverhead = 5; // sync, length, type and crc
+const int binaryMaxPayload = 64;
+const int binaryMaxPacket = binaryMaxPayload + binaryPacketOverhead;
+
+enum BinaryPacketType {
+    // abridge to Arduino
+    PACKET_HELLO = 0x01,             // payload: protocol version
+    PACKET_REQUEST_TELEMETRY = 0x02, // same as the ASCII "d" command
+    PACKET_MOVE = 0x03,              // payload: int16 speed, -255 to 255
+    PACKET_TURN = 0x04,              // payload: int16 speed, -255 to 255
+    PACKET_STOP = 0x05,
+    PACKET_FINGER = 0x06,            // payload: int16 angle in milliradians
+    PACKET_WRIST = 0x07,             // payload: int16 angle in milliradians
+
+    // Arduino to abridge
+    PACKET_HELLO_ACK = 0x81,         // payload: protocol version
+    PACKET_TELEMETRY = 0x82          // payload: TELEMETRY_FIELD_COUNT int16 values,
+                                     // optionally followed by uint32 millis()
+};
+
+struct BinaryPacket {
+    uint8_t type;
+    uint8_t length;
+    uint8_t payload[binaryMaxPayload];
+};
+
+uint16_t binaryCrc16(const uint8_t* data, int length);
+
+// Writes a complete packet into packet and returns its length in bytes, or 0
+// if the payload does not fit.
+int encodeBinaryPacket(uint8_t type, const uint8_t* payload, int payloadLength, uint8_t* packet, int size);
+
+// Convenience encoders for the abridge to Arduino commands
+int encodeBinaryCommand(uint8_t type, uint8_t* packet, int size);
+int encodeBinaryCommand(uint8_t type, int16_t value, uint8_t* packet, int size);
+
+// Conversions between a telemetry frame and a PACKET_TELEMETRY packet.
+// Values outside the fixed point range are clamped.
+int encodeBinaryTelemetry(const TelemetryFrame& frame, uint8_t* packet, int size);
+bool decodeBinaryTelemetry(const BinaryPacket& packet, TelemetryFrame& frame);
+
+// Incremental decoder for the byte stream coming off the serial port. Bytes
+// are pushed one at a time and complete, CRC checked packets are handed back.
+// Corrupt packets are dropped and the decoder resynchronizes on the next sync
+// byte.
+class BinaryPacketDecoder {
+public:
+
+    BinaryPacketDecoder();
+
+    // Returns true when byte completes a valid packet, which is copied into packet
+    bool push(uint8_t byte, BinaryPacket& packet);
+
+    // True while waiting for the sync byte that starts the next packet
+    bool idle() const { return state == WAIT_SYNC; }
+
+    void reset();
+
+    unsigned long crcErrors() const { return crcErrorCount; }
+
+private:
+
+    enum State { WAIT_SYNC, READ_LENGTH, READ_TYPE, READ_PAYLOAD, READ_CRC_LOW, READ_CRC_HIGH };
+
+    State state;
+    BinaryPacket current;
+    int payloadRead;
+    uint16_t receivedCrc;
+    unsigned long crcErrorCount;
+};
+
+#endif	/* BINARYPROTOCOL_H */
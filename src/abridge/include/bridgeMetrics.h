@@ -0,0 +1,78 @@
+#ifndef BRIDGEMETRICS_H
+#define	BRIDGEMETRICS_H
+
+#include <chrono>
+#include <mutex>
+
+// Order of the values in the Float32MultiArray published on
+// /<rover>/abridge/stats. Counts cover the interval since the previous
+// message, latencies are in milliseconds from the telemetry request to the
+// parsed frame.
+enum BridgeStatField {
+    STAT_INTERVAL = 0,       // seconds covered by this message
+    STAT_FRAMES_OK,
+    STAT_FRAMES_MALFORMED,   // wrong field count or bad numbers
+    STAT_FRAMES_PARTIAL,     // truncated or overrun frames dropped during reassembly
+    STAT_BYTES_READ,
+    STAT_BYTES_WRITTEN,
+    STAT_BYTES_FLUSHED,      // input discarded by tcflush in poll mode, or output by a write that timed out
+    STAT_COMMANDS_PENDING,   // commands waiting in the scheduler slots
+    STAT_COMMANDS_COALESCED, // commands replaced before being written
+    STAT_LATENCY_P50,
+    STAT_LATENCY_P95,
+    STAT_LATENCY_MAX,
+    STAT_LATENCY_HISTOGRAM,  // first of the latency histogram bins below
+    STAT_FIELD_COUNT = STAT_LATENCY_HISTOGRAM + 8
+};
+
+// Upper edges of the latency histogram bins in milliseconds. The last bin
+// collects everything slower.
+const float latencyBinEdges[] = { 2, 5, 10, 20, 50, 100, 200 };
+const int latencyBinCount = STAT_FIELD_COUNT - STAT_LATENCY_HISTOGRAM;
+
+struct BridgeStats {
+    float values[STAT_FIELD_COUNT];
+};
+
+// Collects timing and drop counts for the serial bridge. All methods are safe
+// to call from any of abridge's threads. Counters restart every time a
+// snapshot is taken, cumulative counters owned by other classes are passed in
+// and turned into per interval deltas here.
+class BridgeMetrics {
+public:
+
+    BridgeMetrics();
+
+    void requestSent();
+    void frameParsed();
+    void frameMalformed();
+
+    // Fills stats with the values for the interval since the last snapshot
+    void snapshot(unsigned long bytesRead, unsigned long bytesWritten, unsigned long bytesFlushed,
+                  unsigned long partialFrames, unsigned long coalescedCommands, int pendingCommands,
+                  BridgeStats& stats);
+
+private:
+
+    static const int maxLatencySamples = 512;
+
+    std::mutex metricsMutex;
+    std::chrono::steady_clock::time_point intervalStart;
+    std::chrono::steady_clock::time_point lastRequest;
+    bool requestOutstanding;
+
+    unsigned long framesOk;
+    unsigned long framesMalformed;
+    unsigned long histogram[latencyBinCount];
+    float latencySamples[maxLatencySamples];
+    int latencySampleCount;
+
+    // Cumulative counters at the previous snapshot
+    unsigned long lastBytesRead;
+    unsigned long lastBytesWritten;
+    unsigned long lastBytesFlushed;
+    unsigned long lastPartialFrames;
+    unsigned long lastCoalescedCommands;
+};
+
+#endif	/* BRIDGEMETRICS_H */
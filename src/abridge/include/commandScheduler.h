@@ -0,0 +1,65 @@
+#ifndef COMMANDSCHEDULER_H
+#define	COMMANDSCHEDULER_H
+
+#include <stdint.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <usbSerial.h>
+
+// One command for the Arduino in both wire formats. ascii is the line sent on
+// the ASCII protocol, packetType and value make up the binary packet.
+struct OutboundCommand {
+    char ascii[16];
+    uint8_t packetType;
+    int value;
+};
+
+// Outbound command scheduler. Motion, finger and wrist commands each have a
+// single slot where a newer command replaces an older one that has not been
+// written yet. A writer thread flushes the pending slots to the serial port at
+// no more than the configured rate, so bursts of commands collapse into the
+// latest setpoint instead of queuing up behind each other.
+class CommandScheduler {
+public:
+
+    enum Slot { MOTION = 0, FINGER, WRIST, SLOT_COUNT };
+
+    CommandScheduler(USBSerial& usb);
+    virtual ~CommandScheduler();
+
+    void start(double rateHz);
+    void stop();
+
+    // Replaces whatever is waiting in slot. Never blocks on the serial port.
+    void submit(Slot slot, const OutboundCommand& command);
+
+    // Writes a command right away from the calling thread, bypassing the slots
+    void sendNow(const OutboundCommand& command);
+
+    // Number of commands that were replaced before they reached the port
+    unsigned long coalescedCommands();
+
+    // Number of slots holding a command that has not been written yet
+    int pendingCommands();
+
+private:
+
+    void writerLoop();
+
+    USBSerial& usb;
+    OutboundCommand slots[SLOT_COUNT];
+    bool pending[SLOT_COUNT];
+    unsigned long coalesced;
+
+    std::chrono::steady_clock::duration period;
+    bool running;
+    std::mutex slotMutex;
+    std::condition_variable slotUpdated;
+    std::thread writerThread;
+};
+
+#endif	/* COMMANDSCHEDULER_H */
@@ -0,0 +1,31 @@
+#ifndef DEVICECLOCK_H
+#define	DEVICECLOCK_H
+
+// Maps the Arduino's millis() counter onto the host clock. Every frame gives
+// one sample of (receive time - device time), which is the clock offset plus
+// the transmission delay. The smallest sample over a recent window is the one
+// with the least delay, so it is used as the offset estimate. The window
+// lets the estimate follow slow drift between the two oscillators.
+class DeviceClock {
+public:
+
+    DeviceClock();
+
+    // Returns the host time, in seconds, at which a frame stamped with
+    // deviceMillis was taken. receiveTime is when the frame arrived on the
+    // host. The result is never later than receiveTime.
+    double toHostTime(unsigned long deviceMillis, double receiveTime);
+
+    void reset();
+
+private:
+
+    static const int windowSize = 64;
+
+    double offsets[windowSize];
+    int offsetCount;
+    int nextOffset;
+    unsigned long lastMillis;
+};
+
+#endif	/* DEVICECLOCK_H */
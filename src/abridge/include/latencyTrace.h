@@ -0,0 +1,67 @@
+#ifndef LATENCYTRACE_H
+#define	LATENCYTRACE_H
+
+#include <atomic>
+#include <vector>
+
+// Stage times of one sensor-to-actuation trace, in seconds on the host clock.
+// obstacle_detection starts the trace with the first three values on
+// /<rover>/obstacle/trace, mobility appends two and forwards it on
+// /<rover>/velocity/trace, and abridge appends the last.
+enum TraceField {
+    TRACE_ORIGIN = 0,          // stamp of the oldest sonar reading in the triplet
+    TRACE_OBSTACLE_RECEIVED,   // triplet handed to the obstacle filter
+    TRACE_OBSTACLE_PUBLISHED,  // obstacle message published
+    TRACE_MOBILITY_RECEIVED,   // obstacle message reached mobility
+    TRACE_VELOCITY_PUBLISHED,  // resulting velocity command published
+    TRACE_COMMAND_RECEIVED,    // velocity command reached cmdHandler
+    TRACE_FIELD_COUNT
+};
+
+struct TraceRecord {
+    double times[TRACE_FIELD_COUNT];
+};
+
+// Latency between two fields over a set of traces, in milliseconds
+struct TraceSummary {
+    int count;
+    double median;
+    double p95;
+    double max;
+};
+
+// Fixed size ring of the most recent traces. A single thread records while any
+// thread takes snapshots. Neither side blocks: every slot carries a sequence
+// number that is odd while the slot is being written, and a reader drops the
+// slots that changed while it was copying them.
+class LatencyTrace {
+public:
+
+    static const int capacity = 1024;
+
+    LatencyTrace();
+
+    // Only one thread may record
+    void record(const TraceRecord& record);
+
+    // Copies the traces still in the ring, oldest first
+    void snapshot(std::vector<TraceRecord>& records) const;
+
+    // Traces recorded since construction, including those overwritten
+    unsigned long recorded() const { return head.load(std::memory_order_acquire); }
+
+    // Latency from field from to field to, skipping traces where it is negative
+    static TraceSummary summarize(const std::vector<TraceRecord>& records, int from, int to);
+
+private:
+
+    struct Slot {
+        std::atomic<unsigned long> sequence; // 2 * index + 2 once the record with that index is complete
+        std::atomic<double> times[TRACE_FIELD_COUNT];
+    };
+
+    Slot slots[capacity];
+    std::atomic<unsigned long> head; // index of the next record
+};
+
+#endif	/* LATENCYTRACE_H */
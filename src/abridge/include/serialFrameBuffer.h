@@ -0,0 +1,68 @@
+#ifndef SERIALFRAMEBUFFER_H
+#define	SERIALFRAMEBUFFER_H
+
+#include <stddef.h>
+
+#include <atomic>
+
+// Ring buffer that reassembles the newline delimited frames streamed by the
+// Arduino. Bytes are appended as they arrive from the serial port and complete
+// frames are handed out one at a time. Partial frames stay in the buffer until
+// the rest of the frame arrives instead of being flushed away.
+//
+// Along with the bytes the buffer remembers when the first byte of each frame
+// arrived so frames can be handed out with their receive time.
+class SerialFrameBuffer {
+public:
+
+    SerialFrameBuffer();
+
+    // Adds raw serial bytes that arrived at receiveTime (seconds, any clock).
+    // Returns false if the buffer overflowed and the oldest bytes had to be
+    // discarded.
+    bool append(const char* data, int length, double receiveTime = 0.0);
+
+    // Copies the next complete frame, without its line ending, into frame
+    // and null terminates it. If firstByteTime is given it is set to the
+    // receive time of the chunk that held the frame's first byte. Returns
+    // false if no complete frame is buffered.
+    bool nextFrame(char* frame, int size, double* firstByteTime = NULL);
+
+    void clear();
+
+    // Frames thrown away because they overran the buffer or the caller's frame.
+    // Safe to call from another thread than the one appending.
+    unsigned long discardedFrames() const { return discarded; }
+
+    static const int capacity = 1024;
+
+private:
+
+    char buffer[capacity];
+    int head;     // index of the oldest buffered byte
+    int count;    // number of buffered bytes
+    int scanned;  // bytes from head already searched for a newline
+
+    // Set after an overflow so the truncated frame is thrown away
+    bool discardUntilNewline;
+
+    std::atomic<unsigned long> discarded;
+
+    // Arrival time of each buffered frame's first byte, oldest first, keyed
+    // by the stream position of that byte
+    struct Arrival {
+        unsigned long long position;
+        double time;
+    };
+    static const int maxArrivals = 32;
+    Arrival arrivals[maxArrivals];
+    int arrivalHead;
+    int arrivalCount;
+    unsigned long long appended; // stream position just past the newest byte
+    bool atFrameStart;           // the next appended byte starts a frame
+
+    double arrivalTime(unsigned long long position) const;
+    void dropArrivalsBefore(unsigned long long position);
+};
+
+#endif	/* SERIALFRAMEBUFFER_H */
@@ -0,0 +1,41 @@
+#ifndef TELEMETRYPARSER_H
+#define	TELEMETRYPARSER_H
+
+// Positions of the values in the comma separated telemetry line sent by the
+// Arduino. Units are the raw units reported by the microcontroller.
+enum TelemetryField {
+    ACCEL_X = 0, ACCEL_Y, ACCEL_Z,             // linear acceleration
+    GYRO_X, GYRO_Y, GYRO_Z,                    // angular velocity
+    ROLL, PITCH, YAW,                          // IMU orientation (radians)
+    ODOM_DELTA_X, ODOM_DELTA_Y,                // change in position (cm)
+    ODOM_YAW,                                  // odometry heading (radians)
+    ODOM_VELOCITY_X, ODOM_VELOCITY_Y,          // linear velocity (cm/s)
+    ODOM_ANGULAR_Z,                            // angular velocity (radians/s)
+    SONAR_LEFT, SONAR_CENTER, SONAR_RIGHT,     // ultrasound ranges (cm)
+    TELEMETRY_FIELD_COUNT
+};
+
+// Firmware that keeps time may append its millis() counter as a 19th field.
+// hasDeviceTime says whether this frame carried one.
+struct TelemetryFrame {
+    float values[TELEMETRY_FIELD_COUNT];
+    bool hasDeviceTime;
+    unsigned long deviceMillis;
+};
+
+enum TelemetryParseResult {
+    TELEMETRY_OK,
+    TELEMETRY_TOO_FEW_FIELDS,
+    TELEMETRY_TOO_MANY_FIELDS,
+    TELEMETRY_BAD_NUMBER
+};
+
+// Parses one telemetry line in place. No memory is allocated: the numbers are
+// converted directly out of data[0, length) into frame. The frame is only
+// valid when TELEMETRY_OK is returned.
+TelemetryParseResult parseTelemetryFrame(const char* data, int length, TelemetryFrame& frame);
+
+// Human readable description of a parse result for log messages
+const char* telemetryParseResultString(TelemetryParseResult result);
+
+#endif	/* TELEMETRYPARSER_H */
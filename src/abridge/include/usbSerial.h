@@ -9,6 +9,14 @@
 #include <unistd.h>  
 #include <fcntl.h>   
 #include <termios.h> 
+#include <sys/select.h>
+#include <sys/ioctl.h>
+#include <errno.h>
+
+#include <atomic>
+#include <mutex>
+
+#include <binaryProtocol.h>
 
 using namespace std;
 
@@ -18,17 +26,41 @@ public:
     USBSerial();
     virtual ~USBSerial();
   
-    void openUSBPort(string devicePath, int baud);
+    // When tryBinary is set the binary protocol is offered to the Arduino and
+    // used if it acknowledges, otherwise the port stays on ASCII.
+    void openUSBPort(string devicePath, int baud, bool tryBinary = false);
     void sendData(char data[]);
+    // Returns false, after counting the unsent bytes as flushed, if the
+    // Arduino does not take them within a short timeout
+    bool sendBytes(const uint8_t* data, int length);
+    bool usingBinaryProtocol() const { return binaryMode; }
+
+    // Running totals of the traffic through the port
+    unsigned long bytesRead() const { return bytesReadCount; }
+    unsigned long bytesWritten() const { return bytesWrittenCount; }
+    unsigned long bytesFlushed() const { return bytesFlushedCount; }
     string readData();
     void closeUSBPort();
 
+    // Event driven reading. waitForData blocks until the port is readable or
+    // timeoutMs elapses. readAvailable then returns whatever bytes are waiting
+    // without flushing the port, so frames that are still arriving are kept.
+    bool waitForData(int timeoutMs);
+    int readAvailable(char* buffer, int size);
+
 private:
 
     struct termios ioStruct;
     int usbFileDescriptor;
     char serialDataIn[128];
-    char dataOut[16];
+    bool binaryMode;
+    std::mutex writeMutex; // keeps writes from different threads from interleaving
+    std::atomic<unsigned long> bytesReadCount;
+    std::atomic<unsigned long> bytesWrittenCount;
+    std::atomic<unsigned long> bytesFlushedCount;
+
+    bool negotiateBinaryProtocol(int timeoutMs);
+    bool waitForWritable(int timeoutMs);
 
 };
 
@@ -5,6 +5,9 @@
 
 //ROS messages
 #include <std_msgs/Float32.h>
+#include <std_msgs/Empty.h>
+#include <std_msgs/Float32MultiArray.h>
+#include <std_msgs/Float64MultiArray.h>
 #include <std_msgs/String.h>
 #include <geometry_msgs/Quaternion.h>
 #include <geometry_msgs/Twist.h>
@@ -13,17 +16,44 @@
 #include <sensor_msgs/Range.h>
 
 //Package include
+#include <abridgeNode.h>
 #include <usbSerial.h>
+#include <serialFrameBuffer.h>
+#include <telemetryParser.h>
+#include <binaryProtocol.h>
+#include <commandScheduler.h>
+#include <bridgeMetrics.h>
+#include <deviceClock.h>
+#include <latencyTrace.h>
+
+#include <ros/callback_queue.h>
+
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <thread>
 
 using namespace std;
 
+namespace abridge {
+
 //aBridge functions
 void cmdHandler(const geometry_msgs::Twist::ConstPtr& message);
 void fingerAngleHandler(const std_msgs::Float32::ConstPtr& angle);
 void wristAngleHandler(const std_msgs::Float32::ConstPtr& angle);
+void velocityTraceHandler(const std_msgs::Float64MultiArray::ConstPtr& trace);
+void traceDumpHandler(const std_msgs::Empty::ConstPtr& message);
+void recordTrace(const std_msgs::Float64MultiArray& trace, ros::Time commandReceived);
 void serialActivityTimer(const ros::TimerEvent& e);
+void statsTimer(const ros::TimerEvent& e);
+void serialStartup(string devicePath);
+void serialReader();
+void readAsciiFrames(const char* bytes, int length, ros::Time receiveTime);
+void readBinaryPackets(const char* bytes, int length, ros::Time receiveTime);
+OutboundCommand makeCommand(uint8_t packetType, int value);
 void publishRosTopics();
-void parseData(string data);
+bool parseData(const char* data, int length, ros::Time receiveTime);
+bool updateMessages(const TelemetryFrame& frame, ros::Time receiveTime);
 
 //Globals
 sensor_msgs::Imu imu;
@@ -32,15 +62,35 @@ sensor_msgs::Range sonarLeft;
 sensor_msgs::Range sonarCenter;
 sensor_msgs::Range sonarRight;
 USBSerial usb;
+CommandScheduler commandScheduler(usb);
+BridgeMetrics metrics;
+SerialFrameBuffer frameBuffer;
+BinaryPacketDecoder packetDecoder;
+ros::Time packetStartTime; // receive time of the first byte of the binary packet being decoded
+DeviceClock arduinoClock;
+string serialMode; // "stream" reads frames as they arrive, "poll" is the old poll-and-flush mode
+string protocol; // "ascii" or "binary", binary falls back to ascii if the Arduino does not support it
 const int baud = 115200;
-char dataCmd[] = "d\n";
-char moveCmd[16];
-char host[128];
-char delimiter = ',';
-vector<string> dataSet;
+TelemetryFrame telemetry;
+std::mutex telemetryMutex; // guards telemetry, imu, odom and the sonar messages
+unsigned long malformedFrames = 0;
 float linearSpeed = 0.;
 float turnSpeed = 0.;
-const float deltaTime = 0.1;
+float telemetryRate = 10.0; // Hz
+double commandRate = 20.0; // Hz, maximum rate commands are written to the Arduino
+double statsInterval = 1.0; // seconds between bridge statistics messages
+const int arduinoBootTime = 5000; // ms the ASCII firmware is given to start after opening the port resets it
+
+//Latency tracing, see latencyTrace.h. The command thread records, dumps run on
+//the sensor thread.
+LatencyTrace latencyTrace;
+std_msgs::Float64MultiArray::ConstPtr pendingTrace; // velocity trace that arrived before its command
+ros::Time lastVelocityReceived;
+string traceFile; // CSV of the traces written on every dump, none if empty
+
+//Every parsed frame is appended to this file when the record_file parameter is
+//set, in the recorded run format replayed by mobility's pipeline_replay_benchmark
+FILE* recordFile = NULL;
 
 //Publishers
 ros::Publisher imuPublish;
@@ -48,154 +98,461 @@ ros::Publisher odomPublish;
 ros::Publisher sonarLeftPublish;
 ros::Publisher sonarCenterPublish;
 ros::Publisher sonarRightPublish;
+ros::Publisher statsPublish;
 
 //Subscribers
 ros::Subscriber velocitySubscriber;
 ros::Subscriber fingerAngleSubscriber;
 ros::Subscriber wristAngleSubscriber;
+ros::Subscriber velocityTraceSubscriber;
+ros::Subscriber traceDumpSubscriber;
 
 //Timers
 ros::Timer publishTimer;
+ros::Timer statsPublishTimer;
 
-int main(int argc, char **argv) {
-    
-    gethostname(host, sizeof (host));
-    string hostname(host);
-    string publishedName;
-    ros::init(argc, argv, (hostname + "_ABRIDGE"));
-    
-    ros::NodeHandle param("~");
+//Callback queues. Serial polling and command intake are served by separate
+//threads so slow telemetry never delays a motor command.
+ros::CallbackQueue sensorQueue;
+ros::CallbackQueue commandQueue;
+
+//Spinners for the two queues, running between start() and stop()
+ros::AsyncSpinner* sensorSpinner = NULL;
+ros::AsyncSpinner* commandSpinner = NULL;
+
+//Threads
+std::thread serialThread; // opens the port, then runs serialReader in stream mode
+std::atomic<bool> running(false); // cleared by stop() to end serialStartup and serialReader
+std::atomic<bool> portReady(false); // set once the Arduino has started and takes commands
+
+void start(ros::NodeHandle& nodeHandle, ros::NodeHandle& param, const string& publishedName) {
     string devicePath;
     param.param("device", devicePath, string("/dev/ttyUSB0"));
-    usb.openUSBPort(devicePath, baud);
-    
-    sleep(5);
-    
-    ros::NodeHandle aNH;
-    
-    if (argc >= 2) {
-        publishedName = argv[1];
-        cout << "Welcome to the world of tomorrow " << publishedName << "!  ABridge module started." << endl;
-    } else {
-        publishedName = hostname;
-        cout << "No Name Selected. Default is: " << publishedName << endl;
+    param.param("serial_mode", serialMode, string("stream"));
+    if (serialMode != "stream" && serialMode != "poll") {
+        cout << "Unknown serial_mode " << serialMode << ", falling back to poll" << endl;
+        serialMode = "poll";
+    }
+    param.param("protocol", protocol, string("ascii"));
+    if (protocol == "binary" && serialMode != "stream") {
+        cout << "The binary protocol needs serial_mode stream, using ascii" << endl;
+        protocol = "ascii";
     }
+    param.param("telemetry_rate", telemetryRate, telemetryRate);
+    param.param("command_rate", commandRate, commandRate);
+    param.param("stats_interval", statsInterval, statsInterval);
+    param.param("trace_file", traceFile, string(""));
+    string recordPath;
+    param.param("record_file", recordPath, string(""));
+    if (!recordPath.empty()) {
+        recordFile = fopen(recordPath.c_str(), "a");
+        if (!recordFile) {
+            cout << "Could not open record_file " << recordPath << ", not recording" << endl;
+        }
+    }
+    ros::NodeHandle aNH(nodeHandle);
+    ros::NodeHandle sensorNH(nodeHandle);
+    sensorNH.setCallbackQueue(&sensorQueue);
+    ros::NodeHandle commandNH(nodeHandle);
+    commandNH.setCallbackQueue(&commandQueue);
     
     imuPublish = aNH.advertise<sensor_msgs::Imu>((publishedName + "/imu"), 10);
     odomPublish = aNH.advertise<nav_msgs::Odometry>((publishedName + "/odom"), 10);
     sonarLeftPublish = aNH.advertise<sensor_msgs::Range>((publishedName + "/sonarLeft"), 10);
     sonarCenterPublish = aNH.advertise<sensor_msgs::Range>((publishedName + "/sonarCenter"), 10);
     sonarRightPublish = aNH.advertise<sensor_msgs::Range>((publishedName + "/sonarRight"), 10);
+    statsPublish = aNH.advertise<std_msgs::Float32MultiArray>((publishedName + "/abridge/stats"), 10);
     
-    velocitySubscriber = aNH.subscribe((publishedName + "/velocity"), 10, cmdHandler);
-    fingerAngleSubscriber = aNH.subscribe((publishedName + "/fingerAngle"), 1, fingerAngleHandler);
-    wristAngleSubscriber = aNH.subscribe((publishedName + "/wristAngle"), 1, wristAngleHandler);
+    velocitySubscriber = commandNH.subscribe((publishedName + "/velocity"), 10, cmdHandler);
+    fingerAngleSubscriber = commandNH.subscribe((publishedName + "/fingerAngle"), 1, fingerAngleHandler);
+    wristAngleSubscriber = commandNH.subscribe((publishedName + "/wristAngle"), 1, wristAngleHandler);
+    velocityTraceSubscriber = commandNH.subscribe((publishedName + "/velocity/trace"), 10, velocityTraceHandler);
+    traceDumpSubscriber = sensorNH.subscribe((publishedName + "/trace_dump"), 1, traceDumpHandler);
     
-    publishTimer = aNH.createTimer(ros::Duration(deltaTime), serialActivityTimer);
+    publishTimer = sensorNH.createTimer(ros::Duration(1.0 / telemetryRate), serialActivityTimer);
+    statsPublishTimer = sensorNH.createTimer(ros::Duration(statsInterval), statsTimer);
     
     imu.header.frame_id = publishedName+"/base_link";
     
     odom.header.frame_id = publishedName+"/odom";
     odom.child_frame_id = publishedName+"/base_link";
 
-    ros::spin();
-    
-    return EXIT_SUCCESS;
+    // Waiting for the Arduino would otherwise hold up the nodelet manager
+    running = true;
+    serialThread = std::thread(serialStartup, devicePath);
+
+    sensorSpinner = new ros::AsyncSpinner(1, &sensorQueue);
+    commandSpinner = new ros::AsyncSpinner(1, &commandQueue);
+    sensorSpinner->start();
+    commandSpinner->start();
+}
+
+void stop() {
+    if (!running) {
+        return;
+    }
+    running = false;
+
+    velocitySubscriber.shutdown();
+    fingerAngleSubscriber.shutdown();
+    wristAngleSubscriber.shutdown();
+    velocityTraceSubscriber.shutdown();
+    traceDumpSubscriber.shutdown();
+    publishTimer.stop();
+    statsPublishTimer.stop();
+
+    sensorSpinner->stop();
+    commandSpinner->stop();
+    delete sensorSpinner;
+    delete commandSpinner;
+    sensorSpinner = NULL;
+    commandSpinner = NULL;
+
+    // Joined first as serialStartup starts the command scheduler
+    if (serialThread.joinable()) {
+        serialThread.join();
+    }
+    portReady = false;
+    commandScheduler.stop();
+    usb.closeUSBPort();
+
+    if (recordFile) {
+        fclose(recordFile);
+        recordFile = NULL;
+    }
+
+    imuPublish.shutdown();
+    odomPublish.shutdown();
+    sonarLeftPublish.shutdown();
+    sonarCenterPublish.shutdown();
+    sonarRightPublish.shutdown();
+    statsPublish.shutdown();
 }
 
 void cmdHandler(const geometry_msgs::Twist::ConstPtr& message) {
+    lastVelocityReceived = ros::Time::now();
+    if (pendingTrace) {
+        recordTrace(*pendingTrace, lastVelocityReceived);
+        pendingTrace.reset();
+    }
+
     // remove artificial factor that was multiplied for simulation. this scales it back down to -1.0 to +1.0
   linearSpeed = (message->linear.x); // / 1.5;
   turnSpeed = (message->angular.z); // / 8;
     
+    OutboundCommand command;
     if (linearSpeed != 0.) {
-        sprintf(moveCmd, "m,%d\n", (int) (linearSpeed * 255));
-        usb.sendData(moveCmd);
+        command = makeCommand(PACKET_MOVE, (int) (linearSpeed * 255));
+        sprintf(command.ascii, "m,%d\n", command.value);
     } else if (turnSpeed != 0.) {
-        sprintf(moveCmd, "t,%d\n", (int) (turnSpeed * 255));
-        usb.sendData(moveCmd);
+        command = makeCommand(PACKET_TURN, (int) (turnSpeed * 255));
+        sprintf(command.ascii, "t,%d\n", command.value);
     } else {
-        sprintf(moveCmd, "s\n");
-        usb.sendData(moveCmd);
+        command = makeCommand(PACKET_STOP, 0);
+        sprintf(command.ascii, "s\n");
     }
-    
-    memset(&moveCmd, '\0', sizeof (moveCmd));
+
+    // Only the newest motion command is kept until the writer thread sends it
+    commandScheduler.submit(CommandScheduler::MOTION, command);
 }
 
 // The finger and wrist handlers receive gripper angle commands in floating point
 // radians, write them to a string and send that to the arduino
 // for processing.
 void fingerAngleHandler(const std_msgs::Float32::ConstPtr& angle) {
-  char cmd[16]={'\0'};
+  OutboundCommand command = makeCommand(PACKET_FINGER, (int) (angle->data * 1000));
 
   // Avoid dealing with negative exponents which confuse the conversion to string by checking if the angle is small
   if (angle->data < 0.01) {
     // 'f' indicates this is a finger command to the arduino
-    sprintf(cmd, "f,0\n");
+    sprintf(command.ascii, "f,0\n");
   } else {
-    sprintf(cmd, "f,%.4g\n", angle->data);
+    sprintf(command.ascii, "f,%.4g\n", angle->data);
   }
-  usb.sendData(cmd);
-  memset(&cmd, '\0', sizeof (cmd));
+  commandScheduler.submit(CommandScheduler::FINGER, command);
 }
 
 void wristAngleHandler(const std_msgs::Float32::ConstPtr& angle) {
-    char cmd[16]={'\0'};
+    OutboundCommand command = makeCommand(PACKET_WRIST, (int) (angle->data * 1000));
 
     // Avoid dealing with negative exponents which confuse the conversion to string by checking if the angle is small
   if (angle->data < 0.01) {
     // 'w' indicates this is a wrist command to the arduino
-    sprintf(cmd, "w,0\n");
+    sprintf(command.ascii, "w,0\n");
   } else {
-    sprintf(cmd, "w,%.4g\n", angle->data);
+    sprintf(command.ascii, "w,%.4g\n", angle->data);
   }
-  usb.sendData(cmd);
-  memset(&cmd, '\0', sizeof (cmd));
+  commandScheduler.submit(CommandScheduler::WRIST, command);
+}
+
+// The trace of a velocity command travels on its own topic, so it can arrive
+// either side of the command. Completes it with the command's arrival time.
+void velocityTraceHandler(const std_msgs::Float64MultiArray::ConstPtr& trace) {
+    if (trace->data.size() != TRACE_COMMAND_RECEIVED) {
+        return;
+    }
+
+    if (lastVelocityReceived.toSec() >= trace->data[TRACE_VELOCITY_PUBLISHED]) {
+        recordTrace(*trace, lastVelocityReceived);
+    } else {
+        pendingTrace = trace;
+    }
+}
+
+void recordTrace(const std_msgs::Float64MultiArray& trace, ros::Time commandReceived) {
+    TraceRecord record;
+    for (int i = 0; i < TRACE_COMMAND_RECEIVED; i++) {
+        record.times[i] = trace.data[i];
+    }
+    record.times[TRACE_COMMAND_RECEIVED] = commandReceived.toSec();
+    latencyTrace.record(record);
+}
+
+// Logs where the time goes between a sonar reading and the velocity command it
+// caused, over the traces still in the ring, and writes them to trace_file
+void traceDumpHandler(const std_msgs::Empty::ConstPtr& message) {
+    static const char* stageNames[TRACE_FIELD_COUNT - 1] = {
+        "serial and sonar fusion", "obstacle detection", "obstacle to mobility", "mobility", "velocity to abridge"
+    };
+
+    vector<TraceRecord> records;
+    latencyTrace.snapshot(records);
+    ROS_INFO("Latency trace: %lu traces in the ring, %lu recorded", (unsigned long) records.size(), latencyTrace.recorded());
+
+    for (int i = 0; i < TRACE_FIELD_COUNT - 1; i++) {
+        TraceSummary summary = LatencyTrace::summarize(records, i, i + 1);
+        ROS_INFO("  %-24s median %6.1f ms, 95%% %6.1f ms, max %6.1f ms", stageNames[i], summary.median, summary.p95, summary.max);
+    }
+    TraceSummary total = LatencyTrace::summarize(records, TRACE_ORIGIN, TRACE_COMMAND_RECEIVED);
+    ROS_INFO("  %-24s median %6.1f ms, 95%% %6.1f ms, max %6.1f ms", "sonar to command", total.median, total.p95, total.max);
+
+    if (traceFile.empty()) {
+        return;
+    }
+    ofstream csv(traceFile.c_str());
+    csv << "origin,obstacle_received,obstacle_published,mobility_received,velocity_published,command_received" << endl;
+    csv.precision(6);
+    csv << fixed;
+    for (size_t i = 0; i < records.size(); i++) {
+        for (int j = 0; j < TRACE_FIELD_COUNT; j++) {
+            csv << (j ? "," : "") << records[i].times[j];
+        }
+        csv << endl;
+    }
+}
+
+// Starts a command for the Arduino. The caller fills in the ASCII form.
+OutboundCommand makeCommand(uint8_t packetType, int value) {
+    OutboundCommand command;
+    memset(command.ascii, '\0', sizeof (command.ascii));
+    command.packetType = packetType;
+    command.value = value;
+    return command;
 }
 
 void serialActivityTimer(const ros::TimerEvent& e) {
-    usb.sendData(dataCmd);
-    parseData(usb.readData());
-    publishRosTopics();
+    if (!portReady) {
+        return;
+    }
+
+    // Telemetry requests are paced by this timer already so skip the scheduler
+    OutboundCommand request = makeCommand(PACKET_REQUEST_TELEMETRY, 0);
+    sprintf(request.ascii, "d\n");
+    commandScheduler.sendNow(request);
+    metrics.requestSent();
+
+    // In stream mode the reply is picked up by serialReader as it arrives
+    if (serialMode == "poll") {
+        string data = usb.readData();
+        parseData(data.c_str(), data.size(), ros::Time::now());
+        publishRosTopics();
+    }
+}
+
+// Opening the port resets the Arduino. The binary protocol handshake only
+// succeeds once the firmware is running, the ASCII firmware is given a fixed
+// time to start. Commands received meanwhile wait in the scheduler's slots.
+void serialStartup(string devicePath) {
+    usb.openUSBPort(devicePath, baud, protocol == "binary");
+
+    if (!usb.usingBinaryProtocol()) {
+        for (int waited = 0; waited < arduinoBootTime && running; waited += 100) {
+            usleep(100000);
+        }
+    }
+    if (!running) {
+        return;
+    }
+
+    commandScheduler.start(commandRate);
+    portReady = true;
+
+    if (serialMode == "stream") {
+        serialReader();
+    }
+}
+
+// Waits on the serial port and publishes each telemetry frame as soon as its
+// last byte lands. Frames split across reads are reassembled before parsing.
+void serialReader() {
+    char bytes[128];
+
+    while (ros::ok() && running) {
+        if (!usb.waitForData(100)) {
+            continue;
+        }
+
+        // The closest we get to the time these bytes came off the wire
+        ros::Time receiveTime = ros::Time::now();
+
+        int bytesRead = usb.readAvailable(bytes, sizeof (bytes));
+        if (bytesRead <= 0) {
+            continue;
+        }
+
+        if (usb.usingBinaryProtocol()) {
+            readBinaryPackets(bytes, bytesRead, receiveTime);
+        } else {
+            readAsciiFrames(bytes, bytesRead, receiveTime);
+        }
+    }
+}
+
+void readAsciiFrames(const char* bytes, int length, ros::Time receiveTime) {
+    char frame[SerialFrameBuffer::capacity];
+    double firstByteTime;
+
+    frameBuffer.append(bytes, length, receiveTime.toSec());
+    while (frameBuffer.nextFrame(frame, sizeof (frame), &firstByteTime)) {
+        if (parseData(frame, strlen(frame), ros::Time(firstByteTime))) {
+            publishRosTopics();
+        }
+    }
+}
+
+void readBinaryPackets(const char* bytes, int length, ros::Time receiveTime) {
+    BinaryPacket packet;
+    unsigned long crcErrors = packetDecoder.crcErrors();
+
+    for (int i = 0; i < length; i++) {
+        if (packetDecoder.idle()) {
+            packetStartTime = receiveTime;
+        }
+        if (!packetDecoder.push((uint8_t) bytes[i], packet)) {
+            continue;
+        }
+        TelemetryFrame frame;
+        if (decodeBinaryTelemetry(packet, frame)) {
+            updateMessages(frame, packetStartTime);
+            publishRosTopics();
+        }
+    }
+
+    for (unsigned long i = crcErrors; i < packetDecoder.crcErrors(); i++) {
+        metrics.frameMalformed();
+    }
+    if (packetDecoder.crcErrors() != crcErrors) {
+        ROS_WARN_THROTTLE(10, "Dropped telemetry packet with bad CRC, %lu dropped so far", packetDecoder.crcErrors());
+    }
+}
+
+// Publishes the serial bridge counters for the diagnostics node, see
+// bridgeMetrics.h for the meaning of each value
+void statsTimer(const ros::TimerEvent& e) {
+    BridgeStats stats;
+    metrics.snapshot(usb.bytesRead(), usb.bytesWritten(), usb.bytesFlushed(),
+                     frameBuffer.discardedFrames(), commandScheduler.coalescedCommands(),
+                     commandScheduler.pendingCommands(), stats);
+
+    std_msgs::Float32MultiArray rosMsg;
+    rosMsg.data.assign(stats.values, stats.values + STAT_FIELD_COUNT);
+    statsPublish.publish(rosMsg);
 }
 
 void publishRosTopics() {
-    imuPublish.publish(imu);
-    odomPublish.publish(odom);
-    sonarLeftPublish.publish(sonarLeft);
-    sonarCenterPublish.publish(sonarCenter);
-    sonarRightPublish.publish(sonarRight);
-}
-
-void parseData(string str) {
-    istringstream oss(str);
-    string word;
-    while (getline(oss, word, delimiter)) {
-        dataSet.push_back(word);
-    }
-    if (dataSet.size() == 18) {
-        imu.header.stamp = ros::Time::now();
-        imu.linear_acceleration.x = atof(dataSet.at(0).c_str());
-        imu.linear_acceleration.y = atof(dataSet.at(1).c_str());
-        imu.linear_acceleration.z = atof(dataSet.at(2).c_str());
-        imu.angular_velocity.x = atof(dataSet.at(3).c_str());
-        imu.angular_velocity.y = atof(dataSet.at(4).c_str());
-        imu.angular_velocity.z = atof(dataSet.at(5).c_str());
-        imu.orientation = tf::createQuaternionMsgFromRollPitchYaw(atof(dataSet.at(6).c_str()), atof(dataSet.at(7).c_str()), atof(dataSet.at(8).c_str()));
-        
-        odom.header.stamp = ros::Time::now();
-        odom.pose.pose.position.x += atof(dataSet.at(9).c_str()) / 100.0;
-        odom.pose.pose.position.y += atof(dataSet.at(10).c_str()) / 100.0;
-        odom.pose.pose.position.z = 0.0;
-        odom.pose.pose.orientation = tf::createQuaternionMsgFromYaw(atof(dataSet.at(11).c_str()));
-        odom.twist.twist.linear.x = atof(dataSet.at(12).c_str()) / 100.0;
-        odom.twist.twist.linear.y = atof(dataSet.at(13).c_str()) / 100.0;
-        odom.twist.twist.angular.z = atof(dataSet.at(14).c_str());
-        
-        sonarLeft.range = atof(dataSet.at(15).c_str()) / 100.0;
-        sonarCenter.range = atof(dataSet.at(16).c_str()) / 100.0;
-        sonarRight.range = atof(dataSet.at(17).c_str()) / 100.0;
+    // Publish a consistent snapshot without holding the lock during publish.
+    // Each snapshot is a new message handed over by pointer, so subscribers in
+    // the same nodelet manager receive it without serialisation.
+    std::unique_lock<std::mutex> lock(telemetryMutex);
+    sensor_msgs::ImuPtr imuOut(new sensor_msgs::Imu(imu));
+    nav_msgs::OdometryPtr odomOut(new nav_msgs::Odometry(odom));
+    sensor_msgs::RangePtr sonarLeftOut(new sensor_msgs::Range(sonarLeft));
+    sensor_msgs::RangePtr sonarCenterOut(new sensor_msgs::Range(sonarCenter));
+    sensor_msgs::RangePtr sonarRightOut(new sensor_msgs::Range(sonarRight));
+    lock.unlock();
+
+    imuPublish.publish(imuOut);
+    odomPublish.publish(odomOut);
+    sonarLeftPublish.publish(sonarLeftOut);
+    sonarCenterPublish.publish(sonarCenterOut);
+    sonarRightPublish.publish(sonarRightOut);
+}
+
+bool parseData(const char* data, int length, ros::Time receiveTime) {
+    TelemetryFrame frame;
+    TelemetryParseResult result = parseTelemetryFrame(data, length, frame);
+    if (result != TELEMETRY_OK) {
+        malformedFrames++;
+        metrics.frameMalformed();
+        ROS_WARN_THROTTLE(10, "Dropped malformed telemetry frame (%s), %lu dropped so far", telemetryParseResultString(result), malformedFrames);
+        return false;
     }
-    
-    dataSet.clear();
+
+    return updateMessages(frame, receiveTime);
 }
+
+// Copies a telemetry frame into the ROS messages. Every message from one frame
+// gets the same stamp: the Arduino's own timestamp mapped onto the host clock
+// when the firmware sends one, otherwise the time the frame's first byte arrived.
+bool updateMessages(const TelemetryFrame& frame, ros::Time receiveTime) {
+    metrics.frameParsed();
+
+    std::lock_guard<std::mutex> lock(telemetryMutex);
+    telemetry = frame;
+    const float* value = telemetry.values;
+
+    ros::Time stamp = receiveTime;
+    if (frame.hasDeviceTime) {
+        stamp = ros::Time(arduinoClock.toHostTime(frame.deviceMillis, receiveTime.toSec()));
+    }
+
+    if (recordFile) {
+        fprintf(recordFile, "%.6f serial ", stamp.toSec());
+        for (int i = 0; i < TELEMETRY_FIELD_COUNT; i++) {
+            fprintf(recordFile, (i ? ",%g" : "%g"), value[i]);
+        }
+        if (frame.hasDeviceTime) {
+            fprintf(recordFile, ",%lu", frame.deviceMillis);
+        }
+        fputc('\n', recordFile);
+    }
+
+    imu.header.stamp = stamp;
+    imu.linear_acceleration.x = value[ACCEL_X];
+    imu.linear_acceleration.y = value[ACCEL_Y];
+    imu.linear_acceleration.z = value[ACCEL_Z];
+    imu.angular_velocity.x = value[GYRO_X];
+    imu.angular_velocity.y = value[GYRO_Y];
+    imu.angular_velocity.z = value[GYRO_Z];
+    imu.orientation = tf::createQuaternionMsgFromRollPitchYaw(value[ROLL], value[PITCH], value[YAW]);
+
+    odom.header.stamp = stamp;
+    odom.pose.pose.position.x += value[ODOM_DELTA_X] / 100.0;
+    odom.pose.pose.position.y += value[ODOM_DELTA_Y] / 100.0;
+    odom.pose.pose.position.z = 0.0;
+    odom.pose.pose.orientation = tf::createQuaternionMsgFromYaw(value[ODOM_YAW]);
+    odom.twist.twist.linear.x = value[ODOM_VELOCITY_X] / 100.0;
+    odom.twist.twist.linear.y = value[ODOM_VELOCITY_Y] / 100.0;
+    odom.twist.twist.angular.z = value[ODOM_ANGULAR_Z];
+
+    sonarLeft.header.stamp = stamp;
+    sonarLeft.range = value[SONAR_LEFT] / 100.0;
+    sonarCenter.header.stamp = stamp;
+    sonarCenter.range = value[SONAR_CENTER] / 100.0;
+    sonarRight.header.stamp = stamp;
+    sonarRight.range = value[SONAR_RIGHT] / 100.0;
+
+    return true;
+}
+
+} // namespace abridge
@@ -0,0 +1,31 @@
+#include <ros/ros.h>
+
+#include <abridgeNode.h>
+
+using namespace std;
+
+int main(int argc, char **argv) {
+    
+    char host[128];
+    gethostname(host, sizeof (host));
+    string hostname(host);
+    string publishedName;
+    ros::init(argc, argv, (hostname + "_ABRIDGE"));
+    
+    if (argc >= 2) {
+        publishedName = argv[1];
+        cout << "Welcome to the world of tomorrow " << publishedName << "!  ABridge module started." << endl;
+    } else {
+        publishedName = hostname;
+        cout << "No Name Selected. Default is: " << publishedName << endl;
+    }
+    
+    ros::NodeHandle aNH;
+    ros::NodeHandle param("~");
+
+    abridge::start(aNH, param, publishedName);
+    ros::waitForShutdown();
+    abridge::stop();
+    
+    return EXIT_SUCCESS;
+}
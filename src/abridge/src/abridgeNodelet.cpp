@@ -0,0 +1,40 @@
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+
+#include <abridgeNode.h>
+
+using namespace std;
+
+namespace abridge {
+
+// Runs the Arduino bridge inside a nodelet manager so the sonar, imu and odom
+// messages reach obstacle_detection and the navigation nodes in the same
+// manager as shared pointers. The rover name is the first nodelet argument,
+// or the hostname.
+class ABridgeNodelet : public nodelet::Nodelet {
+public:
+
+    ~ABridgeNodelet() {
+        stop();
+    }
+
+private:
+
+    virtual void onInit() {
+        string publishedName;
+        if (!getMyArgv().empty()) {
+            publishedName = getMyArgv()[0];
+        } else {
+            char host[128];
+            gethostname(host, sizeof (host));
+            publishedName = host;
+        }
+        NODELET_INFO("ABridge nodelet started for %s", publishedName.c_str());
+
+        start(getNodeHandle(), getPrivateNodeHandle(), publishedName);
+    }
+};
+
+}
+
+PLUGINLIB_EXPORT_CLASS(abridge::ABridgeNodelet, nodelet::Nodelet)
@@ -0,0 +1,162 @@
+#include "binaryProtocol.h"
+
+#include <stddef.h>
+
+// Fixed point scale of each telemetry field, chosen so the largest value the
+// rover can report still fits in an int16 with as much precision as possible.
+static const float telemetryScale[TELEMETRY_FIELD_COUNT] = {
+    1000.0f, 1000.0f, 1000.0f,   // accel, +-32
+    1000.0f, 1000.0f, 1000.0f,   // gyro, +-32
+    10000.0f, 10000.0f, 10000.0f, // roll, pitch, yaw, +-pi
+    100.0f, 100.0f,              // odom delta, +-327 cm
+    10000.0f,                    // odom yaw, +-pi
+    100.0f, 100.0f,              // odom velocity, +-327 cm/s
+    1000.0f,                     // odom angular velocity, +-32 rad/s
+    10.0f, 10.0f, 10.0f          // sonar, +-3276 cm
+};
+
+uint16_t binaryCrc16(const uint8_t* data, int length) {
+    uint16_t crc = 0xFFFF;
+    for (int i = 0; i < length; i++) {
+        crc ^= (uint16_t) data[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+int encodeBinaryPacket(uint8_t type, const uint8_t* payload, int payloadLength, uint8_t* packet, int size) {
+    if (payloadLength < 0 || payloadLength > binaryMaxPayload || size < payloadLength + binaryPacketOverhead) {
+        return 0;
+    }
+
+    packet[0] = binarySyncByte;
+    packet[1] = payloadLength;
+    packet[2] = type;
+    for (int i = 0; i < payloadLength; i++) {
+        packet[3 + i] = payload[i];
+    }
+
+    uint16_t crc = binaryCrc16(&packet[1], payloadLength + 2);
+    packet[3 + payloadLength] = crc & 0xFF;
+    packet[4 + payloadLength] = crc >> 8;
+
+    return payloadLength + binaryPacketOverhead;
+}
+
+int encodeBinaryCommand(uint8_t type, uint8_t* packet, int size) {
+    return encodeBinaryPacket(type, NULL, 0, packet, size);
+}
+
+int encodeBinaryCommand(uint8_t type, int16_t value, uint8_t* packet, int size) {
+    uint8_t payload[2] = { (uint8_t) (value & 0xFF), (uint8_t) ((uint16_t) value >> 8) };
+    return encodeBinaryPacket(type, payload, sizeof (payload), packet, size);
+}
+
+int encodeBinaryTelemetry(const TelemetryFrame& frame, uint8_t* packet, int size) {
+    uint8_t payload[TELEMETRY_FIELD_COUNT * 2 + 4];
+    int payloadLength = TELEMETRY_FIELD_COUNT * 2;
+    for (int i = 0; i < TELEMETRY_FIELD_COUNT; i++) {
+        float scaled = frame.values[i] * telemetryScale[i];
+        if (scaled > 32767.0f) scaled = 32767.0f;
+        if (scaled < -32768.0f) scaled = -32768.0f;
+        int16_t value = (int16_t) (scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+        payload[2 * i] = value & 0xFF;
+        payload[2 * i + 1] = (uint16_t) value >> 8;
+    }
+    if (frame.hasDeviceTime) {
+        uint32_t millis = frame.deviceMillis;
+        for (int i = 0; i < 4; i++) {
+            payload[payloadLength++] = (millis >> (8 * i)) & 0xFF;
+        }
+    }
+    return encodeBinaryPacket(PACKET_TELEMETRY, payload, payloadLength, packet, size);
+}
+
+bool decodeBinaryTelemetry(const BinaryPacket& packet, TelemetryFrame& frame) {
+    if (packet.type != PACKET_TELEMETRY ||
+        (packet.length != TELEMETRY_FIELD_COUNT * 2 && packet.length != TELEMETRY_FIELD_COUNT * 2 + 4)) {
+        return false;
+    }
+    for (int i = 0; i < TELEMETRY_FIELD_COUNT; i++) {
+        int16_t value = (int16_t) (packet.payload[2 * i] | (packet.payload[2 * i + 1] << 8));
+        frame.values[i] = value / telemetryScale[i];
+    }
+
+    frame.hasDeviceTime = (packet.length == TELEMETRY_FIELD_COUNT * 2 + 4);
+    if (frame.hasDeviceTime) {
+        const uint8_t* millis = &packet.payload[TELEMETRY_FIELD_COUNT * 2];
+        frame.deviceMillis = (uint32_t) millis[0] | ((uint32_t) millis[1] << 8) | ((uint32_t) millis[2] << 16) | ((uint32_t) millis[3] << 24);
+    }
+    return true;
+}
+
+BinaryPacketDecoder::BinaryPacketDecoder() : crcErrorCount(0) {
+    reset();
+}
+
+bool BinaryPacketDecoder::push(uint8_t byte, BinaryPacket& packet) {
+    switch (state) {
+        case WAIT_SYNC:
+            if (byte == binarySyncByte) {
+                state = READ_LENGTH;
+            }
+            return false;
+
+        case READ_LENGTH:
+            if (byte > binaryMaxPayload) {
+                // Can not be a real packet, look for the next sync byte
+                state = (byte == binarySyncByte) ? READ_LENGTH : WAIT_SYNC;
+                return false;
+            }
+            current.length = byte;
+            state = READ_TYPE;
+            return false;
+
+        case READ_TYPE:
+            current.type = byte;
+            payloadRead = 0;
+            state = (current.length > 0) ? READ_PAYLOAD : READ_CRC_LOW;
+            return false;
+
+        case READ_PAYLOAD:
+            current.payload[payloadRead++] = byte;
+            if (payloadRead == current.length) {
+                state = READ_CRC_LOW;
+            }
+            return false;
+
+        case READ_CRC_LOW:
+            receivedCrc = byte;
+            state = READ_CRC_HIGH;
+            return false;
+
+        case READ_CRC_HIGH:
+        {
+            receivedCrc |= (uint16_t) byte << 8;
+            state = WAIT_SYNC;
+
+            uint8_t checked[binaryMaxPayload + 2];
+            checked[0] = current.length;
+            checked[1] = current.type;
+            for (int i = 0; i < current.length; i++) {
+                checked[2 + i] = current.payload[i];
+            }
+            if (binaryCrc16(checked, current.length + 2) != receivedCrc) {
+                crcErrorCount++;
+                return false;
+            }
+
+            packet = current;
+            return true;
+        }
+    }
+    return false;
+}
+
+void BinaryPacketDecoder::reset() {
+    state = WAIT_SYNC;
+    payloadRead = 0;
+    receivedCrc = 0;
+}
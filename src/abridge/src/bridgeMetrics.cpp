@@ -0,0 +1,101 @@
+#include "bridgeMetrics.h"
+
+#include <algorithm>
+
+using namespace std;
+
+BridgeMetrics::BridgeMetrics() :
+    intervalStart(chrono::steady_clock::now()),
+    requestOutstanding(false),
+    framesOk(0),
+    framesMalformed(0),
+    latencySampleCount(0),
+    lastBytesRead(0),
+    lastBytesWritten(0),
+    lastBytesFlushed(0),
+    lastPartialFrames(0),
+    lastCoalescedCommands(0) {
+    for (int i = 0; i < latencyBinCount; i++) {
+        histogram[i] = 0;
+    }
+}
+
+void BridgeMetrics::requestSent() {
+    lock_guard<mutex> lock(metricsMutex);
+    lastRequest = chrono::steady_clock::now();
+    requestOutstanding = true;
+}
+
+void BridgeMetrics::frameParsed() {
+    lock_guard<mutex> lock(metricsMutex);
+    framesOk++;
+
+    // Only the first frame after a request measures the round trip
+    if (!requestOutstanding) {
+        return;
+    }
+    requestOutstanding = false;
+
+    float latency = chrono::duration<float, milli>(chrono::steady_clock::now() - lastRequest).count();
+
+    int bin = 0;
+    while (bin < latencyBinCount - 1 && latency > latencyBinEdges[bin]) {
+        bin++;
+    }
+    histogram[bin]++;
+
+    if (latencySampleCount < maxLatencySamples) {
+        latencySamples[latencySampleCount++] = latency;
+    }
+}
+
+void BridgeMetrics::frameMalformed() {
+    lock_guard<mutex> lock(metricsMutex);
+    framesMalformed++;
+}
+
+void BridgeMetrics::snapshot(unsigned long bytesRead, unsigned long bytesWritten, unsigned long bytesFlushed,
+                             unsigned long partialFrames, unsigned long coalescedCommands, int pendingCommands,
+                             BridgeStats& stats) {
+    lock_guard<mutex> lock(metricsMutex);
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+
+    float* value = stats.values;
+    value[STAT_INTERVAL] = chrono::duration<float>(now - intervalStart).count();
+    value[STAT_FRAMES_OK] = framesOk;
+    value[STAT_FRAMES_MALFORMED] = framesMalformed;
+    value[STAT_FRAMES_PARTIAL] = partialFrames - lastPartialFrames;
+    value[STAT_BYTES_READ] = bytesRead - lastBytesRead;
+    value[STAT_BYTES_WRITTEN] = bytesWritten - lastBytesWritten;
+    value[STAT_BYTES_FLUSHED] = bytesFlushed - lastBytesFlushed;
+    value[STAT_COMMANDS_PENDING] = pendingCommands;
+    value[STAT_COMMANDS_COALESCED] = coalescedCommands - lastCoalescedCommands;
+
+    if (latencySampleCount > 0) {
+        float* samplesEnd = latencySamples + latencySampleCount;
+        nth_element(latencySamples, latencySamples + latencySampleCount / 2, samplesEnd);
+        value[STAT_LATENCY_P50] = latencySamples[latencySampleCount / 2];
+        nth_element(latencySamples, latencySamples + (latencySampleCount * 95) / 100, samplesEnd);
+        value[STAT_LATENCY_P95] = latencySamples[(latencySampleCount * 95) / 100];
+        value[STAT_LATENCY_MAX] = *max_element(latencySamples, samplesEnd);
+    } else {
+        value[STAT_LATENCY_P50] = 0;
+        value[STAT_LATENCY_P95] = 0;
+        value[STAT_LATENCY_MAX] = 0;
+    }
+
+    for (int i = 0; i < latencyBinCount; i++) {
+        value[STAT_LATENCY_HISTOGRAM + i] = histogram[i];
+        histogram[i] = 0;
+    }
+
+    intervalStart = now;
+    framesOk = 0;
+    framesMalformed = 0;
+    latencySampleCount = 0;
+    lastBytesRead = bytesRead;
+    lastBytesWritten = bytesWritten;
+    lastBytesFlushed = bytesFlushed;
+    lastPartialFrames = partialFrames;
+    lastCoalescedCommands = coalescedCommands;
+}
@@ -0,0 +1,127 @@
+#include "commandScheduler.h"
+
+#include <binaryProtocol.h>
+
+using namespace std;
+
+CommandScheduler::CommandScheduler(USBSerial& usb) : usb(usb), coalesced(0), running(false) {
+    for (int i = 0; i < SLOT_COUNT; i++) {
+        pending[i] = false;
+    }
+}
+
+CommandScheduler::~CommandScheduler() {
+    stop();
+}
+
+void CommandScheduler::start(double rateHz) {
+    if (running) {
+        return;
+    }
+    if (rateHz <= 0.0) {
+        rateHz = 20.0;
+    }
+    period = chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(1.0 / rateHz));
+    running = true;
+    writerThread = thread(&CommandScheduler::writerLoop, this);
+}
+
+void CommandScheduler::stop() {
+    {
+        lock_guard<mutex> lock(slotMutex);
+        running = false;
+    }
+    slotUpdated.notify_all();
+    if (writerThread.joinable()) {
+        writerThread.join();
+    }
+}
+
+void CommandScheduler::submit(Slot slot, const OutboundCommand& command) {
+    {
+        lock_guard<mutex> lock(slotMutex);
+        if (pending[slot]) {
+            coalesced++;
+        }
+        slots[slot] = command;
+        pending[slot] = true;
+    }
+    slotUpdated.notify_one();
+}
+
+void CommandScheduler::sendNow(const OutboundCommand& command) {
+    if (!usb.usingBinaryProtocol()) {
+        char ascii[sizeof (command.ascii)];
+        memcpy(ascii, command.ascii, sizeof (ascii));
+        usb.sendData(ascii);
+        return;
+    }
+
+    uint8_t packet[binaryMaxPacket];
+    int length;
+    if (command.packetType == PACKET_STOP || command.packetType == PACKET_REQUEST_TELEMETRY) {
+        length = encodeBinaryCommand(command.packetType, packet, sizeof (packet));
+    } else {
+        length = encodeBinaryCommand(command.packetType, (int16_t) command.value, packet, sizeof (packet));
+    }
+    usb.sendBytes(packet, length);
+}
+
+unsigned long CommandScheduler::coalescedCommands() {
+    lock_guard<mutex> lock(slotMutex);
+    return coalesced;
+}
+
+int CommandScheduler::pendingCommands() {
+    lock_guard<mutex> lock(slotMutex);
+    int count = 0;
+    for (int i = 0; i < SLOT_COUNT; i++) {
+        if (pending[i]) {
+            count++;
+        }
+    }
+    return count;
+}
+
+void CommandScheduler::writerLoop() {
+    chrono::steady_clock::time_point lastFlush = chrono::steady_clock::now() - period;
+    OutboundCommand toSend[SLOT_COUNT];
+    bool send[SLOT_COUNT];
+
+    unique_lock<mutex> lock(slotMutex);
+    while (running) {
+        // Sleep until something is waiting to go out
+        bool anyPending = false;
+        for (int i = 0; i < SLOT_COUNT; i++) {
+            anyPending = anyPending || pending[i];
+        }
+        if (!anyPending) {
+            slotUpdated.wait(lock);
+            continue;
+        }
+
+        // Hold off until a full period has passed since the last flush.
+        // Commands submitted meanwhile overwrite their slot.
+        chrono::steady_clock::time_point nextFlush = lastFlush + period;
+        if (chrono::steady_clock::now() < nextFlush) {
+            slotUpdated.wait_until(lock, nextFlush);
+            continue;
+        }
+
+        for (int i = 0; i < SLOT_COUNT; i++) {
+            send[i] = pending[i];
+            toSend[i] = slots[i];
+            pending[i] = false;
+        }
+        lastFlush = chrono::steady_clock::now();
+
+        // Write without holding the lock so submit never waits on the port
+        lock.unlock();
+        for (int i = 0; i < SLOT_COUNT; i++) {
+            if (send[i]) {
+                sendNow(toSend[i]);
+            }
+        }
+        lock.lock();
+    }
+}
@@ -0,0 +1,37 @@
+#include "deviceClock.h"
+
+DeviceClock::DeviceClock() {
+    reset();
+}
+
+double DeviceClock::toHostTime(unsigned long deviceMillis, double receiveTime) {
+    // millis() going backwards means the Arduino restarted or the counter
+    // wrapped, the old offsets no longer apply
+    if (offsetCount > 0 && deviceMillis < lastMillis) {
+        reset();
+    }
+    lastMillis = deviceMillis;
+
+    double deviceTime = deviceMillis / 1000.0;
+    offsets[nextOffset] = receiveTime - deviceTime;
+    nextOffset = (nextOffset + 1) % windowSize;
+    if (offsetCount < windowSize) {
+        offsetCount++;
+    }
+
+    double offset = offsets[0];
+    for (int i = 1; i < offsetCount; i++) {
+        if (offsets[i] < offset) {
+            offset = offsets[i];
+        }
+    }
+
+    double hostTime = deviceTime + offset;
+    return hostTime < receiveTime ? hostTime : receiveTime;
+}
+
+void DeviceClock::reset() {
+    offsetCount = 0;
+    nextOffset = 0;
+    lastMillis = 0;
+}
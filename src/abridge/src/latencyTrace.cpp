@@ -0,0 +1,76 @@
+#include "latencyTrace.h"
+
+#include <algorithm>
+
+using namespace std;
+
+LatencyTrace::LatencyTrace() : head(0) {
+    for (int i = 0; i < capacity; i++) {
+        slots[i].sequence.store(0, memory_order_relaxed);
+        for (int j = 0; j < TRACE_FIELD_COUNT; j++) {
+            slots[i].times[j].store(0.0, memory_order_relaxed);
+        }
+    }
+}
+
+void LatencyTrace::record(const TraceRecord& record) {
+    unsigned long index = head.load(memory_order_relaxed);
+    Slot& slot = slots[index % capacity];
+
+    slot.sequence.store(2 * index + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    for (int i = 0; i < TRACE_FIELD_COUNT; i++) {
+        slot.times[i].store(record.times[i], memory_order_relaxed);
+    }
+    slot.sequence.store(2 * index + 2, memory_order_release);
+
+    head.store(index + 1, memory_order_release);
+}
+
+void LatencyTrace::snapshot(vector<TraceRecord>& records) const {
+    records.clear();
+
+    unsigned long end = head.load(memory_order_acquire);
+    unsigned long begin = (end > (unsigned long) capacity) ? end - capacity : 0;
+
+    for (unsigned long index = begin; index < end; index++) {
+        const Slot& slot = slots[index % capacity];
+
+        unsigned long before = slot.sequence.load(memory_order_acquire);
+        TraceRecord record;
+        for (int i = 0; i < TRACE_FIELD_COUNT; i++) {
+            record.times[i] = slot.times[i].load(memory_order_relaxed);
+        }
+        atomic_thread_fence(memory_order_acquire);
+        unsigned long after = slot.sequence.load(memory_order_relaxed);
+
+        // Overwritten by a newer record while copying, or not finished yet
+        if (before != 2 * index + 2 || after != before) {
+            continue;
+        }
+        records.push_back(record);
+    }
+}
+
+TraceSummary LatencyTrace::summarize(const vector<TraceRecord>& records, int from, int to) {
+    vector<double> latencies;
+    for (size_t i = 0; i < records.size(); i++) {
+        double latency = (records[i].times[to] - records[i].times[from]) * 1000.0;
+        if (latency >= 0.0) {
+            latencies.push_back(latency);
+        }
+    }
+
+    TraceSummary summary;
+    summary.count = latencies.size();
+    summary.median = summary.p95 = summary.max = 0.0;
+    if (latencies.empty()) {
+        return summary;
+    }
+
+    sort(latencies.begin(), latencies.end());
+    summary.median = latencies[latencies.size() / 2];
+    summary.p95 = latencies[min(latencies.size() - 1, (size_t) (0.95 * latencies.size()))];
+    summary.max = latencies.back();
+    return summary;
+}
@@ -0,0 +1,150 @@
+#include "serialFrameBuffer.h"
+
+#include <string.h>
+
+SerialFrameBuffer::SerialFrameBuffer() : discarded(0) {
+    clear();
+}
+
+bool SerialFrameBuffer::append(const char* data, int length, double receiveTime) {
+    bool overflowed = false;
+
+    // Keep only the newest bytes if more arrived than the buffer can ever hold
+    if (length > capacity) {
+        data += length - capacity;
+        appended += length - capacity;
+        length = capacity;
+        overflowed = true;
+        atFrameStart = false;
+    }
+
+    // Make room by dropping the oldest bytes. The frame they belonged to is
+    // now incomplete so it is skipped once its newline shows up.
+    int overflow = count + length - capacity;
+    if (overflow > 0) {
+        head = (head + overflow) % capacity;
+        count -= overflow;
+        scanned = 0;
+        overflowed = true;
+    }
+
+    if (overflowed) {
+        discardUntilNewline = true;
+    }
+
+    int tail = (head + count) % capacity;
+    int firstChunk = capacity - tail;
+    if (firstChunk > length) {
+        firstChunk = length;
+    }
+    memcpy(&buffer[tail], data, firstChunk);
+    memcpy(&buffer[0], data + firstChunk, length - firstChunk);
+    count += length;
+
+    // Remember when each frame that starts in this chunk arrived
+    for (int i = 0; i < length; i++) {
+        if (atFrameStart) {
+            if (arrivalCount == maxArrivals) {
+                arrivalHead = (arrivalHead + 1) % maxArrivals;
+                arrivalCount--;
+            }
+            Arrival& arrival = arrivals[(arrivalHead + arrivalCount) % maxArrivals];
+            arrival.position = appended + i;
+            arrival.time = receiveTime;
+            arrivalCount++;
+        }
+        atFrameStart = (data[i] == '\n');
+    }
+    appended += length;
+    dropArrivalsBefore(appended - count);
+
+    return !overflowed;
+}
+
+bool SerialFrameBuffer::nextFrame(char* frame, int size, double* firstByteTime) {
+    while (scanned < count) {
+        if (buffer[(head + scanned) % capacity] != '\n') {
+            scanned++;
+            continue;
+        }
+
+        int frameLength = scanned;
+        bool truncated = false;
+
+        // Strip a trailing carriage return
+        if (frameLength > 0 && buffer[(head + frameLength - 1) % capacity] == '\r') {
+            frameLength--;
+        }
+
+        if (frameLength > size - 1) {
+            truncated = true;
+        } else {
+            for (int i = 0; i < frameLength; i++) {
+                frame[i] = buffer[(head + i) % capacity];
+            }
+            frame[frameLength] = '\0';
+        }
+
+        double frameTime = arrivalTime(appended - count);
+
+        // Consume the frame and its newline
+        head = (head + scanned + 1) % capacity;
+        count -= scanned + 1;
+        scanned = 0;
+
+        if (discardUntilNewline) {
+            discardUntilNewline = false;
+            discarded++;
+            continue;
+        }
+
+        if (truncated) {
+            discarded++;
+            continue;
+        }
+
+        if (frameLength == 0) {
+            continue;
+        }
+
+        dropArrivalsBefore(appended - count);
+        if (firstByteTime != NULL) {
+            *firstByteTime = frameTime;
+        }
+        return true;
+    }
+
+    return false;
+}
+
+void SerialFrameBuffer::clear() {
+    head = 0;
+    count = 0;
+    scanned = 0;
+    discardUntilNewline = false;
+    arrivalHead = 0;
+    arrivalCount = 0;
+    appended = 0;
+    atFrameStart = true;
+}
+
+double SerialFrameBuffer::arrivalTime(unsigned long long position) const {
+    // The newest frame start at or before position
+    double time = (arrivalCount > 0) ? arrivals[arrivalHead].time : 0.0;
+    for (int i = 0; i < arrivalCount; i++) {
+        const Arrival& arrival = arrivals[(arrivalHead + i) % maxArrivals];
+        if (arrival.position > position) {
+            break;
+        }
+        time = arrival.time;
+    }
+    return time;
+}
+
+// Forgets frame starts that lie before position, keeping the newest of them
+void SerialFrameBuffer::dropArrivalsBefore(unsigned long long position) {
+    while (arrivalCount > 1 && arrivals[(arrivalHead + 1) % maxArrivals].position <= position) {
+        arrivalHead = (arrivalHead + 1) % maxArrivals;
+        arrivalCount--;
+    }
+}
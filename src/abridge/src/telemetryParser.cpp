@@ -0,0 +1,163 @@
+#include "telemetryParser.h"
+
+// Powers of ten used to place the decimal point without calling pow()
+static const double powersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+    1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18
+};
+static const int maxPowerOfTen = 18;
+
+static double scaleByPowerOfTen(double value, int exponent) {
+    while (exponent > maxPowerOfTen) {
+        value *= powersOfTen[maxPowerOfTen];
+        exponent -= maxPowerOfTen;
+    }
+    while (exponent < -maxPowerOfTen) {
+        value /= powersOfTen[maxPowerOfTen];
+        exponent += maxPowerOfTen;
+    }
+    return exponent >= 0 ? value * powersOfTen[exponent] : value / powersOfTen[-exponent];
+}
+
+static bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// Converts the number in [begin, end) to a float. Accepts the formats printed
+// by the Arduino: optional sign, digits, optional fraction and exponent.
+// Surrounding whitespace is ignored. Returns false if anything else is found.
+static bool parseNumber(const char* begin, const char* end, float& value) {
+    while (begin < end && isSpace(*begin)) begin++;
+    while (end > begin && isSpace(*(end - 1))) end--;
+
+    const char* p = begin;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        p++;
+    }
+
+    double mantissa = 0.0;
+    int exponent = 0;
+    int digits = 0;
+
+    while (p < end && *p >= '0' && *p <= '9') {
+        mantissa = mantissa * 10.0 + (*p - '0');
+        digits++;
+        p++;
+    }
+
+    if (p < end && *p == '.') {
+        p++;
+        while (p < end && *p >= '0' && *p <= '9') {
+            mantissa = mantissa * 10.0 + (*p - '0');
+            exponent--;
+            digits++;
+            p++;
+        }
+    }
+
+    if (digits == 0) {
+        return false;
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        bool negativeExponent = false;
+        if (p < end && (*p == '-' || *p == '+')) {
+            negativeExponent = (*p == '-');
+            p++;
+        }
+
+        int explicitExponent = 0;
+        int exponentDigits = 0;
+        while (p < end && *p >= '0' && *p <= '9') {
+            if (explicitExponent < 1000) {
+                explicitExponent = explicitExponent * 10 + (*p - '0');
+            }
+            exponentDigits++;
+            p++;
+        }
+
+        if (exponentDigits == 0) {
+            return false;
+        }
+        exponent += negativeExponent ? -explicitExponent : explicitExponent;
+    }
+
+    if (p != end) {
+        return false;
+    }
+
+    double result = scaleByPowerOfTen(mantissa, exponent);
+    value = static_cast<float>(negative ? -result : result);
+    return true;
+}
+
+// Converts the unsigned integer in [begin, end) ignoring surrounding whitespace
+static bool parseMillis(const char* begin, const char* end, unsigned long& value) {
+    while (begin < end && isSpace(*begin)) begin++;
+    while (end > begin && isSpace(*(end - 1))) end--;
+    if (begin == end) {
+        return false;
+    }
+
+    unsigned long result = 0;
+    for (const char* p = begin; p < end; p++) {
+        if (*p < '0' || *p > '9') {
+            return false;
+        }
+        result = result * 10 + (*p - '0');
+    }
+    value = result;
+    return true;
+}
+
+TelemetryParseResult parseTelemetryFrame(const char* data, int length, TelemetryFrame& frame) {
+    const char* end = data + length;
+    const char* fieldStart = data;
+    int field = 0;
+    frame.hasDeviceTime = false;
+
+    for (const char* p = data; ; p++) {
+        if (p != end && *p != ',') {
+            continue;
+        }
+
+        if (field > TELEMETRY_FIELD_COUNT) {
+            return TELEMETRY_TOO_MANY_FIELDS;
+        }
+
+        if (field == TELEMETRY_FIELD_COUNT) {
+            // Optional Arduino timestamp
+            if (!parseMillis(fieldStart, p, frame.deviceMillis)) {
+                return TELEMETRY_BAD_NUMBER;
+            }
+            frame.hasDeviceTime = true;
+        } else if (!parseNumber(fieldStart, p, frame.values[field])) {
+            return TELEMETRY_BAD_NUMBER;
+        }
+        field++;
+
+        if (p == end) {
+            break;
+        }
+        fieldStart = p + 1;
+    }
+
+    if (field < TELEMETRY_FIELD_COUNT) {
+        return TELEMETRY_TOO_FEW_FIELDS;
+    }
+
+    return TELEMETRY_OK;
+}
+
+const char* telemetryParseResultString(TelemetryParseResult result) {
+    switch (result) {
+        case TELEMETRY_OK: return "ok";
+        case TELEMETRY_TOO_FEW_FIELDS: return "too few fields";
+        case TELEMETRY_TOO_MANY_FIELDS: return "too many fields";
+        case TELEMETRY_BAD_NUMBER: return "malformed number";
+    }
+    return "unknown";
+}
@@ -0,0 +1,103 @@
+// Microbenchmark comparing the in place telemetry parser against the original
+// istringstream/vector<string>/atof implementation of abridge's parseData.
+// Run with an optional iteration count: abridge_parser_benchmark [iterations]
+
+#include <telemetryParser.h>
+#include <binaryProtocol.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// The parsing half of the original parseData, kept here as the baseline.
+// The ROS message assignments are left out since both versions share them.
+static bool legacyParse(const string& str, TelemetryFrame& frame) {
+    vector<string> dataSet;
+    istringstream oss(str);
+    string word;
+    while (getline(oss, word, ',')) {
+        dataSet.push_back(word);
+    }
+    if (dataSet.size() != TELEMETRY_FIELD_COUNT) {
+        return false;
+    }
+    for (int i = 0; i < TELEMETRY_FIELD_COUNT; i++) {
+        frame.values[i] = atof(dataSet.at(i).c_str());
+    }
+    return true;
+}
+
+// Representative frames in the format printed by the Arduino
+static const char* sampleFrames[] = {
+    "0.03,-0.12,9.81,0.001,-0.002,0.015,0.0123,-0.0045,1.5708,1.25,-0.5,1.5708,12.5,-5.0,0.015,300,287,301",
+    "-0.15,0.22,9.79,0.012,0.004,-0.231,0.0201,0.0033,-2.9012,0.00,0.00,-2.9012,0.0,0.0,-0.231,45,30,300",
+    "1.02,0.98,9.62,-0.110,0.087,0.501,-0.0312,0.0421,0.7854,3.75,3.75,0.7854,37.5,37.5,0.501,120,95,88"
+};
+static const int sampleFrameCount = sizeof (sampleFrames) / sizeof (sampleFrames[0]);
+
+int main(int argc, char** argv) {
+    long iterations = (argc >= 2) ? atol(argv[1]) : 200000;
+
+    vector<string> frames;
+    for (int i = 0; i < sampleFrameCount; i++) {
+        frames.push_back(sampleFrames[i]);
+    }
+
+    // Check both parsers agree before timing them
+    for (int i = 0; i < sampleFrameCount; i++) {
+        TelemetryFrame expected, actual;
+        if (!legacyParse(frames[i], expected) ||
+            parseTelemetryFrame(frames[i].c_str(), frames[i].size(), actual) != TELEMETRY_OK) {
+            printf("Sample frame %d failed to parse\n", i);
+            return EXIT_FAILURE;
+        }
+        for (int field = 0; field < TELEMETRY_FIELD_COUNT; field++) {
+            if (fabs(expected.values[field] - actual.values[field]) > 1e-5 * (1.0 + fabs(expected.values[field]))) {
+                printf("Frame %d field %d differs: %g vs %g\n", i, field, expected.values[field], actual.values[field]);
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    TelemetryFrame frame;
+    float checksum = 0.0f; // keeps the optimizer from discarding the work
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (long i = 0; i < iterations; i++) {
+        legacyParse(frames[i % sampleFrameCount], frame);
+        checksum += frame.values[SONAR_LEFT];
+    }
+    chrono::steady_clock::time_point middle = chrono::steady_clock::now();
+    for (long i = 0; i < iterations; i++) {
+        const string& data = frames[i % sampleFrameCount];
+        parseTelemetryFrame(data.c_str(), data.size(), frame);
+        checksum += frame.values[SONAR_LEFT];
+    }
+    chrono::steady_clock::time_point end = chrono::steady_clock::now();
+
+    double legacyNs = chrono::duration_cast<chrono::nanoseconds>(middle - start).count() / (double) iterations;
+    double inPlaceNs = chrono::duration_cast<chrono::nanoseconds>(end - middle).count() / (double) iterations;
+
+    printf("Parsed %ld frames with each parser (checksum %g)\n", iterations, checksum);
+    printf("  legacy parseData: %10.1f ns/frame\n", legacyNs);
+    printf("  in place parser:  %10.1f ns/frame\n", inPlaceNs);
+    printf("  speedup:          %10.1fx\n", legacyNs / inPlaceNs);
+
+    // Bytes on the wire per telemetry frame for each serial protocol
+    uint8_t packet[binaryMaxPacket];
+    size_t asciiBytes = 0;
+    for (int i = 0; i < sampleFrameCount; i++) {
+        asciiBytes += frames[i].size() + 1; // newline
+    }
+    parseTelemetryFrame(frames[0].c_str(), frames[0].size(), frame);
+    int binaryBytes = encodeBinaryTelemetry(frame, packet, sizeof (packet));
+    printf("Wire size per frame: ascii %.1f bytes, binary %d bytes\n", asciiBytes / (double) sampleFrameCount, binaryBytes);
+
+    return EXIT_SUCCESS;
+}
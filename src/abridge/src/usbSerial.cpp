@@ -2,11 +2,15 @@
 
 using namespace std;
 
-USBSerial::USBSerial() {
+// How long a write waits for the Arduino to drain its buffer before the rest
+// of it is dropped
+static const int writeTimeoutMs = 100;
+
+USBSerial::USBSerial() : usbFileDescriptor(-1), binaryMode(false), bytesReadCount(0), bytesWrittenCount(0), bytesFlushedCount(0) {
 
 }
 
-void USBSerial::openUSBPort(string devicePath, int baud) {
+void USBSerial::openUSBPort(string devicePath, int baud, bool tryBinary) {
     memset(&ioStruct, 0, sizeof (ioStruct));
     ioStruct.c_iflag = 0;
     ioStruct.c_oflag = 0;
@@ -23,26 +27,141 @@ void USBSerial::openUSBPort(string devicePath, int baud) {
     cfsetospeed(&ioStruct, B115200);
     cfsetispeed(&ioStruct, B115200);
     tcsetattr(usbFileDescriptor, TCSANOW, &ioStruct);
+
+    binaryMode = false;
+    if (tryBinary) {
+        // Opening the port resets the Arduino, so keep offering for long
+        // enough to cover the bootloader
+        binaryMode = negotiateBinaryProtocol(4000);
+        cout << "Serial protocol: " << (binaryMode ? "binary" : "ASCII") << endl;
+    }
 }
 
 void USBSerial::sendData(char data[]) {
-    sprintf(dataOut, "%s", data);
-    write(usbFileDescriptor, dataOut, sizeof (dataOut));
-    memset(&dataOut, '\0', sizeof (dataOut));
+    // Only the string itself goes on the wire, not the rest of a fixed buffer
+    sendBytes((const uint8_t*) data, strlen(data));
+}
+
+bool USBSerial::sendBytes(const uint8_t* data, int length) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    while (length > 0) {
+        int written = write(usbFileDescriptor, data, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // The port is non-blocking, so wait for room instead of spinning
+            // with the lock held
+            if (errno == EAGAIN && waitForWritable(writeTimeoutMs)) {
+                continue;
+            }
+            bytesFlushedCount += length;
+            return false;
+        }
+        data += written;
+        length -= written;
+        bytesWrittenCount += written;
+    }
+    return true;
+}
+
+bool USBSerial::negotiateBinaryProtocol(int timeoutMs) {
+    uint8_t hello[binaryMaxPacket];
+    uint8_t version = binaryProtocolVersion;
+    int helloLength = encodeBinaryPacket(PACKET_HELLO, &version, 1, hello, sizeof (hello));
+    const int retryMs = 250;
+
+    BinaryPacketDecoder decoder;
+    BinaryPacket packet;
+    uint8_t bytes[64];
+
+    for (int elapsed = 0; elapsed < timeoutMs; elapsed += retryMs) {
+        sendBytes(hello, helloLength);
+
+        if (!waitForData(retryMs)) {
+            continue;
+        }
+
+        int bytesRead = readAvailable((char*) bytes, sizeof (bytes));
+        for (int i = 0; i < bytesRead; i++) {
+            if (decoder.push(bytes[i], packet) && packet.type == PACKET_HELLO_ACK &&
+                packet.length == 1 && packet.payload[0] == binaryProtocolVersion) {
+                tcflush(usbFileDescriptor, TCIFLUSH);
+                return true;
+            }
+        }
+    }
+
+    // End the line so ASCII firmware discards the hello bytes as one bad command
+    char newline[] = "\n";
+    sendData(newline);
+    tcflush(usbFileDescriptor, TCIFLUSH);
+    return false;
 }
 
 string USBSerial::readData() {
-    if (read(usbFileDescriptor, &serialDataIn, sizeof (serialDataIn)) > 0) {
-        read(usbFileDescriptor, &serialDataIn, sizeof (serialDataIn));
+    int bytes = read(usbFileDescriptor, &serialDataIn, sizeof (serialDataIn));
+    if (bytes > 0) {
+        bytesReadCount += bytes;
+        bytes = read(usbFileDescriptor, &serialDataIn, sizeof (serialDataIn));
+        if (bytes > 0) {
+            bytesReadCount += bytes;
+        }
     }
     string str(serialDataIn);
-    tcflush(usbFileDescriptor, TCIOFLUSH);
+
+    // Count what the flush is about to throw away. Only the input is flushed,
+    // commands written by the command scheduler may still be going out.
+    int pendingIn = 0;
+    if (ioctl(usbFileDescriptor, TIOCINQ, &pendingIn) == 0) {
+        bytesFlushedCount += pendingIn;
+    }
+    tcflush(usbFileDescriptor, TCIFLUSH);
     memset(&serialDataIn, '\0', sizeof (serialDataIn));
     return str;
 }
 
+bool USBSerial::waitForData(int timeoutMs) {
+    fd_set readSet;
+    FD_ZERO(&readSet);
+    FD_SET(usbFileDescriptor, &readSet);
+
+    struct timeval timeout;
+    timeout.tv_sec = timeoutMs / 1000;
+    timeout.tv_usec = (timeoutMs % 1000) * 1000;
+
+    return select(usbFileDescriptor + 1, &readSet, NULL, NULL, &timeout) > 0;
+}
+
+bool USBSerial::waitForWritable(int timeoutMs) {
+    fd_set writeSet;
+    FD_ZERO(&writeSet);
+    FD_SET(usbFileDescriptor, &writeSet);
+
+    struct timeval timeout;
+    timeout.tv_sec = timeoutMs / 1000;
+    timeout.tv_usec = (timeoutMs % 1000) * 1000;
+
+    return select(usbFileDescriptor + 1, NULL, &writeSet, NULL, &timeout) > 0;
+}
+
+int USBSerial::readAvailable(char* buffer, int size) {
+    int bytesRead = read(usbFileDescriptor, buffer, size);
+    if (bytesRead < 0) {
+        // EAGAIN just means nothing is waiting on the non-blocking port
+        return 0;
+    }
+    bytesReadCount += bytesRead;
+    return bytesRead;
+}
+
+// Safe to call twice, the abridge nodelet closes the port before the
+// destructor runs
 void USBSerial::closeUSBPort() {
-    close(usbFileDescriptor);
+    if (usbFileDescriptor >= 0) {
+        close(usbFileDescriptor);
+        usbFileDescriptor = -1;
+    }
 }
 
 USBSerial::~USBSerial() {
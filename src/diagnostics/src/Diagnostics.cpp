@@ -2,28 +2,58 @@
 
 #include <string>
 #include <usb.h>
+#include <libudev.h>
 #include <sys/stat.h> // To check if a file exists
 #include <std_msgs/String.h> // For creating ROS string messages
 #include <ctime> // For time()
+#include <algorithm> // For max
+#include <cmath> // For fabs
 
 using namespace std;
 using namespace gazebo;
 
+// Positions in the abridge statistics array (abridge/include/bridgeMetrics.h)
+const int bridgeStatInterval = 0;
+const int bridgeStatFramesOk = 1;
+const int bridgeStatFramesMalformed = 2;
+const int bridgeStatFramesPartial = 3;
+const int bridgeStatCommandsPending = 7;
+const int bridgeStatLatencyP95 = 10;
+const size_t bridgeStatMinimumSize = 11;
+
+// Length of the diagnostic message read by the GUI: wireless quality, bytes
+// per second, sim rate and, while abridge is reporting, four bridge values
+const size_t diagnosticDataSize = 3;
+const size_t diagnosticDataWithBridgeSize = 7;
+
+// Warn when more than this fraction of the telemetry frames are dropped
+const float bridgeDropWarningFraction = 0.1;
+
 Diagnostics::Diagnostics(std::string name) {
 
   this->publishedName = name;
   diagLogPublisher = nodeHandle.advertise<std_msgs::String>("/diagsLog", 1, true);
-  diagnosticDataPublisher  = nodeHandle.advertise<std_msgs::Float32MultiArray>("/"+publishedName+"/diagnostics", 10);
+  // Latched since the values are only sent when they change, so a GUI that
+  // starts later still gets the current ones
+  diagnosticDataPublisher  = nodeHandle.advertise<std_msgs::Float32MultiArray>("/"+publishedName+"/diagnostics", 10, true);
+  bridgeStatsSubscriber = nodeHandle.subscribe("/"+publishedName+"/abridge/stats", 10, &Diagnostics::bridgeStatsEventHandler, this);
 
   // Initialize the variables we use to track the simulation update rate
   prevRealTime = common::Time(0.0);
   prevSimTime = common::Time(0.0);
+  latestRealTime = common::Time(0.0);
+  latestSimTime = common::Time(0.0);
   simRate = 0.0f;
 
-  // Setup sensor check timers
-  sensorCheckTimer = nodeHandle.createTimer(ros::Duration(sensorCheckInterval), &Diagnostics::sensorCheckTimerEventHandler, this);
-  
- simCheckTimer = nodeHandle.createTimer(ros::Duration(sensorCheckInterval), &Diagnostics::simCheckTimerEventHandler, this);
+  ros::NodeHandle param("~");
+  param.param("publish_delta", publishDelta, publishDelta);
+  param.param("max_publish_interval", maxPublishInterval, maxPublishInterval);
+
+  diagnosticMsg.data.reserve(diagnosticDataWithBridgeSize);
+  publishedData.reserve(diagnosticDataWithBridgeSize);
+
+  // Setup the sensor check timer
+  checkTimer = nodeHandle.createTimer(ros::Duration(sensorCheckInterval), &Diagnostics::checkTimerEventHandler, this);
 
   if ( checkIfSimulatedRover() ) {
     // For processing gazebo messages from the world stats topic.
@@ -47,6 +77,23 @@ Diagnostics::Diagnostics(std::string name) {
   } else {
     simulated = false;
     publishInfoLogMessage("Diagnostic Package Started. Physical Rover. ");
+
+    usb_init();
+
+    udevContext = udev_new();
+    if (udevContext) {
+      usbMonitor = udev_monitor_new_from_netlink(udevContext, "udev");
+    }
+    if (usbMonitor) {
+      udev_monitor_filter_add_match_subsystem_devtype(usbMonitor, "usb", "usb_device");
+      if (udev_monitor_enable_receiving(usbMonitor) < 0) {
+        udev_monitor_unref(usbMonitor);
+        usbMonitor = NULL;
+      }
+    }
+    if (!usbMonitor) {
+      publishWarningLogMessage("No udev USB notifications, scanning the USB busses every sensor check");
+    }
     
     try {       
       string name = wirelessDiags.setInterface();
@@ -58,25 +105,62 @@ Diagnostics::Diagnostics(std::string name) {
 }
 
 void Diagnostics::publishDiagnosticData() {
-  if (!simulated) {
-  WirelessInfo info;
-
-  // Get info about the wireless interface
-  // Catch and display an error if there was an exception
-  try {
-    info = wirelessDiags.getInfo();
-  } catch( exception &e ){
-    publishErrorLogMessage(e.what());
-  return;
+  vector<float>& data = diagnosticMsg.data;
+
+  if (simulated) {
+    data.resize(diagnosticDataSize);
+    data[0] = 0.0f;
+    data[1] = 0.0f;
+    data[2] = checkSimRate();
+  } else {
+    WirelessInfo info;
+
+    // Get info about the wireless interface
+    // Catch and display an error if there was an exception
+    try {
+      info = wirelessDiags.getInfo();
+    } catch( exception &e ){
+      publishErrorLogMessage(e.what());
+      return;
+    }
+
+    // Serial bridge health, only sent while abridge is reporting
+    bool bridgeReporting = bridgeStats.size() >= bridgeStatMinimumSize && ros::Time::now() - bridgeStatsTime < ros::Duration(3*sensorCheckInterval);
+
+    data.resize(bridgeReporting ? diagnosticDataWithBridgeSize : diagnosticDataSize);
+    data[0] = info.quality;
+    data[1] = info.bandwidthUsed;
+    data[2] = -1; // Sim update rate
+
+    if (bridgeReporting) {
+      float interval = bridgeStats[bridgeStatInterval];
+      float good = bridgeStats[bridgeStatFramesOk];
+      float dropped = bridgeStats[bridgeStatFramesMalformed] + bridgeStats[bridgeStatFramesPartial];
+      data[3] = interval > 0 ? good / interval : 0; // Telemetry frames per second
+      data[4] = good + dropped > 0 ? 100 * dropped / (good + dropped) : 0; // Percent of frames dropped
+      data[5] = bridgeStats[bridgeStatLatencyP95]; // 95th percentile request to frame latency in ms
+      data[6] = bridgeStats[bridgeStatCommandsPending]; // Commands waiting to be written
+    }
+  }
+
+  ros::Time now = ros::Time::now();
+  if (diagnosticDataChanged() || now - lastPublishTime >= ros::Duration(maxPublishInterval)) {
+    diagnosticDataPublisher.publish(diagnosticMsg);
+    publishedData = data; // Fits in the reserved buffer
+    lastPublishTime = now;
+  }
 }
 
-  std_msgs::Float32MultiArray rosMsg;
-  rosMsg.data.clear();
-  rosMsg.data.push_back(info.quality);
-  rosMsg.data.push_back(info.bandwidthUsed);
-  rosMsg.data.push_back(-1); // Sim update rate
-  diagnosticDataPublisher.publish(rosMsg);  
+// A value has changed when it moved by more than publishDelta times the value
+// last sent, or by more than publishDelta itself when that value was below 1
+bool Diagnostics::diagnosticDataChanged() const {
+  const vector<float>& data = diagnosticMsg.data;
+  if (data.size() != publishedData.size()) return true;
+
+  for (size_t i = 0; i < data.size(); i++) {
+    if (fabs(data[i] - publishedData[i]) > publishDelta * max(fabs(publishedData[i]), 1.0f)) return true;
   }
+  return false;
 }
 
 void Diagnostics::publishErrorLogMessage(std::string msg) {
@@ -112,35 +196,40 @@ string Diagnostics::getHumanFriendlyTime() {
    
 }
 
-// sensor check timeout handler. This function is triggered periodically and calls the
-// sensor check functions.
-void Diagnostics::sensorCheckTimerEventHandler(const ros::TimerEvent& event) {
+// Check timeout handler. This function is triggered periodically and calls the
+// sensor check functions on physical rovers, then sends the diagnostic data.
+void Diagnostics::checkTimerEventHandler(const ros::TimerEvent& event) {
 
   if (!simulated) {
-  checkIMU();
-  checkGPS();
-  checkSonar();
-  checkCamera();
-  
-  publishDiagnosticData();
+    updateUSBDevices();
+
+    checkIMU();
+    checkGPS();
+    checkSonar();
+    checkCamera();
+    checkSerialBridge();
   }
 
+  publishDiagnosticData();
 }
 
-void Diagnostics::simCheckTimerEventHandler(const ros::TimerEvent& event) {
-  
-  if (simulated) {
-    std_msgs::Float32MultiArray rosMsg;
-    rosMsg.data.clear();
-    rosMsg.data.push_back(0.0f);
- rosMsg.data.push_back(0.0f);
-    rosMsg.data.push_back(checkSimRate());
-    diagnosticDataPublisher.publish(rosMsg);
+// The rate is the simulated time that passed since the last check divided by
+// the real time, so it stays meaningful when the world runs many times faster
+// than real time and the world stats messages arrive unevenly.
+float Diagnostics::checkSimRate() {
+  lock_guard<mutex> lock(worldStatsMutex);
+
+  common::Time deltaSimTime = latestSimTime - prevSimTime;
+  common::Time deltaRealTime = latestRealTime - prevRealTime;
+
+  // No new stats, or the world was reset, keep the last rate
+  if (deltaRealTime.Double() > 0 && deltaSimTime.Double() >= 0) {
+    simRate = deltaSimTime.Double() / deltaRealTime.Double();
   }
-  
-}
 
-float Diagnostics::checkSimRate() {
+  prevSimTime = latestSimTime;
+  prevRealTime = latestRealTime;
+
   return simRate;
 }
 
@@ -186,6 +275,30 @@ void Diagnostics::checkSonar() {
   //publishErrorLogMessage("Sonar Error");
 }
 
+// Warn when abridge reports that a large share of the telemetry frames from the
+// Arduino are being dropped
+void Diagnostics::checkSerialBridge() {
+  if (bridgeStats.size() < bridgeStatMinimumSize) return;
+
+  float good = bridgeStats[bridgeStatFramesOk];
+  float dropped = bridgeStats[bridgeStatFramesMalformed] + bridgeStats[bridgeStatFramesPartial];
+  bool healthy = (good + dropped == 0) || (dropped / (good + dropped) <= bridgeDropWarningFraction);
+
+  if (healthy) {
+    // Notify the GUI only if recovered after previously dropping frames
+    if (!bridgeHealthy) publishInfoLogMessage("Arduino telemetry recovered");
+  } else {
+    if (bridgeHealthy) // Guard against repeating the warning.
+      publishWarningLogMessage("Dropping " + to_string(static_cast<int>(dropped)) + " of " + to_string(static_cast<int>(good + dropped)) + " Arduino telemetry frames");
+  }
+  bridgeHealthy = healthy;
+}
+
+void Diagnostics::bridgeStatsEventHandler(const std_msgs::Float32MultiArray::ConstPtr& msg) {
+  bridgeStats = msg->data;
+  bridgeStatsTime = ros::Time::now();
+}
+
 // Check if the U-Blox GPS is connected
 // ID_VENDOR = 0x1546
 // ID_PRODUCT = 0x01a6
@@ -208,21 +321,34 @@ bool Diagnostics::checkCameraExists(){
 // Search through the connected USB devices for one that matches the
 // specified vendorID and productID
 bool Diagnostics::checkUSBDeviceExists(uint16_t vendorID, uint16_t productID){
-  
+  return usbDevices.count(make_pair(vendorID, productID)) > 0;
+}
+
+void Diagnostics::updateUSBDevices() {
+
+  // Drain the hotplug events, the socket is non-blocking
+  bool changed = !usbScanned || !usbMonitor;
+  if (usbMonitor) {
+    struct udev_device *event;
+    while ((event = udev_monitor_receive_device(usbMonitor)) != NULL) {
+      changed = true;
+      udev_device_unref(event);
+    }
+  }
+  if (!changed) return;
+
   struct usb_bus *bus;
   struct usb_device *dev;
-  usb_init();
   usb_find_busses();
   usb_find_devices();
 
   // Iterate through busses and devices
+  usbDevices.clear();
   for (bus = usb_busses; bus; bus = bus->next)
     for (dev = bus->devices; dev; dev = dev->next)
-      if ( dev->descriptor.idVendor == vendorID && dev->descriptor.idProduct == productID )
-        return true; 
+      usbDevices.insert(make_pair(dev->descriptor.idVendor, dev->descriptor.idProduct));
 
-  // GPS not found
-  return false;
+  usbScanned = true;
 }
 
 void Diagnostics::simWorldStatsEventHandler(ConstWorldStatisticsPtr &msg) {
@@ -230,16 +356,9 @@ void Diagnostics::simWorldStatsEventHandler(ConstWorldStatisticsPtr &msg) {
   const msgs::Time simTimeMsg = msg->sim_time();
   const msgs::Time realTimeMsg = msg->real_time();
 
-  common::Time simTime(simTimeMsg.sec(), simTimeMsg.nsec());
-  common::Time realTime(realTimeMsg.sec(), realTimeMsg.nsec());
-  
-  common::Time deltaSimTime = simTime - prevSimTime;
-  common::Time deltaRealTime = realTime - prevRealTime;
-
-  prevSimTime = simTime;
-  prevRealTime = realTime;
-
-  simRate = (deltaSimTime.Double())/(deltaRealTime.Double());
+  lock_guard<mutex> lock(worldStatsMutex);
+  latestSimTime = common::Time(simTimeMsg.sec(), simTimeMsg.nsec());
+  latestRealTime = common::Time(realTimeMsg.sec(), realTimeMsg.nsec());
 }
 
 // Check whether a rover model file exists with the same name as this rover name
@@ -253,6 +372,8 @@ bool Diagnostics::checkIfSimulatedRover() {
 }
      
 Diagnostics::~Diagnostics() {
+  if (usbMonitor) udev_monitor_unref(usbMonitor);
+  if (udevContext) udev_unref(udevContext);
   gazebo::shutdown();
 }
 
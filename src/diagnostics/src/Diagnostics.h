@@ -15,7 +15,14 @@
 #include "std_msgs/Float32MultiArray.h"
 
 #include <string>
+#include <vector>
+#include <set>
+#include <utility>
 #include <exception>
+#include <mutex>
+
+struct udev;
+struct udev_monitor;
 
 class Diagnostics {
   
@@ -31,17 +38,25 @@ public:
   // corresponding to predefined diagnostic values 
   // to be displayed in the GUI
   // For example, the wireless signal quality.
+  // The array is only sent when a value changed by more than publishDelta,
+  // or maxPublishInterval passed since it was last sent.
   void publishDiagnosticData();
 
   void simWorldStatsEventHandler(ConstWorldStatisticsPtr &msg);
+
+  // Receives the serial bridge statistics published by abridge
+  void bridgeStatsEventHandler(const std_msgs::Float32MultiArray::ConstPtr& msg);
   
   std::string getHumanFriendlyTime();
   
 private:
 
-  // These functions are called on a timer and check for problems with the sensors
-  void sensorCheckTimerEventHandler(const ros::TimerEvent&);
-  void simCheckTimerEventHandler(const ros::TimerEvent&);
+  // Called on a timer to check for problems with the sensors and gather the
+  // wireless, serial bridge and simulation rate values into one message
+  void checkTimerEventHandler(const ros::TimerEvent&);
+
+  // True if the diagnostic message differs enough from the last one sent
+  bool diagnosticDataChanged() const;
   
 
   // Get the rate the simulation is running for simulated rovers
@@ -51,6 +66,7 @@ private:
   void checkGPS();
   void checkSonar();
   void checkCamera();
+  void checkSerialBridge();
     
   bool checkGPSExists();
   bool checkCameraExists();
@@ -62,32 +78,62 @@ private:
   // be bypassed.
   bool checkIfSimulatedRover();
   
-  // Takes the vendor and device IDs and searches the USB busses for a match
+  // Takes the vendor and device IDs and looks for a match in the devices found
+  // by the last USB scan
   bool checkUSBDeviceExists(uint16_t, uint16_t);
+
+  // Rescans the USB busses once per sensor check, and only if udev reported a
+  // device being added or removed since the previous scan
+  void updateUSBDevices();
   
   ros::NodeHandle nodeHandle;
   ros::Publisher diagLogPublisher;
   ros::Publisher diagnosticDataPublisher;
+  ros::Subscriber bridgeStatsSubscriber;
   std::string publishedName;
 
   
   float sensorCheckInterval = 2; // Check sensors every 2 seconds
-  ros::Timer sensorCheckTimer;
-  ros::Timer simCheckTimer;
+  ros::Timer checkTimer;
+
+  // The diagnostic message is reused for every check so its buffer is only
+  // allocated once. publishedData holds the values that were last sent.
+  std_msgs::Float32MultiArray diagnosticMsg;
+  std::vector<float> publishedData;
+  ros::Time lastPublishTime;
+  float publishDelta = 0.05; // Fraction of the last sent value, or absolute below 1
+  float maxPublishInterval = 10; // Seconds, so the GUI still hears from an idle rover
 
   // Store some state about the current health of the rover
   bool cameraConnected = true;
   bool GPSConnected = true;
   bool simulated = false;
+  bool bridgeHealthy = true;
+
+  // Latest statistics from abridge, see abridge/include/bridgeMetrics.h for the layout
+  std::vector<float> bridgeStats;
+  ros::Time bridgeStatsTime;
 
-  // Simulation update rate as a fraction of real time
+  // Simulation update rate as a fraction of real time, measured over each
+  // sim check interval. The world stats arrive on a gazebo transport thread.
   float simRate;
+  std::mutex worldStatsMutex;
+  gazebo::common::Time latestSimTime;
+  gazebo::common::Time latestRealTime;
   gazebo::common::Time prevSimTime;
   gazebo::common::Time prevRealTime;
   
   
   WirelessDiags wirelessDiags;
 
+  // Vendor and product IDs of the connected USB devices
+  std::set< std::pair<uint16_t, uint16_t> > usbDevices;
+  bool usbScanned = false;
+
+  // USB hotplug notifications. Without them the busses are scanned every check.
+  struct udev* udevContext = NULL;
+  struct udev_monitor* usbMonitor = NULL;
+
   // So we can get Gazebo world stats
   gazebo::transport::NodePtr gazeboNode;
   gazebo::transport::SubscriberPtr worldStatsSubscriber;
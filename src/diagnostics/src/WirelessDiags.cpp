@@ -18,7 +18,16 @@ using namespace std;
 WirelessDiags::WirelessDiags() {
   prev_total_bytes = 0;
   gettimeofday(&prev_time,NULL); // Set the prevtime to be the time this object was created using the default time zone
+  memset(mac, 0, sizeof(mac));
 
+  // One socket serves every ioctl this class makes
+  ioctlSocket = socket(AF_INET, SOCK_DGRAM, 0);
+}
+
+WirelessDiags::~WirelessDiags() {
+  if (receiveBytesFd >= 0) close(receiveBytesFd);
+  if (transmitBytesFd >= 0) close(transmitBytesFd);
+  if (ioctlSocket >= 0) close(ioctlSocket);
 }
 
 // Sets the diagnostics to use the first wireless interfact found
@@ -30,6 +39,23 @@ string WirelessDiags::setInterface() {
 
   interfaceName = name;
 
+  //SIOCGIFHWADDR for mac addr
+  ifreq req;
+  memset(&req, 0, sizeof(req));
+  strncpy(req.ifr_name, interfaceName.c_str(), IFNAMSIZ - 1);
+
+  //this will get the mac address of the interface
+  if(ioctl(ioctlSocket, SIOCGIFHWADDR, &req) == -1){
+    // There was an error throw an exception
+    string errorMsg = "Unable to open ioctl socket for " + interfaceName + ": "+ string(strerror(errno));
+    throw runtime_error(errorMsg);
+  }
+  sprintf(mac, "%.2X", (unsigned char)req.ifr_hwaddr.sa_data[0]);
+  for(int s=1; s<6; s++){
+    sprintf(mac+strlen(mac), ":%.2X", (unsigned char)req.ifr_hwaddr.sa_data[s]);
+  }
+
+  openStatistics();
   calcBitRate(); // Initialize the previous byte counts
 
   return name;
@@ -39,14 +65,12 @@ string WirelessDiags::setInterface() {
 // Check if the interface we were told to use exists
 bool WirelessDiags::isInterfaceUp(string name) {
     struct ifreq ifr;
-    int sock = socket(PF_INET6, SOCK_DGRAM, IPPROTO_IP);
     memset(&ifr, 0, sizeof(ifr));
-    strcpy(ifr.ifr_name, name.c_str());
-    if (ioctl(sock, SIOCGIFFLAGS, &ifr) < 0) {
+    strncpy(ifr.ifr_name, name.c_str(), IFNAMSIZ - 1);
+    if (ioctl(ioctlSocket, SIOCGIFFLAGS, &ifr) < 0) {
       string errorMsg = "Unable to open ioctl socket: "+ string(strerror(errno));
       throw runtime_error(errorMsg);
     }
-    close(sock);
     return !!(ifr.ifr_flags & IFF_UP);
 }
 
@@ -82,60 +106,54 @@ string WirelessDiags::findWirelessInterface() {
 
 // Code to check whether a network interface is wireless or not.
 bool WirelessDiags::isWireless(const char* name) {
-  int sock = -1;
   struct iwreq pwrq;
   memset(&pwrq, 0, sizeof(pwrq));
-  strncpy(pwrq.ifr_name, name, IFNAMSIZ);
+  strncpy(pwrq.ifr_name, name, IFNAMSIZ - 1);
 
-  // Try to open a socket to the interface
-  sock = socket(AF_INET, SOCK_STREAM, 0);
-
-  bool wireless = false;
-  
   // Check if wireless by asking for verfification
   // of wireless extensions (the SIOCGIWNAME directive)
-  if (ioctl(sock, SIOCGIWNAME, &pwrq) != -1) wireless =  true;
-
-  close(sock);
-  return wireless;
+  return ioctl(ioctlSocket, SIOCGIWNAME, &pwrq) != -1;
 }
 
-// Helper function to read the number of bytes sent and received over time to calculate
-// the current bitrate
-float WirelessDiags::calcBitRate() {
+void WirelessDiags::openStatistics() {
+  if (receiveBytesFd >= 0) close(receiveBytesFd);
+  if (transmitBytesFd >= 0) close(transmitBytesFd);
 
   // Path to the linux provided stats. These files are pointers to memory locations
   // and are not on disk.
   string receive_bytes_stat_path = "/sys/class/net/"+interfaceName+"/statistics/rx_bytes";
   string transmit_bytes_stat_path = "/sys/class/net/"+interfaceName+"/statistics/tx_bytes";
 
-  // Open, read and close the bytes received and bytes sent file pointers. 
-  ifstream receive_bytes_stat, transmit_bytes_stat;
+  receiveBytesFd = open(receive_bytes_stat_path.c_str(), O_RDONLY);
+  transmitBytesFd = open(transmit_bytes_stat_path.c_str(), O_RDONLY);
 
   // Throw an exception if there was a problem
-  receive_bytes_stat.exceptions( std::ifstream::failbit | std::ifstream::badbit );
-  transmit_bytes_stat.exceptions( std::ifstream::failbit | std::ifstream::badbit );
-  
-  // Open the files
-  transmit_bytes_stat.open(transmit_bytes_stat_path.c_str());
-  receive_bytes_stat.open(receive_bytes_stat_path.c_str());
-  
-  string receive_stat;
-  getline(receive_bytes_stat,receive_stat);
-  receive_bytes_stat.close();
-   
-  string transmit_stat;
-  getline(transmit_bytes_stat,transmit_stat);
-  transmit_bytes_stat.close();
+  if (receiveBytesFd < 0 || transmitBytesFd < 0) {
+    throw runtime_error("Unable to open the statistics of " + interfaceName + ": " + string(strerror(errno)));
+  }
+}
+
+long int WirelessDiags::readStatistic(int fd) {
+  char value[32];
+  ssize_t length = pread(fd, value, sizeof(value) - 1, 0);
+  if (length <= 0) {
+    throw runtime_error("Unable to read the statistics of " + interfaceName + ": " + string(strerror(errno)));
+  }
+  value[length] = '\0';
+  return strtol(value, NULL, 10);
+}
+
+// Helper function to read the number of bytes sent and received over time to calculate
+// the current bitrate
+float WirelessDiags::calcBitRate() {
+
+  // Re-read the bytes received and bytes sent counters from the open files
+  long int rx_bytes = readStatistic(receiveBytesFd);
+  long int tx_bytes = readStatistic(transmitBytesFd);
 
   // Remember the total bytes transmitted so we can take the difference 
   // between recordings at each time interval.
   prev_total_bytes = total_bytes;
-   
-  // Convert string to int
-  string::size_type sz;   // alias of size_t
-  long int rx_bytes = stoi(receive_stat,&sz);
-  long int tx_bytes = stoi(transmit_stat,&sz);
 
   // Get the total bytes transmitted and recevied. This is the total bandwidth used.
   total_bytes = rx_bytes + tx_bytes;
@@ -162,7 +180,7 @@ float WirelessDiags::calcBitRate() {
   // time it is called
   prev_time = now; 
   
-  float byte_rate = byte_rate = (total_bytes - prev_total_bytes)*1.0f/elapsedTime;
+  float byte_rate = (total_bytes - prev_total_bytes)*1.0f/elapsedTime;
    
   // Rate in B/s
   return byte_rate;
@@ -179,57 +197,54 @@ WirelessInfo WirelessDiags::getInfo(){
   memset(&req, 0, sizeof(struct iwreq));
 
   // Populate the interface name in the request object
-  strcpy(req.ifr_name, interfaceName.c_str());
-
-  // Declare an iw_statistics object to store the IOCTL results in
-  iw_statistics *stats;
-
-  // Create socket through which to talk to the kernel 
-  int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+  strncpy(req.ifr_name, interfaceName.c_str(), IFNAMSIZ - 1);
 
-  // Allocate space for the iw_statistics object, point to it from the request,
-  // and store the length of the object in the request.
-  req.u.data.pointer = (iw_statistics *)malloc(sizeof(iw_statistics));
+  // The iw_statistics object the IOCTL results are stored in. Point to it
+  // from the request and store the length of the object in the request.
+  iw_statistics stats;
+  memset(&stats, 0, sizeof(stats));
+  req.u.data.pointer = &stats;
   req.u.data.length = sizeof(iw_statistics);
 
   // Use IOCTL to request the wireless stats. If -1 there was an error.
-  if(ioctl(sockfd, SIOCGIWSTATS, &req) == -1){
+  if(ioctl(ioctlSocket, SIOCGIWSTATS, &req) == -1){
     string errorMsg = "Unable to open ioctl socket for " + interfaceName + ": "+ string(strerror(errno));
 
     // Throw an error
     throw runtime_error(errorMsg);
-    return sigInfo;
   }
-  else if(((iw_statistics *)req.u.data.pointer)->qual.updated & IW_QUAL_DBM){
+  else if(stats.qual.updated & IW_QUAL_DBM){
     // Opened the socket so read the data
-    sigInfo.level = ((iw_statistics *)req.u.data.pointer)->qual.level - 256;
-    sigInfo.quality=((iw_statistics *)req.u.data.pointer)->qual.qual;
-    sigInfo.noise=((iw_statistics *)req.u.data.pointer)->qual.noise;
+    sigInfo.level = stats.qual.level - 256;
+    sigInfo.quality = stats.qual.qual;
+    sigInfo.noise = stats.qual.noise;
   }
 
   //SIOCGIWESSID for ssid
-  char buffer[32];
-  memset(buffer, 0, 32);
+  char buffer[IW_ESSID_MAX_SIZE];
+  memset(buffer, 0, sizeof(buffer));
   req.u.essid.pointer = buffer;
-  req.u.essid.length = 32;
+  req.u.essid.length = sizeof(buffer);
+  req.u.essid.flags = 0;
 
   //this will gather the SSID of the connected network
-  if(ioctl(sockfd, SIOCGIWESSID, &req) == -1){
+  if(ioctl(ioctlSocket, SIOCGIWESSID, &req) == -1){
     // There was an error throw an exception
     string errorMsg = "Unable to open ioctl socket for " + interfaceName + ": "+ string(strerror(errno));
     throw runtime_error(errorMsg);
   }
   else {
     // Opened the socket so read the data
-    memcpy(&sigInfo.ssid, req.u.essid.pointer, req.u.essid.length);
-    memset(&sigInfo.ssid[req.u.essid.length],0,1);
+    int length = req.u.essid.length > sizeof(buffer) ? sizeof(buffer) : req.u.essid.length;
+    memcpy(&sigInfo.ssid, buffer, length);
+    memset(&sigInfo.ssid[length],0,1);
   }
 
   //SIOCGIWRATE for bits/sec (convert to mbit)
   int bitrate=-1;
   
   //this will get the claimed bitrate of the link
-  if(ioctl(sockfd, SIOCGIWRATE, &req) == -1){
+  if(ioctl(ioctlSocket, SIOCGIWRATE, &req) == -1){
     // There was an error throw an exception
     string errorMsg = "Unable to open ioctl socket for " + interfaceName + ": "+ string(strerror(errno));
     throw runtime_error(errorMsg);
@@ -239,25 +254,8 @@ WirelessInfo WirelessDiags::getInfo(){
     sigInfo.bandwidthAvailable=bitrate/1000000;
   }
 
-  //SIOCGIFHWADDR for mac addr
-  ifreq req2;
-  strcpy(req2.ifr_name, interfaceName.c_str());
-
-  //this will get the mac address of the interface
-  if(ioctl(sockfd, SIOCGIFHWADDR, &req2) == -1){
-    // There was an error throw an exception
-    string errorMsg = "Unable to open ioctl socket for " + interfaceName + ": "+ string(strerror(errno));
-    throw runtime_error(errorMsg);
-  } else{
-    // Opened the socket so read the data
-    sprintf(sigInfo.mac, "%.2X", (unsigned char)req2.ifr_hwaddr.sa_data[0]);
-    for(int s=1; s<6; s++){
-      sprintf(sigInfo.mac+strlen(sigInfo.mac), ":%.2X", (unsigned char)req2.ifr_hwaddr.sa_data[s]);
-    }
-  }
-
-  // We are done so clean up
-  close(sockfd);
+  // The mac address was read when the interface was set
+  memcpy(sigInfo.mac, mac, sizeof(mac));
 
   sigInfo.bandwidthUsed = calcBitRate();  
 
@@ -20,6 +20,7 @@ class WirelessDiags {
 public:
 
   WirelessDiags();
+  ~WirelessDiags();
   
   // Sets the name of the interface
   // about which to provide information
@@ -40,14 +41,34 @@ private:
   bool isWireless(const char* name);
   float calcBitRate();
 
+  // Reads a counter from one of the open statistics files
+  long int readStatistic(int fd);
+
+  // Opens the statistics files of interfaceName, closing any previous ones
+  void openStatistics();
+
   std::string interfaceName;
 
+  // Kept open for the life of the object so sampling does not create a
+  // socket or open a file every time. The sysfs counters are re-read with
+  // pread from offset 0.
+  int ioctlSocket = -1;
+  int receiveBytesFd = -1;
+  int transmitBytesFd = -1;
+
+  // The hardware address does not change, it is read once in setInterface
+  char mac[18];
+
   // State needed to keep track of
   // the number of bytes sent between calcBitRate calls
 
   long int prev_total_bytes = 0;
   long int total_bytes = 0;
   struct timeval prev_time; // The wall time of the last call to calcBitRate;
+
+  // Owns file descriptors
+  WirelessDiags(const WirelessDiags&);
+  WirelessDiags& operator=(const WirelessDiags&);
 };
 
 #endif // WirelessDiags_h
@@ -28,7 +28,9 @@ using namespace std;
 void GripperPlugin::Load(physics::ModelPtr _model, sdf::ElementPtr _sdf) {
   model = _model;
   sdf = _sdf;
-  previousUpdateTime = model->GetWorld()->GetSimTime();
+  rosQueue = NULL;
+  stepsUntilUpdate = 0;
+  setPointTolerance = 0.001;
   previousDebugUpdateTime = model->GetWorld()->GetSimTime();
 
   attachedTargetModel = NULL;
@@ -97,9 +99,10 @@ void GripperPlugin::Load(physics::ModelPtr _model, sdf::ElementPtr _sdf) {
 
   // Connect the updateWorldEventHandler function to Gazebo;
   // ConnectWorldUpdateBegin sets our handler to be called at the beginning of
-  // each physics update iteration
+  // each physics update iteration. Gazebo has no throttled update event, so
+  // the handler counts down the physics steps in each update period.
   updateConnection = event::Events::ConnectWorldUpdateBegin(
-    boost::bind(&GripperPlugin::updateWorldEventHandler, this)
+    boost::bind(&GripperPlugin::updateWorldEventHandler, this, _1)
   );
   ROS_DEBUG_STREAM_COND(isDebuggingModeActive, "[Gripper Plugin : "
     << model->GetName() << "]\n    bind world update function to gazebo:\n"
@@ -113,13 +116,16 @@ void GripperPlugin::Load(physics::ModelPtr _model, sdf::ElementPtr _sdf) {
     exit(1);
   }
 
+  // register with the callback thread pool shared by all plugins
+  rosQueue = RosCallbackExecutor::instance().acquire();
+
   // SUBSCRIBE TO ROS TOPICS - begin
   string wristTopic = loadSubscriptionTopic("wristTopic");
   ros::SubscribeOptions wristSubscriptionOptions =
     ros::SubscribeOptions::create<std_msgs::Float32>(
       wristTopic, 1,
       boost::bind(&GripperPlugin::setWristAngleHandler, this, _1),
-      ros::VoidPtr(), &rosQueue
+      ros::VoidPtr(), rosQueue
     );
 
   string fingerTopic = loadSubscriptionTopic("fingerTopic");
@@ -127,7 +133,7 @@ void GripperPlugin::Load(physics::ModelPtr _model, sdf::ElementPtr _sdf) {
     ros::SubscribeOptions::create<std_msgs::Float32>(
       fingerTopic, 1,
       boost::bind(&GripperPlugin::setFingerAngleHandler, this, _1),
-      ros::VoidPtr(), &rosQueue
+      ros::VoidPtr(), rosQueue
     );
 
   wristAngleSubscriber = rosNode->subscribe(wristSubscriptionOptions);
@@ -138,13 +144,6 @@ void GripperPlugin::Load(physics::ModelPtr _model, sdf::ElementPtr _sdf) {
     << "        " << wristTopic << endl << "        " << fingerTopic);
   // SUBSCRIBE TO ROS TOPICS - end
 
-  // spin up the queue helper thread
-  rosQueueThread =
-    std::thread(std::bind(&GripperPlugin::processRosQueue, this));
-  ROS_DEBUG_STREAM_COND(isDebuggingModeActive, "[Gripper Plugin : "
-    << model->GetName() << "]\n    bind queue helper function to private "
-    << "thread:\n        void GripperPlugin::processRosQueue()");
-
   // Create Gazebo node and init
 // Create Gazebo node and init
   gazebo::transport::NodePtr gazeboNode(new gazebo::transport::Node());
@@ -173,13 +172,12 @@ void GripperPlugin::Load(physics::ModelPtr _model, sdf::ElementPtr _sdf) {
  * of the gripper as needed to instigate the desired movements requested by the
  * gripper publishers.
  */
-void GripperPlugin::updateWorldEventHandler() {
-  common::Time currentTime = model->GetWorld()->GetSimTime();
-
+void GripperPlugin::updateWorldEventHandler(const common::UpdateInfo& info) {
   // only update the gripper plugin once every updatePeriodInSeconds
-  if((currentTime - previousUpdateTime).Float() < updatePeriodInSeconds) {
+  if(--stepsUntilUpdate > 0) {
     return;
   }
+  stepsUntilUpdate = updatePeriodInSteps();
 
   // grasp an object if conditions are met
   handleGrasping();
@@ -187,29 +185,26 @@ void GripperPlugin::updateWorldEventHandler() {
   // Moves static models when grasped. Does nothing if the model is non-static
   updateGraspedStaticTargetPose();
 
-  previousUpdateTime = currentTime;
-
   GripperManager::GripperState currentState;
   GripperManager::GripperState desiredState;
 
-  // get the current gripper state
+  // get the current gripper state:
+  // => right finger joint angle is always negative
+  // => left finger joint angle is always positive
   currentState.wristAngle = wristJoint->GetAngle(0).Radian();
   currentState.leftFingerAngle = leftFingerJoint->GetAngle(0).Radian();
   currentState.rightFingerAngle = rightFingerJoint->GetAngle(0).Radian();
 
-  // get the total angle of both fingers:
-  // => right finger joint angle is always negative
-  // => left finger joint angle is always positive
-  // total finger angle = left finger joint angle - (-right finger joint angle)
-  // total finger angle is ALWAYS POSITIVE (or zero)
-  float leftFingerAngle = leftFingerJoint->GetAngle(0).Radian();
-  float rightFingerAngle = rightFingerJoint->GetAngle(0).Radian();
-
   // Set the desired gripper state
   desiredState.leftFingerAngle = desiredFingerAngle.Radian() / 2.0;
   desiredState.rightFingerAngle = -desiredFingerAngle.Radian() / 2.0;
   desiredState.wristAngle = desiredWristAngle.Radian();
-  
+
+  // A settled gripper holding nothing needs no correcting forces
+  if(!isAttached && isAtSetPoint(currentState, desiredState)) {
+    return;
+  }
+
   // Get the forces to apply to the joints from the PID controllers
   GripperManager::GripperForces commandForces =
     gripperManager.getForces(desiredState, currentState);
@@ -220,34 +215,73 @@ void GripperPlugin::updateWorldEventHandler() {
   rightFingerJoint->SetForce(0, commandForces.rightFingerForce);
 
   // If debugging mode is active, print debugging statements
-  if((currentTime - previousDebugUpdateTime).Float() >= debugUpdatePeriodInSeconds) {
-    previousDebugUpdateTime = currentTime;
-
-    ROS_DEBUG_STREAM_COND(
-      isDebuggingModeActive, "[Gripper Plugin : "
-      << model->GetName() << "]\n"
-      << "           Wrist Angle: Current Angle: " << setw(12)
-      << currentState.wristAngle        << " rad\n"
-      << "                        Desired Angle: " << setw(12)
-      << desiredState.wristAngle        << " rad\n"
-      << "                        Applied Force: " << setw(12)
-      << commandForces.wristForce       << " N\n"
-      << "     Left Finger Angle: Current Angle: " << setw(12)
-      << currentState.leftFingerAngle   << " rad\n"
-      << "                        Desired Angle: " << setw(12)
-      << desiredState.leftFingerAngle   << " rad\n"
-      << "                        Applied Force: " << setw(12)
-      << commandForces.leftFingerForce  << " N\n"
-      << "    Right Finger Angle: Current Angle: " << setw(12)
-      << currentState.rightFingerAngle  << " rad\n"
-      << "                        Desired Angle: " << setw(12)
-      << desiredState.rightFingerAngle  << " rad\n"
-      << "                        Applied Force: " << setw(12)
-      << commandForces.rightFingerForce << " N\n"
-    );
+  if(isDebuggingModeActive &&
+     (info.simTime - previousDebugUpdateTime).Float() >= debugUpdatePeriodInSeconds) {
+    previousDebugUpdateTime = info.simTime;
+    printDebugState(currentState, desiredState, commandForces);
   }
 }
 
+/**
+ * The number of physics steps in one update period, so the update period
+ * still holds if the physics step size is changed while the world runs.
+ */
+int GripperPlugin::updatePeriodInSteps() {
+  double stepSize = model->GetWorld()->GetPhysicsEngine()->GetMaxStepSize();
+
+  if(stepSize <= 0.0) {
+    return 1;
+  }
+
+  return max(1, (int)round(updatePeriodInSeconds / stepSize));
+}
+
+/**
+ * Whether every gripper joint is within setPointTolerance of its desired
+ * angle and the fingers are not touching a target.
+ */
+bool GripperPlugin::isAtSetPoint(const GripperManager::GripperState& currentState,
+  const GripperManager::GripperState& desiredState) {
+  if(rightFingerTargetLink || leftFingerTargetLink) {
+    return false;
+  }
+
+  return fabs(desiredState.wristAngle - currentState.wristAngle) < setPointTolerance
+    && fabs(desiredState.leftFingerAngle - currentState.leftFingerAngle) < setPointTolerance
+    && fabs(desiredState.rightFingerAngle - currentState.rightFingerAngle) < setPointTolerance;
+}
+
+/**
+ * Prints the current and desired joint angles and the applied forces. This
+ * is kept out of updateWorldEventHandler() so the formatting code stays off
+ * the per-step path.
+ */
+void GripperPlugin::printDebugState(const GripperManager::GripperState& currentState,
+  const GripperManager::GripperState& desiredState,
+  const GripperManager::GripperForces& commandForces) {
+  ROS_DEBUG_STREAM("[Gripper Plugin : "
+    << model->GetName() << "]\n"
+    << "           Wrist Angle: Current Angle: " << setw(12)
+    << currentState.wristAngle        << " rad\n"
+    << "                        Desired Angle: " << setw(12)
+    << desiredState.wristAngle        << " rad\n"
+    << "                        Applied Force: " << setw(12)
+    << commandForces.wristForce       << " N\n"
+    << "     Left Finger Angle: Current Angle: " << setw(12)
+    << currentState.leftFingerAngle   << " rad\n"
+    << "                        Desired Angle: " << setw(12)
+    << desiredState.leftFingerAngle   << " rad\n"
+    << "                        Applied Force: " << setw(12)
+    << commandForces.leftFingerForce  << " N\n"
+    << "    Right Finger Angle: Current Angle: " << setw(12)
+    << currentState.rightFingerAngle  << " rad\n"
+    << "                        Desired Angle: " << setw(12)
+    << desiredState.rightFingerAngle  << " rad\n"
+    << "                        Applied Force: " << setw(12)
+    << commandForces.rightFingerForce << " N\n"
+  );
+}
+
 /**
  * This is the subscriber function for the desiredWristAngle variable. Updates
  * to desiredWristAngle will cause the gripper to be moved vertically around
@@ -290,19 +324,6 @@ void GripperPlugin::setFingerAngleHandler(const std_msgs::Float32ConstPtr& msg)
   }
 }
 
-/**
- * This function is used inside of a custom thread to process the messages
- * being passed from the publishers to the subscribers. It is the interface
- * between ROS and the setWristAngleHandler() and setFingerAngleHandler()
- * functions.
- */
-void GripperPlugin::processRosQueue() {
-  static const double timeout = 0.01;
-  while (rosNode->ok()) {
-    rosQueue.callAvailable(ros::WallDuration(timeout));
-  }
-}
-
 /**
  * This function sets the "isDebuggingModeActive" flag to true or false
  * depending on the <debug> tag for this plugin in the configuration SDF file.
@@ -717,30 +738,14 @@ void GripperPlugin::detach() {
 void GripperPlugin::rightFingerContactEventHandler(ConstContactsPtr& msg){
   if (attaching_mutex.try_lock()){
     lock_guard<mutex> lock(attaching_mutex, adopt_lock_t());
-    
-    for(unsigned int i=0; i < msg->contact_size(); i++){
-      string name1 = msg->contact(i).collision1();
-      string name2 = msg->contact(i).collision2();
-      
-      // Parse the collision name to find the link name (approporate GetChildLink accerros not available) This is a hacky way around that.
-      string collision1ModelName = name1.substr(0, name1.find("::"));
-      string collision2ModelName = name2.substr(0, name2.find("::"));
-      
-      physics::ModelPtr modelInCollision;
-      
-      if (collision1ModelName.substr(0,2).compare("at")==0) {
-        modelInCollision = model->GetWorld()->GetModel(collision1ModelName);
-        rightFingerTargetLink = modelInCollision->GetLink("link");
-	rightFingerNoContactTime = 0.0f;
-        return;
-      } else if (collision2ModelName.substr(0,2).compare("at")==0) {
-        modelInCollision = model->GetWorld()->GetModel(collision2ModelName);
-        rightFingerTargetLink = modelInCollision->GetLink("link");
-	rightFingerNoContactTime = 0.0f;
-        return;
-      }
+
+    physics::LinkPtr targetLink = findContactTargetLink(msg);
+    if (targetLink) {
+      rightFingerTargetLink = targetLink;
+      rightFingerNoContactTime = 0.0f;
+      return;
     }
-    
+
     if (rightFingerNoContactTime > fingerNoContactThreshold)
       rightFingerTargetLink = NULL;
   }
@@ -749,34 +754,60 @@ void GripperPlugin::rightFingerContactEventHandler(ConstContactsPtr& msg){
 void GripperPlugin::leftFingerContactEventHandler(ConstContactsPtr& msg){
   if (attaching_mutex.try_lock()){
     lock_guard<mutex> lock(attaching_mutex, adopt_lock_t());
-    
-    for(unsigned int i=0; i < msg->contact_size(); i++){
-      string name1 = msg->contact(i).collision1();
-      string name2 = msg->contact(i).collision2();
-      physics::ModelPtr modelInCollision;
-      
-      // Parse the collision name to find the link name (approporate GetChildLink accerros not available) This is a hacky way around that.
-      string collision1ModelName = name1.substr(0, name1.find("::"));
-      string collision2ModelName = name2.substr(0, name2.find("::"));
-      
-      if (collision1ModelName.substr(0,2).compare("at")==0) {
-        modelInCollision = model->GetWorld()->GetModel(collision1ModelName);
-        leftFingerTargetLink = modelInCollision->GetLink("link");
-	leftFingerNoContactTime = 0.0f;
-        return;
-      } else if (collision2ModelName.substr(0,2).compare("at")==0) {
-        modelInCollision = model->GetWorld()->GetModel(collision2ModelName);
-        leftFingerTargetLink = modelInCollision->GetLink("link");
-	leftFingerNoContactTime = 0.0f;
-        return;
-      }
+
+    physics::LinkPtr targetLink = findContactTargetLink(msg);
+    if (targetLink) {
+      leftFingerTargetLink = targetLink;
+      leftFingerNoContactTime = 0.0f;
+      return;
     }
-    
+
     if (leftFingerNoContactTime > fingerNoContactThreshold)
       leftFingerTargetLink = NULL;
   }
 }
 
+// Returns the link of the first target touched in the contact message, or
+// NULL if none of the contacts involve a target. The collision names are
+// read in place from the message so most contacts, which are with the ground
+// or the rover itself, are discarded without copying or allocating anything.
+physics::LinkPtr GripperPlugin::findContactTargetLink(ConstContactsPtr& msg){
+  for(int i=0; i < msg->contact_size(); i++){
+    const msgs::Contact& contact = msg->contact(i);
+
+    physics::LinkPtr targetLink = lookUpTargetLink(contact.collision1());
+    if (!targetLink)
+      targetLink = lookUpTargetLink(contact.collision2());
+
+    if (targetLink)
+      return targetLink;
+  }
+
+  return physics::LinkPtr();
+}
+
+// Target model names start with "at". The link is looked up in the world the
+// first time a target collision is seen and cached after that.
+physics::LinkPtr GripperPlugin::lookUpTargetLink(const string& collisionName){
+  if (collisionName.compare(0, 2, "at") != 0)
+    return physics::LinkPtr();
+
+  unordered_map<string, physics::LinkPtr>::const_iterator cached = targetLinks.find(collisionName);
+  if (cached != targetLinks.end())
+    return cached->second;
+
+  // Parse the collision name to find the model name (approporate GetChildLink accerros not available) This is a hacky way around that.
+  physics::ModelPtr modelInCollision = model->GetWorld()->GetModel(collisionName.substr(0, collisionName.find("::")));
+  if (!modelInCollision)
+    return physics::LinkPtr();
+
+  physics::LinkPtr targetLink = modelInCollision->GetLink("link");
+  if (targetLink)
+    targetLinks[collisionName] = targetLink;
+
+  return targetLink;
+}
+
 void GripperPlugin::sendInfoLogMessage(string text) {
  std_msgs::String msg;
  msg.data = model->GetName() + ": " + text;
@@ -829,6 +860,12 @@ GripperPlugin::~GripperPlugin() {
   
   rosNode->shutdown(); // Shutdown the ROS node
 
+  // The subscriptions are gone, so no more callbacks for this plugin can run
+  // on the shared queue
+  if (rosQueue) {
+    RosCallbackExecutor::instance().release();
+  }
+
   // Stop the multi threaded ROS spinner
   gazebo::shutdown();
 }
@@ -6,12 +6,12 @@
 #include <gazebo/msgs/msgs.hh>
 #include <gazebo/physics/physics.hh>
 #include <ros/ros.h>
-#include <ros/callback_queue.h>
 #include <std_msgs/Float32.h>
-#include <thread>
 #include "GripperManager.h"
+#include "RosCallbackExecutor.h"
 #include <string>
 #include <mutex>
+#include <unordered_map>
 
 /**
  * This class implements a gripper plugin for the NASA Swarmathon Rovers.
@@ -47,7 +47,7 @@ namespace gazebo {
       void Load(gazebo::physics::ModelPtr parent, sdf::ElementPtr sdf);
 
       // Gazebo actuation function
-      void updateWorldEventHandler();
+      void updateWorldEventHandler(const common::UpdateInfo& info);
       void updateGraspedStaticTargetPose();
       
       // ROS topic handlers
@@ -62,26 +62,34 @@ namespace gazebo {
     private:
 
       // private helper functions
-      void processRosQueue();
       void loadDebugMode();
       void loadUpdatePeriod();
       std::string loadSubscriptionTopic(std::string topicTag);
       physics::JointPtr loadJoint(std::string jointTag);
       PIDController::PIDSettings loadPIDSettings(std::string PIDTag);
       void handleGrasping();
+      int updatePeriodInSteps();
+      bool isAtSetPoint(const GripperManager::GripperState& currentState,
+        const GripperManager::GripperState& desiredState);
+      void printDebugState(const GripperManager::GripperState& currentState,
+        const GripperManager::GripperState& desiredState,
+        const GripperManager::GripperForces& commandForces);
 
       void attach();
       void detach();
 
+      physics::LinkPtr findContactTargetLink(ConstContactsPtr& msg);
+      physics::LinkPtr lookUpTargetLink(const std::string& collisionName);
+
       // pointers to gazebo model and xml configuration file
       physics::ModelPtr model;
       sdf::ElementPtr sdf;
 
-      // interface for processing ROS message queue
+      // interface for processing ROS message queue, which is shared with
+      // the other plugins through the RosCallbackExecutor
       event::ConnectionPtr updateConnection;
       std::unique_ptr<ros::NodeHandle> rosNode;
-      std::thread rosQueueThread;
-      ros::CallbackQueue rosQueue;
+      ros::CallbackQueue* rosQueue;
 
       // ROS subscribers
       ros::Subscriber wristAngleSubscriber;
@@ -102,8 +110,13 @@ namespace gazebo {
       physics::Model_V modelList;
 
       // time management variables
-      common::Time previousUpdateTime;
       float updatePeriodInSeconds;
+      // physics steps left before the next gripper update
+      int stepsUntilUpdate;
+
+      // joint angle error (in radians) within which the joints are considered
+      // settled and no forces are applied
+      float setPointTolerance;
 
       // debugging variables
       common::Time previousDebugUpdateTime;
@@ -159,6 +172,11 @@ namespace gazebo {
       common::Time leftFingerNoContactTime;
       common::Time rightFingerNoContactTime;
 
+      // Target links by the full name of their collision as it appears in the
+      // contact messages. Only used by the contact handlers, which hold the
+      // attaching_mutex while they run.
+      std::unordered_map<std::string, physics::LinkPtr> targetLinks;
+
       // Target attach joint
       physics::JointPtr targetAttachJoint;
 
@@ -0,0 +1,49 @@
+#include "RosCallbackExecutor.h"
+
+using namespace std;
+
+RosCallbackExecutor::RosCallbackExecutor() : users(0) {
+}
+
+/**
+ * The executor is created on first use and lives until the process exits.
+ */
+RosCallbackExecutor& RosCallbackExecutor::instance() {
+  static RosCallbackExecutor executor;
+  return executor;
+}
+
+/**
+ * Registers a plugin with the executor and starts the thread pool if this is
+ * the first plugin. ROS must be initialized before this is called.
+ *
+ * @return The shared callback queue to pass in the plugin's SubscribeOptions.
+ */
+ros::CallbackQueue* RosCallbackExecutor::acquire() {
+  lock_guard<std::mutex> lock(mutex);
+
+  if (users++ == 0) {
+    // AsyncSpinner threads wait on the queue's condition variable rather
+    // than polling it
+    spinner.reset(new ros::AsyncSpinner(threadCount, &queue));
+    spinner->start();
+  }
+
+  return &queue;
+}
+
+/**
+ * Unregisters a plugin and stops the thread pool once no plugins are left.
+ */
+void RosCallbackExecutor::release() {
+  lock_guard<std::mutex> lock(mutex);
+
+  if (users == 0) {
+    return;
+  }
+
+  if (--users == 0) {
+    spinner->stop();
+    spinner.reset();
+  }
+}
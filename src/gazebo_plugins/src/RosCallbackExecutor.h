@@ -0,0 +1,48 @@
+#ifndef ROS_CALLBACK_EXECUTOR_H
+#define ROS_CALLBACK_EXECUTOR_H
+
+#include <ros/ros.h>
+#include <ros/callback_queue.h>
+#include <memory>
+#include <mutex>
+
+/**
+ * This class runs the ROS callbacks of every gazebo_plugins plugin loaded in
+ * the Gazebo process. The plugins subscribe with the one shared callback
+ * queue, and a small pool of threads serves it. The threads sleep on the
+ * queue's condition variable until a callback arrives, so each rover model no
+ * longer needs a thread of its own polling a private queue.
+ *
+ * <p>Plugins call acquire() when they load and release() when they unload.
+ * The pool is started for the first plugin and stopped after the last one.
+ * Subscriptions on the queue must be shut down before release() is called.
+ */
+class RosCallbackExecutor {
+
+  public:
+
+    // The executor shared by all plugins in this process
+    static RosCallbackExecutor& instance();
+
+    // Registers a plugin and returns the queue to subscribe with
+    ros::CallbackQueue* acquire();
+
+    // Unregisters a plugin
+    void release();
+
+  private:
+
+    RosCallbackExecutor();
+    RosCallbackExecutor(const RosCallbackExecutor&);
+    RosCallbackExecutor& operator=(const RosCallbackExecutor&);
+
+    // Number of threads serving the queue
+    static const int threadCount = 2;
+
+    std::mutex mutex;
+    int users;
+    ros::CallbackQueue queue;
+    std::unique_ptr<ros::AsyncSpinner> spinner;
+};
+
+#endif /* ROS_CALLBACK_EXECUTOR_H */
@@ -12,6 +12,16 @@ namespace gazebo
 {
   class SetupWorld : public WorldPlugin
   {
+    // The physics settings can be overridden in the plugin element of the
+    // world file, for example to run batches of experiments faster than real
+    // time:
+    //
+    // <plugin name="SetupWorld" filename="libgazebo_plugins.so">
+    //   <maxStepSize>0.001</maxStepSize>              <!-- seconds per physics step -->
+    //   <realTimeUpdateRate>1000</realTimeUpdateRate> <!-- steps per second, 0 runs as fast as possible -->
+    //   <solverIterations>50</solverIterations>       <!-- ODE solver iterations per step -->
+    //   <islandThreads>0</islandThreads>              <!-- ODE threads for independent islands, 0 is serial -->
+    // </plugin>
     public: void Load(physics::WorldPtr _parent, sdf::ElementPtr _sdf)
     {
       cout << "Setting up world..." << flush;
@@ -30,17 +40,54 @@ namespace gazebo
       physicsMsg.set_type(msgs::Physics::ODE);
 
       // Set the step time
-      physicsMsg.set_max_step_size(0.001);
+      double maxStepSize = getParameter<double>(_sdf, "maxStepSize", 0.001);
+      if (maxStepSize <= 0) {
+        cerr << " maxStepSize must be > 0, using 0.001..." << flush;
+        maxStepSize = 0.001;
+      }
+      physicsMsg.set_max_step_size(maxStepSize);
 
-      // Set the real time update rate
-      physicsMsg.set_real_time_update_rate(1000.0);
+      // Set the real time update rate, 0 means as fast as possible
+      double realTimeUpdateRate = getParameter<double>(_sdf, "realTimeUpdateRate", 1000.0);
+      if (realTimeUpdateRate < 0) {
+        cerr << " realTimeUpdateRate must be >= 0, using 1000..." << flush;
+        realTimeUpdateRate = 1000.0;
+      }
+      physicsMsg.set_real_time_update_rate(realTimeUpdateRate);
+
+      // Trade contact accuracy for speed with fewer solver iterations
+      if (_sdf && _sdf->HasElement("solverIterations")) {
+        physicsMsg.set_iters(getParameter<int>(_sdf, "solverIterations", 50));
+      }
 
       // Change gravity
       //msgs::Set(physicsMsg.mutable_gravity(), math::Vector3(0.01, 0, 0.1));
       
       physicsPub->Publish(physicsMsg);
 
-      cout << " done." << endl;
+      // Threading has no field in the physics message so it is set on the
+      // engine directly. Gazebo versions without island threading ignore it.
+      if (_sdf && _sdf->HasElement("islandThreads")) {
+        _parent->GetPhysicsEngine()->SetParam("island_threads", getParameter<int>(_sdf, "islandThreads", 0));
+      }
+
+      cout << " done (step " << maxStepSize << " s, ";
+      if (realTimeUpdateRate == 0) {
+        cout << "as fast as possible)." << endl;
+      } else {
+        cout << "target " << maxStepSize * realTimeUpdateRate << "x real time)." << endl;
+      }
+    }
+
+    // Reads a value from the plugin element or returns the default if it is not set
+    private: template <typename T>
+    T getParameter(sdf::ElementPtr _sdf, const string &_name, T _default)
+    {
+      if (!_sdf || !_sdf->HasElement(_name)) {
+        return _default;
+      }
+
+      return _sdf->GetElement(_name)->Get<T>();
     }
   };
 
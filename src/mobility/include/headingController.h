@@ -0,0 +1,37 @@
+#ifndef HEADINGCONTROLLER_H
+#define	HEADINGCONTROLLER_H
+
+// PID on a heading error, modelled on the PIDController of the gripper plugin
+// but without ROS so the offline benchmark can use it. Errors are wrapped to
+// [-pi, pi], and the integral stops growing while the output is saturated.
+class HeadingController {
+public:
+
+    struct PIDSettings {
+        double Kp;
+        double Ki;
+        double Kd;
+        double max; // largest angular velocity returned, rad/s
+        double min; // most negative angular velocity returned, rad/s
+    };
+
+    HeadingController();
+    HeadingController(const PIDSettings& settings);
+
+    // Returns the angular velocity that turns currentHeading toward
+    // goalHeading. dt is the time since the previous update; the derivative
+    // and integral terms are skipped when it is not positive.
+    double update(double goalHeading, double currentHeading, double dt);
+
+    // Forgets the integral and previous error, for a new goal
+    void reset();
+
+private:
+
+    PIDSettings settings;
+    double previousError;
+    double integral;
+    bool hasPreviousError;
+};
+
+#endif	/* HEADINGCONTROLLER_H */
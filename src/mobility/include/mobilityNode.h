@@ -0,0 +1,20 @@
+#ifndef MOBILITYNODE_H
+#define	MOBILITYNODE_H
+
+#include <ros/ros.h>
+
+#include <string>
+
+// Entry points shared by the mobility node and the mobility nodelet. The node
+// state is global, so a process hosts at most one mobility instance.
+namespace mobility {
+
+    // Reads the parameters from param and sets up the subscribers, publishers
+    // and timers of the rover publishedName through nodeHandle
+    void start(ros::NodeHandle& nodeHandle, ros::NodeHandle& param, const std::string& publishedName);
+
+    // Shuts down everything start created, before a nodelet is unloaded
+    void stop();
+}
+
+#endif	/* MOBILITYNODE_H */
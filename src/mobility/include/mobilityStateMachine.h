@@ -0,0 +1,159 @@
+#ifndef MOBILITYSTATEMACHINE_H
+#define	MOBILITYSTATEMACHINE_H
+
+#include <random>
+#include <vector>
+
+#include "headingController.h"
+#include "targetMemory.h"
+
+// Position and heading of the rover in the odom frame
+struct MobilityPose {
+    double x;
+    double y;
+    double theta;
+
+    MobilityPose() : x(0.0), y(0.0), theta(0.0) {}
+    MobilityPose(double x, double y, double theta) : x(x), y(y), theta(theta) {}
+};
+
+// Commands produced by the state machine. Only the fields whose has flag is
+// set should be sent to the rover. goalChanged asks the caller to run step
+// right away instead of waiting for the next control period.
+struct MobilityOutput {
+    bool hasVelocity;
+    double linearVelocity;
+    double angularVelocity;
+
+    bool hasFingerAngle;
+    double fingerAngle;
+
+    bool hasWristAngle;
+    double wristAngle;
+
+    bool goalChanged;
+
+    MobilityOutput() { clear(); }
+    void clear();
+    void setVelocity(double linear, double angular);
+    void setFingerAngle(double angle);
+    void setWristAngle(double angle);
+};
+
+// A tag seen by the camera, with its position in the odom frame
+struct TargetSighting {
+    int id;
+    double x;
+    double y;
+
+    TargetSighting(int id, double x, double y) : id(id), x(x), y(y) {}
+};
+
+// Tunable values of the random search. The defaults are the values the
+// mobility node has always used.
+struct MobilitySettings {
+    double translateSpeed;        // m/s while driving to a goal
+    double rotateSpeed;           // rad/s while turning in place
+    double headingTolerance;      // rad of heading error accepted before driving
+    double searchStepDistance;    // m between random search goals
+    double searchHeadingStdDev;   // rad, spread of the next search heading
+    double obstacleTurn;          // rad turned away from an obstacle
+    double homeRadius;            // m from the center where targets are dropped
+    double targetApproachOffset;  // m short of a target the goal is placed
+    double targetTimeout;         // s before an unreached target is given up
+    double minObstacleSpeedScale; // slowest fraction of translateSpeed near obstacles
+    double obstacleFieldTimeout;  // s before an old obstacle proximity is ignored
+
+    // Closed loop driving steers toward the goal with a PID on the heading
+    // error while moving, instead of stopping to turn in place
+    bool closedLoop;
+    double steerAngle;            // rad of heading error the rover still drives through
+    double maxAngularSpeed;       // rad/s limit of the heading PID
+    double headingKp;
+    double headingKi;
+    double headingKd;
+
+    // Target memory keeps every tag seen and sends the rover back to the
+    // nearest remembered one instead of searching at random
+    bool rememberTargets;
+    double targetMergeRadius;     // m within which sightings are the same tag
+
+    MobilitySettings();
+};
+
+// The random search behaviour of the mobility node without any ROS
+// dependencies. The caller feeds in pose, obstacle and target observations
+// and calls step once per control period, sending the returned commands to
+// the rover. Times are in seconds on any monotonic clock.
+class MobilityStateMachine {
+public:
+
+    enum State { STATE_TRANSFORM, STATE_ROTATE, STATE_TRANSLATE };
+
+    MobilityStateMachine(unsigned int seed, const MobilitySettings& settings = MobilitySettings());
+
+    // Mode published by the GUI. 0 and 1 are manual, 2 and 3 autonomous.
+    void setMode(int mode);
+    int getMode() const { return mode; }
+    bool isAutonomous() const { return mode == 2 || mode == 3; }
+
+    void setPose(const MobilityPose& pose);
+
+    // Obstacle state from obstacle_detection: 1 on the right, 2 in front or left
+    MobilityOutput obstacleDetected(int obstacle);
+
+    // Closest obstacle proximity, 0 clear to 1 at the collision distance
+    void setObstacleProximity(double proximity, double now);
+
+    // A target is close enough to the camera to be in the gripper
+    MobilityOutput targetInGripper();
+
+    // A target with the given tag id was seen at (x, y) in the odom frame
+    MobilityOutput targetSeen(int id, double x, double y, double now);
+
+    // All tags of one camera frame
+    MobilityOutput targetsSeen(const std::vector<TargetSighting>& sightings, double now);
+
+    // Runs one iteration of the state machine
+    MobilityOutput step(double now);
+
+    // Name of the behaviour chosen by the last step, for the GUI
+    const char* stateName() const { return currentStateName; }
+
+    State getState() const { return state; }
+    const MobilityPose& getGoal() const { return goal; }
+    bool isCarryingTarget() const { return targetCollected; }
+    bool isTargetDetected() const { return targetDetected; }
+    const TargetMemory& getTargetMemory() const { return memory; }
+
+    static const int homeTagId = 256;
+
+private:
+
+    MobilitySettings settings;
+    std::mt19937 rng;
+
+    int mode;
+    State state;
+    MobilityPose current;
+    MobilityPose goal;
+    bool targetDetected;
+    bool targetCollected;
+    double targetDetectedUntil;
+    double obstacleProximity;
+    double obstacleProximityTime;
+    const char* currentStateName;
+
+    HeadingController headingController;
+    double lastStepTime;
+
+    TargetMemory memory;
+    int approachKey; // remembered target the current goal leads to, or -1
+
+    bool goalAhead() const;
+    double rotateTolerance() const;
+    void setApproachGoal(double x, double y);
+    bool goToRememberedTarget();
+};
+
+#endif	/* MOBILITYSTATEMACHINE_H */
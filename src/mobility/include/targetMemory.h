@@ -0,0 +1,63 @@
+#ifndef TARGETMEMORY_H
+#define	TARGETMEMORY_H
+
+#include <unordered_map>
+#include <vector>
+
+// A target position in the odom frame with when it was seen
+struct RememberedTarget {
+    double x;
+    double y;
+    double firstSeen;
+    double lastSeen;
+    int sightings;
+};
+
+// Remembers where targets were seen so the rover can return to them. Sightings
+// within mergeRadius of a remembered target are treated as the same tag and
+// refine its position. Positions are bucketed in a uniform grid of cellSize
+// so nearest queries only visit cells close to the query point.
+class TargetMemory {
+public:
+
+    TargetMemory(double mergeRadius = 0.1, double cellSize = 1.0);
+
+    // Records a sighting and returns the key of the target it was merged into
+    int observe(double x, double y, double now);
+
+    // Key of the remembered target closest to (x, y), or -1 if there is none
+    int nearest(double x, double y) const;
+
+    // Same as nearest but only considers targets within radius
+    int nearestWithin(double x, double y, double radius) const;
+
+    // Drops a target that was collected or is no longer where it was seen
+    void forget(int key);
+
+    const RememberedTarget& get(int key) const { return targets[key]; }
+    bool contains(int key) const { return key >= 0 && key < (int) targets.size() && active[key]; }
+    int size() const { return activeCount; }
+    void clear();
+
+private:
+
+    typedef long long CellKey;
+
+    double mergeRadius;
+    double cellSize;
+
+    std::vector<RememberedTarget> targets;
+    std::vector<bool> active;
+    std::vector<int> freeKeys;
+    int activeCount;
+
+    std::unordered_map<CellKey, std::vector<int> > cells;
+    int minCellX, maxCellX, minCellY, maxCellY;
+
+    int cellCoordinate(double value) const;
+    CellKey cellKey(int cellX, int cellY) const;
+    void insertIntoCell(int key);
+    void removeFromCell(int key);
+};
+
+#endif	/* TARGETMEMORY_H */
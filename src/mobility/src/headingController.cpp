@@ -0,0 +1,54 @@
+#include "headingController.h"
+
+#include <math.h>
+
+HeadingController::HeadingController() {
+    settings.Kp = 0.0;
+    settings.Ki = 0.0;
+    settings.Kd = 0.0;
+    settings.max = 0.0;
+    settings.min = 0.0;
+    reset();
+}
+
+HeadingController::HeadingController(const PIDSettings& settings) : settings(settings) {
+    reset();
+}
+
+double HeadingController::update(double goalHeading, double currentHeading, double dt) {
+    //wrap the error so the rover always turns the short way around
+    double error = remainder(goalHeading - currentHeading, 2.0 * M_PI);
+
+    double proportionalTerm = settings.Kp * error;
+
+    double derivativeTerm = 0.0;
+    if (dt > 0.0 && hasPreviousError) {
+        derivativeTerm = settings.Kd * remainder(error - previousError, 2.0 * M_PI) / dt;
+    }
+
+    double candidateIntegral = integral;
+    if (dt > 0.0) {
+        candidateIntegral += error * dt;
+    }
+
+    double output = proportionalTerm + derivativeTerm + settings.Ki * candidateIntegral;
+
+    //only accumulate the integral while the output is within its limits
+    if (output > settings.max) {
+        output = settings.max;
+    } else if (output < settings.min) {
+        output = settings.min;
+    } else {
+        integral = candidateIntegral;
+    }
+
+    previousError = error;
+    hasPreviousError = true;
+    return output;
+}
+
+void HeadingController::reset() {
+    previousError = 0.0;
+    integral = 0.0;
+    hasPreviousError = false;
+}
@@ -1,8 +1,6 @@
 #include <ros/ros.h>
 
 //ROS libraries
-#include <angles/angles.h>
-#include <random_numbers/random_numbers.h>
 #include <tf/transform_datatypes.h>
 #include <tf/transform_listener.h>
 
@@ -11,52 +9,42 @@
 #include <std_msgs/Int16.h>
 #include <std_msgs/UInt8.h>
 #include <std_msgs/String.h>
+#include <std_msgs/Float32MultiArray.h>
+#include <std_msgs/Float64MultiArray.h>
 #include <sensor_msgs/Joy.h>
 #include <sensor_msgs/Range.h>
-#include <geometry_msgs/Pose2D.h>
 #include <geometry_msgs/Twist.h>
 #include <nav_msgs/Odometry.h>
 #include <apriltags_ros/AprilTagDetectionArray.h>
 
-// To handle shutdown signals so the node quits properly in response to "rosnode kill"
-#include <ros/ros.h>
-#include <signal.h>
+#include "mobilityNode.h"
+#include "mobilityStateMachine.h"
 
 using namespace std;
 
-//Random number generator
-random_numbers::RandomNumberGenerator* rng;	
+namespace mobility {
+
+//Search behaviour, shared with the offline mobility_benchmark
+MobilityStateMachine* stateMachine;
 
 //Mobility Logic Functions
 void setVelocity(double linearVel, double angularVel);
-void openFingers(); // Open fingers to 90 degrees
-void closeFingers();// Close fingers to 0 degrees
-void raiseWrist();  // Return wrist back to 0 degrees
-void lowerWrist();  // Lower wrist to 50 degrees
+void publishMobilityOutput(const MobilityOutput& output);
+void stepStateMachine();
 
 //Numeric Variables
-geometry_msgs::Pose2D currentLocation;
-geometry_msgs::Pose2D goalLocation;
 int currentMode = 0;
 float mobilityLoopTimeStep = 0.1; //time between the mobility loop calls
 float status_publish_interval = 1;
 float killSwitchTimeout = 10;
-bool targetDetected = false;
-bool targetCollected = false;
-
-// state machine states
-#define STATE_MACHINE_TRANSFORM	0
-#define STATE_MACHINE_ROTATE	1
-#define STATE_MACHINE_TRANSLATE	2
-int stateMachineState = STATE_MACHINE_TRANSFORM;
 
 geometry_msgs::Twist velocity;
-char host[128];
 string publishedName;
 char prev_state_machine[128];
 
 //Publishers
 ros::Publisher velocityPublish;
+ros::Publisher velocityTracePublish;
 ros::Publisher stateMachinePublish;
 ros::Publisher status_publisher;
 ros::Publisher fingerAnglePublish;
@@ -66,193 +54,169 @@ ros::Publisher infoLogPublisher;
 //Subscribers
 ros::Subscriber joySubscriber;
 ros::Subscriber modeSubscriber;
+ros::Subscriber allRoversModeSubscriber;
 ros::Subscriber targetSubscriber;
 ros::Subscriber obstacleSubscriber;
+ros::Subscriber obstacleFieldSubscriber;
+ros::Subscriber obstacleTraceSubscriber;
 ros::Subscriber odometrySubscriber;
 
+//Handle the subscribers, publishers and timers are created through
+ros::NodeHandle* mNH = NULL;
+
 //Timers
 ros::Timer stateMachineTimer;
 ros::Timer publish_status_timer;
 ros::Timer killSwitchTimer;
-ros::Timer targetDetectedTimer;
 
 //Transforms
 tf::TransformListener *tfListener;
 
-// OS Signal Handler
-void sigintEventHandler(int signal);
+// Detection waiting for the camera_link to odom transform. It is retried from
+// the state machine timer instead of blocking the callback queue.
+apriltags_ros::AprilTagDetectionArray::ConstPtr pendingTargets;
+ros::Time pendingTargetsTime;
+float targetTransformTimeout = 1.0; // seconds before a pending detection is dropped
+
+// Latency trace published by obstacle_detection just before an obstacle
+// message. It is extended and forwarded with the velocity command the obstacle
+// causes, see latencyTrace.h in abridge for the layout.
+std_msgs::Float64MultiArray::ConstPtr obstacleTrace;
+float traceMatchWindow = 0.05; // seconds, older traces belong to an earlier obstacle message
+ros::Time lastVelocityPublished;
+
+//Poses, tag sightings and pickups are appended to this file when the
+//record_file parameter is set, see pipelineReplayBenchmark.cpp for the format
+FILE* recordFile = NULL;
 
 //Callback handlers
 void joyCmdHandler(const sensor_msgs::Joy::ConstPtr& message);
 void modeHandler(const std_msgs::UInt8::ConstPtr& message);
 void targetHandler(const apriltags_ros::AprilTagDetectionArray::ConstPtr& tagInfo);
 void obstacleHandler(const std_msgs::UInt8::ConstPtr& message);
+void obstacleTraceHandler(const std_msgs::Float64MultiArray::ConstPtr& message);
+void obstacleFieldHandler(const std_msgs::Float32MultiArray::ConstPtr& message);
 void odometryHandler(const nav_msgs::Odometry::ConstPtr& message);
 void mobilityStateMachine(const ros::TimerEvent&);
+bool processTargets(const apriltags_ros::AprilTagDetectionArray::ConstPtr& message);
 void publishStatusTimerEventHandler(const ros::TimerEvent& event);
 void killSwitchTimerEventHandler(const ros::TimerEvent& event);
-void targetDetectedReset(const ros::TimerEvent& event);
-
-int main(int argc, char **argv) {
-
-    gethostname(host, sizeof (host));
-    string hostname(host);
 
-    rng = new random_numbers::RandomNumberGenerator(); //instantiate random number generator
-    goalLocation.theta = rng->uniformReal(0, 2 * M_PI); //set initial random heading
+void start(ros::NodeHandle& nodeHandle, ros::NodeHandle& param, const string& name) {
+    publishedName = name;
 
-    //select initial search position 50 cm from center (0,0)
-	goalLocation.x = 0.5 * cos(goalLocation.theta);
-	goalLocation.y = 0.5 * sin(goalLocation.theta);
+    //every handle is created through this copy so stop() can shut them all down
+    mNH = new ros::NodeHandle(nodeHandle);
 
-    if (argc >= 2) {
-        publishedName = argv[1];
-        cout << "Welcome to the world of tomorrow " << publishedName << "!  Mobility module started." << endl;
+    MobilitySettings settings;
+    string controller;
+    param.param("controller", controller, string("bang_bang"));
+    if (controller == "pid") {
+        settings.closedLoop = true;
+    } else if (controller != "bang_bang") {
+        cout << "Unknown controller " << controller << ", falling back to bang_bang" << endl;
+    }
+    double controlRate = 1.0 / mobilityLoopTimeStep;
+    param.param("control_rate", controlRate, controlRate);
+    if (controlRate > 0.0) {
+        mobilityLoopTimeStep = 1.0 / controlRate;
     } else {
-        publishedName = hostname;
-        cout << "No Name Selected. Default is: " << publishedName << endl;
+        cout << "control_rate must be positive, using " << 1.0 / mobilityLoopTimeStep << " Hz" << endl;
+    }
+    param.param("steer_angle", settings.steerAngle, settings.steerAngle);
+    param.param("max_angular_speed", settings.maxAngularSpeed, settings.maxAngularSpeed);
+    param.param("heading_kp", settings.headingKp, settings.headingKp);
+    param.param("heading_ki", settings.headingKi, settings.headingKi);
+    param.param("heading_kd", settings.headingKd, settings.headingKd);
+    param.param("target_memory", settings.rememberTargets, settings.rememberTargets);
+    param.param("target_merge_radius", settings.targetMergeRadius, settings.targetMergeRadius);
+    string recordPath;
+    param.param("record_file", recordPath, string(""));
+    if (!recordPath.empty()) {
+        recordFile = fopen(recordPath.c_str(), "a");
+        if (!recordFile) {
+            cout << "Could not open record_file " << recordPath << ", not recording" << endl;
+        }
     }
 
-    // NoSignalHandler so we can catch SIGINT ourselves and shutdown the node
-    ros::init(argc, argv, (publishedName + "_MOBILITY"), ros::init_options::NoSigintHandler);
-    ros::NodeHandle mNH;
-
-    signal(SIGINT, sigintEventHandler); // Register the SIGINT event handler so the node can shutdown properly
-
-    joySubscriber = mNH.subscribe((publishedName + "/joystick"), 10, joyCmdHandler);
-    modeSubscriber = mNH.subscribe((publishedName + "/mode"), 1, modeHandler);
-    targetSubscriber = mNH.subscribe((publishedName + "/targets"), 10, targetHandler);
-    obstacleSubscriber = mNH.subscribe((publishedName + "/obstacle"), 10, obstacleHandler);
-    odometrySubscriber = mNH.subscribe((publishedName + "/odom/filtered"), 10, odometryHandler);
-
-    status_publisher = mNH.advertise<std_msgs::String>((publishedName + "/status"), 1, true);
-    velocityPublish = mNH.advertise<geometry_msgs::Twist>((publishedName + "/velocity"), 10);
-    stateMachinePublish = mNH.advertise<std_msgs::String>((publishedName + "/state_machine"), 1, true);
-    fingerAnglePublish = mNH.advertise<std_msgs::Float32>((publishedName + "/fingerAngle"), 1, true);
-    wristAnglePublish = mNH.advertise<std_msgs::Float32>((publishedName + "/wristAngle"), 1, true);
-    infoLogPublisher = mNH.advertise<std_msgs::String>("/infoLog", 1, true);
-
-    publish_status_timer = mNH.createTimer(ros::Duration(status_publish_interval), publishStatusTimerEventHandler);
-    //killSwitchTimer = mNH.createTimer(ros::Duration(killSwitchTimeout), killSwitchTimerEventHandler);
-    stateMachineTimer = mNH.createTimer(ros::Duration(mobilityLoopTimeStep), mobilityStateMachine);
-    targetDetectedTimer = mNH.createTimer(ros::Duration(0), targetDetectedReset, true);
+    //seed the search from the wall clock so every rover follows a different path
+    stateMachine = new MobilityStateMachine(ros::WallTime::now().nsec, settings);
+
+    joySubscriber = mNH->subscribe((publishedName + "/joystick"), 10, joyCmdHandler);
+    //the GUI sends the rover's current mode on this topic when the node subscribes
+    modeSubscriber = mNH->subscribe((publishedName + "/mode"), 1, modeHandler);
+    //all stop and all autonomous from the GUI, one message for every rover
+    allRoversModeSubscriber = mNH->subscribe("/allRovers/mode", 1, modeHandler);
+    targetSubscriber = mNH->subscribe((publishedName + "/targets"), 10, targetHandler);
+    obstacleSubscriber = mNH->subscribe((publishedName + "/obstacle"), 10, obstacleHandler);
+    obstacleFieldSubscriber = mNH->subscribe((publishedName + "/obstacle_field"), 10, obstacleFieldHandler);
+    obstacleTraceSubscriber = mNH->subscribe((publishedName + "/obstacle/trace"), 10, obstacleTraceHandler);
+    odometrySubscriber = mNH->subscribe((publishedName + "/odom/filtered"), 10, odometryHandler);
+
+    status_publisher = mNH->advertise<std_msgs::String>((publishedName + "/status"), 1, true);
+    velocityPublish = mNH->advertise<geometry_msgs::Twist>((publishedName + "/velocity"), 10);
+    velocityTracePublish = mNH->advertise<std_msgs::Float64MultiArray>((publishedName + "/velocity/trace"), 10);
+    stateMachinePublish = mNH->advertise<std_msgs::String>((publishedName + "/state_machine"), 1, true);
+    fingerAnglePublish = mNH->advertise<std_msgs::Float32>((publishedName + "/fingerAngle"), 1, true);
+    wristAnglePublish = mNH->advertise<std_msgs::Float32>((publishedName + "/wristAngle"), 1, true);
+    infoLogPublisher = mNH->advertise<std_msgs::String>("/infoLog", 1, true);
+
+    publish_status_timer = mNH->createTimer(ros::Duration(status_publish_interval), publishStatusTimerEventHandler);
+    //killSwitchTimer = mNH->createTimer(ros::Duration(killSwitchTimeout), killSwitchTimerEventHandler);
+    stateMachineTimer = mNH->createTimer(ros::Duration(mobilityLoopTimeStep), mobilityStateMachine);
     
-    tfListener = new tf::TransformListener();
+    tfListener = new tf::TransformListener(*mNH);
 
     std_msgs::String msg;
     msg.data = "Log Started";
     infoLogPublisher.publish(msg);
-    ros::spin();
-    
-    return EXIT_SUCCESS;
+}
+
+void stop() {
+    if (!mNH) return;
+
+    publish_status_timer.stop();
+    killSwitchTimer.stop();
+    stateMachineTimer.stop();
+    mNH->shutdown();
+
+    delete tfListener;
+    delete stateMachine;
+    delete mNH;
+    tfListener = NULL;
+    stateMachine = NULL;
+    mNH = NULL;
+    pendingTargets.reset();
+    obstacleTrace.reset();
+
+    if (recordFile) {
+        fclose(recordFile);
+        recordFile = NULL;
+    }
 }
 
 void mobilityStateMachine(const ros::TimerEvent&) {
-    std_msgs::String stateMachineMsg;
-    
-    if (currentMode == 2 || currentMode == 3) { //Robot is in automode
-
-		switch(stateMachineState) {
-			
-			//Select rotation or translation based on required adjustment
-			//If no adjustment needed, select new goal
-			case STATE_MACHINE_TRANSFORM: {
-				stateMachineMsg.data = "TRANSFORMING";
-				//If angle between current and goal is significant
-				if (fabs(angles::shortest_angular_distance(currentLocation.theta, goalLocation.theta)) > 0.1) {
-					stateMachineState = STATE_MACHINE_ROTATE; //rotate
-				}
-				//If goal has not yet been reached
-				else if (fabs(angles::shortest_angular_distance(currentLocation.theta, atan2(goalLocation.y - currentLocation.y, goalLocation.x - currentLocation.x))) < M_PI_2) {
-					stateMachineState = STATE_MACHINE_TRANSLATE; //translate
-				}
-				//If returning with a target
-				else if (targetCollected) {
-					//If goal has not yet been reached
-					if (hypot(0.0 - currentLocation.x, 0.0 - currentLocation.y) > 0.5) {
-				        //set angle to center as goal heading
-						goalLocation.theta = M_PI + atan2(currentLocation.y, currentLocation.x);
-						
-						//set center as goal position
-						goalLocation.x = 0.0;
-						goalLocation.y = 0.0;
-					}
-					//Otherwise, drop off target and select new random uniform heading
-					else {
-						//open fingers
-						std_msgs::Float32 angle;
-						angle.data = M_PI_2;
-						fingerAnglePublish.publish(angle);
-						
-						//reset flag
-						targetCollected = false;
-						
-						goalLocation.theta = rng->uniformReal(0, 2 * M_PI);
-					}
-				}
-				//If no targets have been detected, assign a new goal
-				else if (!targetDetected) {
-					//select new heading from Gaussian distribution around current heading
-					goalLocation.theta = rng->gaussian(currentLocation.theta, 0.25);
-					
-					//select new position 50 cm from current location
-					goalLocation.x = currentLocation.x + (0.5 * cos(goalLocation.theta));
-					goalLocation.y = currentLocation.y + (0.5 * sin(goalLocation.theta));
-				}
-				
-				//Purposefully fall through to next case without breaking
-			}
-			
-			//Calculate angle between currentLocation.theta and goalLocation.theta
-			//Rotate left or right depending on sign of angle
-			//Stay in this state until angle is minimized
-			case STATE_MACHINE_ROTATE: {
-				stateMachineMsg.data = "ROTATING";
-			    if (angles::shortest_angular_distance(currentLocation.theta, goalLocation.theta) > 0.1) {
-					setVelocity(0.0, 0.2); //rotate left
-			    }
-			    else if (angles::shortest_angular_distance(currentLocation.theta, goalLocation.theta) < -0.1) {
-					setVelocity(0.0, -0.2); //rotate right
-				}
-				else {
-					setVelocity(0.0, 0.0); //stop
-					stateMachineState = STATE_MACHINE_TRANSLATE; //move to translate step
-				}
-			    break;
-			}
-			
-			//Calculate angle between currentLocation.x/y and goalLocation.x/y
-			//Drive forward
-			//Stay in this state until angle is at least PI/2
-			case STATE_MACHINE_TRANSLATE: {
-				stateMachineMsg.data = "TRANSLATING";
-				if (fabs(angles::shortest_angular_distance(currentLocation.theta, atan2(goalLocation.y - currentLocation.y, goalLocation.x - currentLocation.x))) < M_PI_2) {
-					setVelocity(0.3, 0.0);
-				}
-				else {
-					setVelocity(0.0, 0.0); //stop
-					
-					//close fingers
-					std_msgs::Float32 angle;
-					angle.data = 0;
-					fingerAnglePublish.publish(angle);
-					
-					stateMachineState = STATE_MACHINE_TRANSFORM; //move back to transform step
-				}
-			    break;
-			}
-		
-			default: {
-			    break;
-			}
-		}
-	}
+    //retry a detection that arrived before its transform was available
+    if (pendingTargets) {
+        if (processTargets(pendingTargets)) {
+            pendingTargets.reset();
+        }
+        else if ((ros::Time::now() - pendingTargetsTime).toSec() > targetTransformTimeout) {
+            ROS_INFO("Dropped a target detection, no transform from \"camera_link\" to \"odom\" after %.1f s", targetTransformTimeout);
+            pendingTargets.reset();
+        }
+    }
 
-    else { // mode is NOT auto
+    stepStateMachine();
+}
 
-        // publish current state for the operator to see
-        stateMachineMsg.data = "WAITING";
-    }
+// Runs the state machine once and publishes its commands. Called from the timer
+// and straight from the obstacle and target handlers when they change the goal.
+void stepStateMachine() {
+    std_msgs::String stateMachineMsg;
+
+    publishMobilityOutput(stateMachine->step(ros::Time::now().toSec()));
+    stateMachineMsg.data = stateMachine->stateName();
 
     // publish state machine string for user, only if it has changed, though
     if (strcmp(stateMachineMsg.data.c_str(), prev_state_machine) != 0) {
@@ -271,7 +235,32 @@ void setVelocity(double linearVel, double angularVel)
   
   velocity.linear.x = linearVel, // * 1.5;
   velocity.angular.z = angularVel; // * 8; //scaling factor for sim; removed by aBridge node
-  velocityPublish.publish(velocity);
+
+  // A fresh message per publish so a nodelet subscriber can keep the pointer
+  geometry_msgs::TwistPtr message(new geometry_msgs::Twist(velocity));
+  velocityPublish.publish(message);
+  lastVelocityPublished = ros::Time::now();
+}
+
+void publishMobilityOutput(const MobilityOutput& output) {
+	if (output.hasVelocity) {
+		setVelocity(output.linearVelocity, output.angularVelocity);
+	}
+
+	std_msgs::Float32 angle;
+	if (output.hasFingerAngle) {
+		angle.data = output.fingerAngle;
+		fingerAnglePublish.publish(angle);
+	}
+	if (output.hasWristAngle) {
+		angle.data = output.wristAngle;
+		wristAnglePublish.publish(angle);
+	}
+
+	//react to a new goal now instead of up to one timer period later
+	if (output.goalChanged) {
+		stepStateMachine();
+	}
 }
 
 /***********************
@@ -282,112 +271,122 @@ void targetHandler(const apriltags_ros::AprilTagDetectionArray::ConstPtr& messag
 
         // If in manual mode do not try to automatically pick up the target
         if (currentMode == 1) return;
- 
-	if (message->detections.size() > 0) {
-		
-		geometry_msgs::PoseStamped tagPose = message->detections[0].pose;
-		
+
+	//a newer detection replaces any that is still waiting for its transform
+	if (processTargets(message)) {
+		pendingTargets.reset();
+	}
+	else {
+		pendingTargets = message;
+		pendingTargetsTime = ros::Time::now();
+	}
+}
+
+// Returns false without blocking if the transform to odom is not available yet
+bool processTargets(const apriltags_ros::AprilTagDetectionArray::ConstPtr& message) {
+	if (message->detections.size() == 0) return true;
+
+	for (size_t i = 0; i < message->detections.size(); i++) {
+		const geometry_msgs::Point& position = message->detections[i].pose.pose.position;
+
 		//if target is close enough
-		if (hypot(hypot(tagPose.pose.position.x, tagPose.pose.position.y), tagPose.pose.position.z) < 0.2) {
+		if (hypot(hypot(position.x, position.y), position.z) < 0.2) {
 			//assume target has been picked up by gripper
-			targetCollected = true;
-			
-			//lower wrist to avoid ultrasound sensors
-			std_msgs::Float32 angle;
-			angle.data = M_PI_2/4;
-			wristAnglePublish.publish(angle);
-		}
-		
-		else {
-			tagPose.header.stamp = ros::Time(0);
-			geometry_msgs::PoseStamped odomPose;
-
-			try {
-				tfListener->waitForTransform(publishedName + "/odom", publishedName + "/camera_link", ros::Time(0), ros::Duration(1.0));
-				tfListener->transformPose(publishedName + "/odom", tagPose, odomPose);
+			if (recordFile) {
+				fprintf(recordFile, "%.6f gripper\n", ros::Time::now().toSec());
 			}
+			publishMobilityOutput(stateMachine->targetInGripper());
+			return true;
+		}
+	}
 
-			catch(tf::TransformException& ex) {
-				ROS_INFO("Received an exception trying to transform a point from \"odom\" to \"camera_link\": %s", ex.what());
-			}
+	if (!tfListener->canTransform(publishedName + "/odom", publishedName + "/camera_link", ros::Time(0))) {
+		return false;
+	}
 
-			//if this is the goal target
-			if (message->detections[0].id == 256) {
-				//open fingers to drop off target
-				std_msgs::Float32 angle;
-				angle.data = M_PI_2;
-				fingerAnglePublish.publish(angle);
-			}
+	//hand every tag in the frame to the state machine at once
+	vector<TargetSighting> sightings;
+	for (size_t i = 0; i < message->detections.size(); i++) {
+		geometry_msgs::PoseStamped tagPose = message->detections[i].pose;
+		tagPose.header.stamp = ros::Time(0);
+		geometry_msgs::PoseStamped odomPose;
 
-			//Otherwise, if no target has been collected, set target pose as goal
-			else if (!targetCollected) {
-				//set goal heading
-				goalLocation.theta = atan2(odomPose.pose.position.y - currentLocation.y, odomPose.pose.position.x - currentLocation.x);
-				
-				//set goal position
-				goalLocation.x = odomPose.pose.position.x - (0.26 * cos(goalLocation.theta));
-				goalLocation.y = odomPose.pose.position.y - (0.26 * sin(goalLocation.theta));
-				
-				//set gripper
-				std_msgs::Float32 angle;
-				//open fingers
-				angle.data = M_PI_2;
-				fingerAnglePublish.publish(angle);
-				//lower wrist
-				angle.data = 0.8;
-				wristAnglePublish.publish(angle);
-				
-				//set state and timeout
-				targetDetected = true;
-				targetDetectedTimer.setPeriod(ros::Duration(5.0));
-				targetDetectedTimer.start();
-				
-				//switch to transform state to trigger return to center
-				stateMachineState = STATE_MACHINE_TRANSFORM;
-			}
+		try {
+			tfListener->transformPose(publishedName + "/odom", tagPose, odomPose);
+		}
+
+		catch(tf::TransformException& ex) {
+			ROS_INFO("Received an exception trying to transform a point from \"odom\" to \"camera_link\": %s", ex.what());
+			continue;
+		}
+
+		sightings.push_back(TargetSighting(message->detections[i].id, odomPose.pose.position.x, odomPose.pose.position.y));
+	}
+
+	if (recordFile && !sightings.empty()) {
+		fprintf(recordFile, "%.6f tags", ros::Time::now().toSec());
+		for (size_t i = 0; i < sightings.size(); i++) {
+			fprintf(recordFile, " %d %.4f %.4f", sightings[i].id, sightings[i].x, sightings[i].y);
 		}
+		fputc('\n', recordFile);
 	}
+
+	if (!sightings.empty()) {
+		publishMobilityOutput(stateMachine->targetsSeen(sightings, ros::Time::now().toSec()));
+	}
+	return true;
 }
 
 void modeHandler(const std_msgs::UInt8::ConstPtr& message) {
 	currentMode = message->data;
+	stateMachine->setMode(currentMode);
 	setVelocity(0.0, 0.0);
 }
 
 void obstacleHandler(const std_msgs::UInt8::ConstPtr& message) {
-	if (!targetDetected && (message->data > 0)) {
-		//obstacle on right side
-		if (message->data == 1) {
-			//select new heading 0.2 radians to the left
-			goalLocation.theta = currentLocation.theta + 0.2;
-		}
-		
-		//obstacle in front or on left side
-		else if (message->data == 2) {
-			//select new heading 0.2 radians to the right
-			goalLocation.theta = currentLocation.theta - 0.2;
-		}
-							
-		//select new position 50 cm from current location
-		goalLocation.x = currentLocation.x + (0.5 * cos(goalLocation.theta));
-		goalLocation.y = currentLocation.y + (0.5 * sin(goalLocation.theta));
-		
-		//switch to transform state to trigger collision avoidance
-		stateMachineState = STATE_MACHINE_TRANSFORM;
+	ros::Time received = ros::Time::now();
+
+	//pair the message with the trace sent just before it, each trace is used once
+	std_msgs::Float64MultiArrayPtr trace;
+	if (obstacleTrace && obstacleTrace->data.size() == 3 && received.toSec() - obstacleTrace->data[2] < traceMatchWindow) {
+		trace.reset(new std_msgs::Float64MultiArray(*obstacleTrace));
+		trace->data.push_back(received.toSec());
+	}
+	obstacleTrace.reset();
+
+	publishMobilityOutput(stateMachine->obstacleDetected(message->data));
+
+	//only an obstacle that changed the velocity command completes its trace
+	if (trace && lastVelocityPublished >= received) {
+		trace->data.push_back(lastVelocityPublished.toSec());
+		velocityTracePublish.publish(trace);
 	}
 }
 
+void obstacleTraceHandler(const std_msgs::Float64MultiArray::ConstPtr& message) {
+	obstacleTrace = message;
+}
+
+void obstacleFieldHandler(const std_msgs::Float32MultiArray::ConstPtr& message) {
+	if (message->data.size() < 6) return;
+
+	//proximities are stored after the three ranges
+	stateMachine->setObstacleProximity(max(message->data[3], max(message->data[4], message->data[5])), ros::Time::now().toSec());
+}
+
 void odometryHandler(const nav_msgs::Odometry::ConstPtr& message) {
-	//Get (x,y) location directly from pose
-	currentLocation.x = message->pose.pose.position.x;
-	currentLocation.y = message->pose.pose.position.y;
-	
 	//Get theta rotation by converting quaternion orientation to pitch/roll/yaw
 	tf::Quaternion q(message->pose.pose.orientation.x, message->pose.pose.orientation.y, message->pose.pose.orientation.z, message->pose.pose.orientation.w);
 	tf::Matrix3x3 m(q);
 	double roll, pitch, yaw;
 	m.getRPY(roll, pitch, yaw);
-	currentLocation.theta = yaw;
+
+	//Get (x,y) location directly from pose
+	stateMachine->setPose(MobilityPose(message->pose.pose.position.x, message->pose.pose.position.y, yaw));
+
+	if (recordFile) {
+		fprintf(recordFile, "%.6f pose %.4f %.4f %.4f\n", ros::Time::now().toSec(), message->pose.pose.position.x, message->pose.pose.position.y, yaw);
+	}
 }
 
 void joyCmdHandler(const sensor_msgs::Joy::ConstPtr& message) {
@@ -414,17 +413,4 @@ void killSwitchTimerEventHandler(const ros::TimerEvent& t)
   ROS_INFO("In mobility.cpp:: killSwitchTimerEventHander(): Movement input timeout. Stopping the rover at %6.4f.", current_time);
 }
 
-void targetDetectedReset(const ros::TimerEvent& event) {
-	targetDetected = false;
-	
-	std_msgs::Float32 angle;
-	angle.data = 0;
-	fingerAnglePublish.publish(angle); //close fingers
-	wristAnglePublish.publish(angle); //raise wrist
-}
-
-void sigintEventHandler(int sig)
-{
-     // All the default sigint handler does is call shutdown()
-     ros::shutdown();
-}
+} // namespace mobility
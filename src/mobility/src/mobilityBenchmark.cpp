@@ -0,0 +1,212 @@
+// Headless harness that steps the mobility state machine for many simulated
+// rovers at once, without ROS or Gazebo. Each rover searches its own square
+// arena with randomly placed targets, using simple unicycle kinematics, a
+// forward facing camera cone and a wall proximity sensor. The same arenas are
+// run with the original bang-bang driving, the heading PID and the heading PID
+// with target memory, for uniform and clustered target layouts.
+// Run with: mobility_benchmark [rovers] [simulated seconds] [targets per arena] [seed]
+
+#include <mobilityStateMachine.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+static const double arenaHalfWidth = 7.5;    // m, preliminary round arena
+static const double cameraRange = 1.0;       // m at which tags are detected
+static const double cameraHalfAngle = 0.5;   // rad either side of the heading
+static const double pickupDistance = 0.3;    // m at which a target is in the gripper
+static const double cameraPeriod = 0.5;      // s between tag detections
+static const double obstacleDistance = 0.4;  // m from a wall that triggers avoidance
+static const double proximityRange = 1.0;    // m from a wall where slowing starts
+static const double cubeSpacing = 0.1;       // m between cubes in a cluster, as placed by the GUI
+static const int clusterCount = 4;
+
+struct SimTarget {
+    double x;
+    double y;
+    bool collected;
+};
+
+struct SimRover {
+    MobilityStateMachine stateMachine;
+    MobilityPose pose;
+    double linearVelocity;
+    double angularVelocity;
+    vector<SimTarget> targets;
+    int carriedTarget;
+    int delivered;
+
+    SimRover(unsigned int seed, const MobilitySettings& settings) : stateMachine(seed, settings), linearVelocity(0.0), angularVelocity(0.0),
+        carriedTarget(-1), delivered(0) {
+    }
+};
+
+static void applyOutput(SimRover& rover, const MobilityOutput& output) {
+    if (output.hasVelocity) {
+        rover.linearVelocity = output.linearVelocity;
+        rover.angularVelocity = output.angularVelocity;
+    }
+}
+
+struct SimResult {
+    double seconds;
+    long roverSteps;
+    double deliveredPerRover;
+};
+
+static void stepRover(SimRover& rover, long step, double timeStep, int cameraSteps) {
+    double now = step * timeStep;
+    MobilityPose& pose = rover.pose;
+
+    // integrate the last commanded velocity
+    pose.theta += rover.angularVelocity * timeStep;
+    pose.x += rover.linearVelocity * cos(pose.theta) * timeStep;
+    pose.y += rover.linearVelocity * sin(pose.theta) * timeStep;
+    pose.x = max(-arenaHalfWidth, min(pose.x, arenaHalfWidth));
+    pose.y = max(-arenaHalfWidth, min(pose.y, arenaHalfWidth));
+    rover.stateMachine.setPose(pose);
+
+    // distance to the wall straight ahead stands in for the center sonar
+    double wallAhead = 1e9;
+    double c = cos(pose.theta), s = sin(pose.theta);
+    if (c > 1e-6) wallAhead = min(wallAhead, (arenaHalfWidth - pose.x) / c);
+    if (c < -1e-6) wallAhead = min(wallAhead, (-arenaHalfWidth - pose.x) / c);
+    if (s > 1e-6) wallAhead = min(wallAhead, (arenaHalfWidth - pose.y) / s);
+    if (s < -1e-6) wallAhead = min(wallAhead, (-arenaHalfWidth - pose.y) / s);
+    rover.stateMachine.setObstacleProximity(max(0.0, min(1.0, (proximityRange - wallAhead) / (proximityRange - obstacleDistance))), now);
+    if (wallAhead < obstacleDistance) {
+        applyOutput(rover, rover.stateMachine.obstacleDetected(2));
+    }
+
+    // report every target inside the camera cone at the tag detection rate
+    if (rover.carriedTarget < 0 && step % cameraSteps == 0) {
+        vector<TargetSighting> sightings;
+        int nearest = -1;
+        double nearestDistance = cameraRange;
+        for (size_t i = 0; i < rover.targets.size(); i++) {
+            const SimTarget& target = rover.targets[i];
+            if (target.collected) continue;
+            double dx = target.x - pose.x, dy = target.y - pose.y;
+            double distance = hypot(dx, dy);
+            double bearing = remainder(atan2(dy, dx) - pose.theta, 2.0 * M_PI);
+            if (distance < cameraRange && fabs(bearing) < cameraHalfAngle) {
+                sightings.push_back(TargetSighting(i, target.x, target.y));
+                if (distance < nearestDistance) {
+                    nearest = i;
+                    nearestDistance = distance;
+                }
+            }
+        }
+        if (nearest >= 0 && nearestDistance < pickupDistance) {
+            rover.carriedTarget = nearest;
+            rover.targets[nearest].collected = true;
+            applyOutput(rover, rover.stateMachine.targetInGripper());
+        } else if (!sightings.empty()) {
+            applyOutput(rover, rover.stateMachine.targetsSeen(sightings, now));
+        }
+    }
+
+    applyOutput(rover, rover.stateMachine.step(now));
+
+    // the state machine drops the target once it is back at the center
+    if (rover.carriedTarget >= 0 && !rover.stateMachine.isCarryingTarget()) {
+        rover.carriedTarget = -1;
+        rover.delivered++;
+    }
+}
+
+// Single targets anywhere, or square piles like the GUI's addClusteredTargets
+static void placeTargets(SimRover& rover, int targetCount, bool clustered, mt19937& rng) {
+    uniform_real_distribution<double> position(-arenaHalfWidth + 1.0, arenaHalfWidth - 1.0);
+
+    int pileSize = clustered ? (targetCount + clusterCount - 1) / clusterCount : 1;
+    int pileWidth = (int) ceil(sqrt((double) pileSize));
+    while ((int) rover.targets.size() < targetCount) {
+        double x, y;
+        do {
+            x = position(rng);
+            y = position(rng);
+        } while (hypot(x, y) < 1.0); // keep the nest clear
+
+        for (int i = 0; i < pileSize && (int) rover.targets.size() < targetCount; i++) {
+            SimTarget target;
+            target.x = x + (i % pileWidth) * cubeSpacing;
+            target.y = y + (i / pileWidth) * cubeSpacing;
+            target.collected = false;
+            rover.targets.push_back(target);
+        }
+    }
+}
+
+static SimResult runSimulation(const MobilitySettings& settings, double timeStep, int roverCount, double duration,
+    int targetCount, bool clustered, unsigned int seed) {
+    mt19937 rng(seed);
+
+    vector<SimRover> rovers;
+    rovers.reserve(roverCount);
+    for (int i = 0; i < roverCount; i++) {
+        rovers.push_back(SimRover(rng(), settings));
+        SimRover& rover = rovers.back();
+        rover.stateMachine.setMode(2);
+        placeTargets(rover, targetCount, clustered, rng);
+    }
+
+    long steps = (long) (duration / timeStep);
+    int cameraSteps = max(1, (int) (cameraPeriod / timeStep + 0.5));
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (long step = 0; step < steps; step++) {
+        for (int i = 0; i < roverCount; i++) {
+            stepRover(rovers[i], step, timeStep, cameraSteps);
+        }
+    }
+    chrono::steady_clock::time_point end = chrono::steady_clock::now();
+
+    SimResult result;
+    result.seconds = chrono::duration_cast<chrono::microseconds>(end - start).count() / 1e6;
+    result.roverSteps = steps * roverCount;
+    long delivered = 0;
+    for (int i = 0; i < roverCount; i++) {
+        delivered += rovers[i].delivered;
+    }
+    result.deliveredPerRover = delivered / (double) roverCount;
+    return result;
+}
+
+static void printResult(const char* name, const SimResult& result, int roverCount, double duration) {
+    printf("  %-16s %12.0f rover steps/s %10.0fx real time %8.2f targets per rover\n", name,
+        result.roverSteps / result.seconds, roverCount * duration / result.seconds, result.deliveredPerRover);
+}
+
+int main(int argc, char** argv) {
+    int roverCount = (argc >= 2) ? atoi(argv[1]) : 1000;
+    double duration = (argc >= 3) ? atof(argv[2]) : 600.0;
+    int targetCount = (argc >= 4) ? atoi(argv[3]) : 64;
+    unsigned int seed = (argc >= 5) ? atoi(argv[4]) : 1;
+
+    MobilitySettings bangBang;
+    bangBang.rememberTargets = false;
+    MobilitySettings pid;
+    pid.closedLoop = true;
+    pid.rememberTargets = false;
+    MobilitySettings pidMemory;
+    pidMemory.closedLoop = true;
+
+    for (int layout = 0; layout < 2; layout++) {
+        bool clustered = (layout == 1);
+        printf("Simulating %d rovers for %.0f s with %d %s targets each\n", roverCount, duration, targetCount,
+            clustered ? "clustered" : "uniform");
+        printResult("bang-bang 10 Hz", runSimulation(bangBang, 0.1, roverCount, duration, targetCount, clustered, seed), roverCount, duration);
+        printResult("pid 10 Hz", runSimulation(pid, 0.1, roverCount, duration, targetCount, clustered, seed), roverCount, duration);
+        printResult("pid 20 Hz", runSimulation(pid, 0.05, roverCount, duration, targetCount, clustered, seed), roverCount, duration);
+        printResult("pid + memory", runSimulation(pidMemory, 0.1, roverCount, duration, targetCount, clustered, seed), roverCount, duration);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,46 @@
+#include <ros/ros.h>
+
+// To handle shutdown signals so the node quits properly in response to "rosnode kill"
+#include <signal.h>
+
+#include "mobilityNode.h"
+
+using namespace std;
+
+// OS Signal Handler
+void sigintEventHandler(int signal);
+
+int main(int argc, char **argv) {
+
+    char host[128];
+    gethostname(host, sizeof (host));
+    string hostname(host);
+    string publishedName;
+
+    if (argc >= 2) {
+        publishedName = argv[1];
+        cout << "Welcome to the world of tomorrow " << publishedName << "!  Mobility module started." << endl;
+    } else {
+        publishedName = hostname;
+        cout << "No Name Selected. Default is: " << publishedName << endl;
+    }
+
+    // NoSignalHandler so we can catch SIGINT ourselves and shutdown the node
+    ros::init(argc, argv, (publishedName + "_MOBILITY"), ros::init_options::NoSigintHandler);
+    ros::NodeHandle mNH;
+    ros::NodeHandle param("~");
+
+    signal(SIGINT, sigintEventHandler); // Register the SIGINT event handler so the node can shutdown properly
+
+    mobility::start(mNH, param, publishedName);
+    ros::spin();
+    mobility::stop();
+
+    return EXIT_SUCCESS;
+}
+
+void sigintEventHandler(int sig)
+{
+     // All the default sigint handler does is call shutdown()
+     ros::shutdown();
+}
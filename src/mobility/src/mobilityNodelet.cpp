@@ -0,0 +1,39 @@
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+
+#include "mobilityNode.h"
+
+using namespace std;
+
+namespace mobility {
+
+// Runs mobility inside a nodelet manager so the obstacle and odometry messages
+// from nodelets in the same manager arrive as shared pointers instead of being
+// serialised. The rover name is the first nodelet argument, or the hostname.
+class MobilityNodelet : public nodelet::Nodelet {
+public:
+
+    ~MobilityNodelet() {
+        stop();
+    }
+
+private:
+
+    virtual void onInit() {
+        string publishedName;
+        if (!getMyArgv().empty()) {
+            publishedName = getMyArgv()[0];
+        } else {
+            char host[128];
+            gethostname(host, sizeof (host));
+            publishedName = host;
+        }
+        NODELET_INFO("Mobility nodelet started for %s", publishedName.c_str());
+
+        start(getNodeHandle(), getPrivateNodeHandle(), publishedName);
+    }
+};
+
+}
+
+PLUGINLIB_EXPORT_CLASS(mobility::MobilityNodelet, nodelet::Nodelet)
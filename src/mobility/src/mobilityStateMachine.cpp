@@ -0,0 +1,377 @@
+#include "mobilityStateMachine.h"
+
+#include <algorithm>
+#include <math.h>
+
+using namespace std;
+
+// Same result as angles::shortest_angular_distance, kept here so the class has no ROS dependencies
+static double shortestAngularDistance(double from, double to) {
+    double difference = fmod(to - from + M_PI, 2.0 * M_PI);
+    if (difference < 0.0) {
+        difference += 2.0 * M_PI;
+    }
+    return difference - M_PI;
+}
+
+void MobilityOutput::clear() {
+    hasVelocity = false;
+    linearVelocity = 0.0;
+    angularVelocity = 0.0;
+    hasFingerAngle = false;
+    fingerAngle = 0.0;
+    hasWristAngle = false;
+    wristAngle = 0.0;
+    goalChanged = false;
+}
+
+void MobilityOutput::setVelocity(double linear, double angular) {
+    hasVelocity = true;
+    linearVelocity = linear;
+    angularVelocity = angular;
+}
+
+void MobilityOutput::setFingerAngle(double angle) {
+    hasFingerAngle = true;
+    fingerAngle = angle;
+}
+
+void MobilityOutput::setWristAngle(double angle) {
+    hasWristAngle = true;
+    wristAngle = angle;
+}
+
+MobilitySettings::MobilitySettings() :
+    translateSpeed(0.3),
+    rotateSpeed(0.2),
+    headingTolerance(0.1),
+    searchStepDistance(0.5),
+    searchHeadingStdDev(0.25),
+    obstacleTurn(0.2),
+    homeRadius(0.5),
+    targetApproachOffset(0.26),
+    targetTimeout(5.0),
+    minObstacleSpeedScale(0.2),
+    obstacleFieldTimeout(2.0),
+    closedLoop(false),
+    steerAngle(0.15),
+    maxAngularSpeed(0.8),
+    headingKp(1.5),
+    headingKi(0.0),
+    headingKd(0.1),
+    rememberTargets(true),
+    targetMergeRadius(0.05) {
+}
+
+MobilityStateMachine::MobilityStateMachine(unsigned int seed, const MobilitySettings& settings) :
+    settings(settings),
+    rng(seed),
+    mode(0),
+    state(STATE_TRANSFORM),
+    targetDetected(false),
+    targetCollected(false),
+    targetDetectedUntil(0.0),
+    obstacleProximity(0.0),
+    obstacleProximityTime(0.0),
+    currentStateName("WAITING"),
+    lastStepTime(-1.0),
+    memory(settings.targetMergeRadius),
+    approachKey(-1) {
+
+    HeadingController::PIDSettings pidSettings;
+    pidSettings.Kp = settings.headingKp;
+    pidSettings.Ki = settings.headingKi;
+    pidSettings.Kd = settings.headingKd;
+    pidSettings.max = settings.maxAngularSpeed;
+    pidSettings.min = -settings.maxAngularSpeed;
+    headingController = HeadingController(pidSettings);
+
+    //set initial random heading
+    goal.theta = uniform_real_distribution<double>(0.0, 2.0 * M_PI)(rng);
+
+    //select initial search position 50 cm from center (0,0)
+    goal.x = settings.searchStepDistance * cos(goal.theta);
+    goal.y = settings.searchStepDistance * sin(goal.theta);
+}
+
+void MobilityStateMachine::setMode(int mode) {
+    this->mode = mode;
+}
+
+void MobilityStateMachine::setPose(const MobilityPose& pose) {
+    current = pose;
+}
+
+MobilityOutput MobilityStateMachine::obstacleDetected(int obstacle) {
+    MobilityOutput output;
+
+    if (!targetDetected && (obstacle > 0)) {
+        //obstacle on right side
+        if (obstacle == 1) {
+            //select new heading to the left
+            goal.theta = current.theta + settings.obstacleTurn;
+        }
+
+        //obstacle in front or on left side
+        else if (obstacle == 2) {
+            //select new heading to the right
+            goal.theta = current.theta - settings.obstacleTurn;
+        }
+
+        //select new position 50 cm from current location
+        goal.x = current.x + (settings.searchStepDistance * cos(goal.theta));
+        goal.y = current.y + (settings.searchStepDistance * sin(goal.theta));
+
+        //switch to transform state to trigger collision avoidance
+        state = STATE_TRANSFORM;
+        output.goalChanged = true;
+        approachKey = -1;
+    }
+    return output;
+}
+
+void MobilityStateMachine::setObstacleProximity(double proximity, double now) {
+    obstacleProximity = proximity;
+    obstacleProximityTime = now;
+}
+
+MobilityOutput MobilityStateMachine::targetInGripper() {
+    MobilityOutput output;
+
+    //assume target has been picked up by gripper
+    targetCollected = true;
+
+    //the target in the gripper is the remembered one being approached, or failing that the closest one
+    if (!memory.contains(approachKey)) {
+        approachKey = memory.nearestWithin(current.x, current.y, 2.0 * settings.targetApproachOffset);
+    }
+    memory.forget(approachKey);
+    approachKey = -1;
+
+    //lower wrist to avoid ultrasound sensors
+    output.setWristAngle(M_PI_2 / 4);
+    return output;
+}
+
+MobilityOutput MobilityStateMachine::targetSeen(int id, double x, double y, double now) {
+    return targetsSeen(vector<TargetSighting>(1, TargetSighting(id, x, y)), now);
+}
+
+MobilityOutput MobilityStateMachine::targetsSeen(const vector<TargetSighting>& sightings, double now) {
+    MobilityOutput output;
+
+    bool homeSeen = false;
+    int nearestSighting = -1;
+    int nearestKey = -1;
+    double nearestDistance = INFINITY;
+    for (size_t i = 0; i < sightings.size(); i++) {
+        const TargetSighting& sighting = sightings[i];
+        if (sighting.id == homeTagId) {
+            homeSeen = true;
+            continue;
+        }
+
+        int key = -1;
+        if (settings.rememberTargets) {
+            //targets already dropped in the nest are left where they are
+            if (hypot(sighting.x, sighting.y) <= settings.homeRadius) {
+                continue;
+            }
+            key = memory.observe(sighting.x, sighting.y, now);
+        }
+
+        double distance = hypot(sighting.x - current.x, sighting.y - current.y);
+        if (distance < nearestDistance) {
+            nearestSighting = i;
+            nearestKey = key;
+            nearestDistance = distance;
+        }
+    }
+
+    //if this is the goal target
+    if (homeSeen) {
+        //open fingers to drop off target
+        output.setFingerAngle(M_PI_2);
+    }
+
+    //Otherwise, if no target has been collected, set the nearest target as goal
+    else if (!targetCollected && nearestSighting >= 0) {
+        approachKey = nearestKey;
+        setApproachGoal(sightings[nearestSighting].x, sightings[nearestSighting].y);
+
+        //open fingers and lower wrist
+        output.setFingerAngle(M_PI_2);
+        output.setWristAngle(0.8);
+
+        //set state and timeout
+        targetDetected = true;
+        targetDetectedUntil = now + settings.targetTimeout;
+
+        //switch to transform state to trigger return to center
+        state = STATE_TRANSFORM;
+        output.goalChanged = true;
+    }
+    return output;
+}
+
+// Places the goal short of a target so the camera keeps it in view
+void MobilityStateMachine::setApproachGoal(double x, double y) {
+    //set goal heading
+    goal.theta = atan2(y - current.y, x - current.x);
+
+    //set goal position
+    goal.x = x - (settings.targetApproachOffset * cos(goal.theta));
+    goal.y = y - (settings.targetApproachOffset * sin(goal.theta));
+}
+
+// Heads for the nearest remembered target. Returns false if none is left.
+bool MobilityStateMachine::goToRememberedTarget() {
+    if (!settings.rememberTargets) {
+        return false;
+    }
+
+    //arriving without seeing the target means it is gone, perhaps taken by another rover
+    if (approachKey >= 0) {
+        memory.forget(approachKey);
+        approachKey = -1;
+    }
+
+    approachKey = memory.nearest(current.x, current.y);
+    if (approachKey < 0) {
+        return false;
+    }
+    setApproachGoal(memory.get(approachKey).x, memory.get(approachKey).y);
+    return true;
+}
+
+// The goal counts as reached once it is beside or behind the rover
+bool MobilityStateMachine::goalAhead() const {
+    double bearing = atan2(goal.y - current.y, goal.x - current.x);
+    return fabs(shortestAngularDistance(current.theta, bearing)) < M_PI_2;
+}
+
+// Heading error that needs a turn in place before driving
+double MobilityStateMachine::rotateTolerance() const {
+    return settings.closedLoop ? settings.steerAngle : settings.headingTolerance;
+}
+
+MobilityOutput MobilityStateMachine::step(double now) {
+    MobilityOutput output;
+
+    double dt = (lastStepTime >= 0.0) ? now - lastStepTime : 0.0;
+    lastStepTime = now;
+
+    //give up on a target that was not reached in time
+    if (targetDetected && now >= targetDetectedUntil) {
+        targetDetected = false;
+        output.setFingerAngle(0.0); //close fingers
+        output.setWristAngle(0.0); //raise wrist
+    }
+
+    if (!isAutonomous()) {
+        currentStateName = "WAITING";
+        return output;
+    }
+
+    switch (state) {
+
+        //Select rotation or translation based on required adjustment
+        //If no adjustment needed, select new goal
+        case STATE_TRANSFORM:
+        {
+            currentStateName = "TRANSFORMING";
+            headingController.reset();
+            //If angle between current and goal is significant
+            if (fabs(shortestAngularDistance(current.theta, goal.theta)) > rotateTolerance()) {
+                state = STATE_ROTATE; //rotate
+            }
+            //If goal has not yet been reached
+            else if (goalAhead()) {
+                state = STATE_TRANSLATE; //translate
+            }
+            //If returning with a target
+            else if (targetCollected) {
+                //If goal has not yet been reached
+                if (hypot(current.x, current.y) > settings.homeRadius) {
+                    //set angle to center as goal heading
+                    goal.theta = M_PI + atan2(current.y, current.x);
+
+                    //set center as goal position
+                    goal.x = 0.0;
+                    goal.y = 0.0;
+                }
+                //Otherwise, drop off target and return to a remembered target or select new random uniform heading
+                else {
+                    output.setFingerAngle(M_PI_2); //open fingers
+                    targetCollected = false;
+                    if (!goToRememberedTarget()) {
+                        goal.theta = uniform_real_distribution<double>(0.0, 2.0 * M_PI)(rng);
+                    }
+                }
+            }
+            //If no targets have been detected, go back to a remembered target or assign a new goal
+            else if (!targetDetected && !goToRememberedTarget()) {
+                //select new heading from Gaussian distribution around current heading
+                goal.theta = normal_distribution<double>(current.theta, settings.searchHeadingStdDev)(rng);
+
+                //select new position 50 cm from current location
+                goal.x = current.x + (settings.searchStepDistance * cos(goal.theta));
+                goal.y = current.y + (settings.searchStepDistance * sin(goal.theta));
+            }
+        }
+
+        //Calculate angle between current.theta and goal.theta
+        //Rotate left or right depending on sign of angle
+        //Stay in this state until angle is minimized
+        // fall through
+        case STATE_ROTATE:
+        {
+            currentStateName = "ROTATING";
+            double headingError = shortestAngularDistance(current.theta, goal.theta);
+            if (settings.closedLoop && fabs(headingError) > settings.steerAngle) {
+                output.setVelocity(0.0, headingController.update(goal.theta, current.theta, dt));
+            } else if (settings.closedLoop) {
+                state = STATE_TRANSLATE; //close enough to steer the rest of the way
+            } else if (headingError > settings.headingTolerance) {
+                output.setVelocity(0.0, settings.rotateSpeed); //rotate left
+            } else if (headingError < -settings.headingTolerance) {
+                output.setVelocity(0.0, -settings.rotateSpeed); //rotate right
+            } else {
+                output.setVelocity(0.0, 0.0); //stop
+                state = STATE_TRANSLATE; //move to translate step
+            }
+            break;
+        }
+
+        //Calculate angle between current.x/y and goal.x/y
+        //Drive forward
+        //Stay in this state until angle is at least PI/2
+        case STATE_TRANSLATE:
+        {
+            currentStateName = "TRANSLATING";
+            if (goalAhead()) {
+                //slow down as obstacles get closer instead of driving full speed until the avoidance turn
+                double speedScale = 1.0;
+                if (now - obstacleProximityTime < settings.obstacleFieldTimeout) {
+                    speedScale = max(settings.minObstacleSpeedScale, 1.0 - obstacleProximity);
+                }
+
+                if (settings.closedLoop) {
+                    //steer toward the goal, easing off the throttle as the heading error grows
+                    double bearing = atan2(goal.y - current.y, goal.x - current.x);
+                    double headingError = shortestAngularDistance(current.theta, bearing);
+                    double angular = headingController.update(bearing, current.theta, dt);
+                    output.setVelocity(settings.translateSpeed * speedScale * max(0.0, cos(headingError)), angular);
+                } else {
+                    output.setVelocity(settings.translateSpeed * speedScale, 0.0);
+                }
+            } else {
+                output.setVelocity(0.0, 0.0); //stop
+                output.setFingerAngle(0.0); //close fingers
+                state = STATE_TRANSFORM; //move back to transform step
+            }
+            break;
+        }
+    }
+    return output;
+}
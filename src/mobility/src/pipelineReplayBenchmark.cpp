@@ -0,0 +1,411 @@
+// Replays a recorded run through the onboard hot paths without ROS: abridge's
+// telemetry parser, obstacle_detection's sonar fuser and the mobility state
+// machine, as fast as they will go. Reports the throughput and latency
+// percentiles of every stage so regressions show up before a field test.
+//
+// A recorded run is a text file with one timestamped event per line:
+//   <seconds> serial <telemetry frame as sent by the Arduino>
+//   <seconds> pose <x> <y> <theta>
+//   <seconds> tags <id> <x> <y> [<id> <x> <y> ...]
+//   <seconds> gripper
+// abridge writes the serial lines and mobility the others when their
+// record_file parameter is set. Several files are merged by time. Positions
+// are in the odom frame. Without pose lines the pose is integrated from the
+// odometry in the telemetry frames. Without any file a synthetic run is used.
+//
+// Run with: pipeline_replay_benchmark [-n repeats] [-w written run] [recorded run ...]
+
+#include <mobilityStateMachine.h>
+#include <obstacleFuser.h>
+#include <telemetryParser.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static const double controlPeriod = 0.1;     // s between state machine steps, mobility's default control_rate
+static const double syntheticDuration = 600; // s of synthetic run
+static const double telemetryPeriod = 0.1;   // s between telemetry frames, abridge's default telemetry_rate
+static const double cameraPeriod = 0.5;      // s between tag detections
+static const double arenaHalfWidth = 7.5;    // m
+static const double sonarMaxRange = 3.0;     // m
+
+enum EventType { SERIAL, POSE, TAGS, GRIPPER };
+
+struct ReplayEvent {
+    double time;
+    EventType type;
+    string frame;
+    MobilityPose pose;
+    vector<TargetSighting> sightings;
+
+    ReplayEvent() : time(0.0), type(SERIAL), pose(0.0, 0.0, 0.0) {}
+
+    bool operator<(const ReplayEvent& other) const { return time < other.time; }
+};
+
+// Latency samples of one stage in nanoseconds
+struct Stage {
+    const char* name;
+    vector<double> samples;
+    double totalNs;
+
+    Stage(const char* name) : name(name), totalNs(0.0) {}
+
+    void add(chrono::steady_clock::time_point start, chrono::steady_clock::time_point end) {
+        double ns = chrono::duration_cast<chrono::nanoseconds>(end - start).count();
+        samples.push_back(ns);
+        totalNs += ns;
+    }
+};
+
+static bool readRecordedRun(const char* path, vector<ReplayEvent>& events) {
+    ifstream file(path);
+    if (!file) {
+        return false;
+    }
+
+    string line;
+    while (getline(file, line)) {
+        istringstream fields(line);
+        ReplayEvent event;
+        string type;
+        if (!(fields >> event.time >> type)) {
+            continue;
+        }
+
+        if (type == "serial") {
+            event.type = SERIAL;
+            fields >> event.frame;
+        } else if (type == "pose") {
+            event.type = POSE;
+            fields >> event.pose.x >> event.pose.y >> event.pose.theta;
+        } else if (type == "tags") {
+            event.type = TAGS;
+            int id;
+            double x, y;
+            while (fields >> id >> x >> y) {
+                event.sightings.push_back(TargetSighting(id, x, y));
+            }
+        } else if (type == "gripper") {
+            event.type = GRIPPER;
+        } else {
+            continue;
+        }
+        events.push_back(event);
+    }
+    return true;
+}
+
+static void writeRecordedRun(const char* path, const vector<ReplayEvent>& events) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        printf("Could not write %s\n", path);
+        return;
+    }
+    for (size_t i = 0; i < events.size(); i++) {
+        const ReplayEvent& event = events[i];
+        switch (event.type) {
+            case SERIAL:
+                fprintf(file, "%.6f serial %s\n", event.time, event.frame.c_str());
+                break;
+            case POSE:
+                fprintf(file, "%.6f pose %.4f %.4f %.4f\n", event.time, event.pose.x, event.pose.y, event.pose.theta);
+                break;
+            case TAGS:
+                fprintf(file, "%.6f tags", event.time);
+                for (size_t j = 0; j < event.sightings.size(); j++) {
+                    fprintf(file, " %d %.4f %.4f", event.sightings[j].id, event.sightings[j].x, event.sightings[j].y);
+                }
+                fputc('\n', file);
+                break;
+            case GRIPPER:
+                fprintf(file, "%.6f gripper\n", event.time);
+                break;
+        }
+    }
+    fclose(file);
+}
+
+// Distance from (x, y) along heading to the arena wall
+static double wallDistance(double x, double y, double heading) {
+    double distance = INFINITY;
+    double dx = cos(heading);
+    double dy = sin(heading);
+    if (dx > 1e-9) distance = min(distance, (arenaHalfWidth - x) / dx);
+    if (dx < -1e-9) distance = min(distance, (-arenaHalfWidth - x) / dx);
+    if (dy > 1e-9) distance = min(distance, (arenaHalfWidth - y) / dy);
+    if (dy < -1e-9) distance = min(distance, (-arenaHalfWidth - y) / dy);
+    return distance;
+}
+
+// A rover wandering an arena with scattered targets: telemetry at 10 Hz with
+// noisy sonar and the occasional spike, filtered poses at 10 Hz and tag
+// sightings every camera period while a target is in view.
+static void synthesizeRun(double duration, unsigned int seed, vector<ReplayEvent>& events) {
+    mt19937 rng(seed);
+    uniform_real_distribution<double> uniform(0.0, 1.0);
+    normal_distribution<double> noise(0.0, 0.02);
+
+    vector<TargetSighting> targets;
+    for (int i = 0; i < 64; i++) {
+        targets.push_back(TargetSighting(i, (uniform(rng) * 2 - 1) * arenaHalfWidth, (uniform(rng) * 2 - 1) * arenaHalfWidth));
+    }
+
+    double x = 0.0, y = 0.0, heading = 0.0;
+    double speed = 0.3, turn = 0.0;
+    double nextCamera = 0.0;
+    for (int tick = 0; tick * telemetryPeriod < duration; tick++) {
+        double elapsed = tick * telemetryPeriod;
+        //recordings carry wall clock stamps to the microsecond, start away from zero
+        double time = floor((1000.0 + elapsed) * 1e6 + 0.5) / 1e6;
+
+        //wander, and turn away from walls the way the real search would
+        if (uniform(rng) < 0.05) {
+            turn = (uniform(rng) * 2 - 1) * 0.8;
+        }
+        if (wallDistance(x, y, heading) < 0.5) {
+            turn = 0.8;
+        }
+        double dx = speed * cos(heading) * telemetryPeriod;
+        double dy = speed * sin(heading) * telemetryPeriod;
+        x = max(-arenaHalfWidth, min(x + dx, arenaHalfWidth));
+        y = max(-arenaHalfWidth, min(y + dy, arenaHalfWidth));
+        heading = remainder(heading + turn * telemetryPeriod, 2.0 * M_PI);
+
+        float values[TELEMETRY_FIELD_COUNT];
+        for (int i = 0; i < TELEMETRY_FIELD_COUNT; i++) {
+            values[i] = noise(rng);
+        }
+        values[ACCEL_Z] = 9.81 + noise(rng);
+        values[GYRO_Z] = turn;
+        values[YAW] = heading;
+        values[ODOM_DELTA_X] = dx * 100.0;
+        values[ODOM_DELTA_Y] = dy * 100.0;
+        values[ODOM_YAW] = heading;
+        values[ODOM_VELOCITY_X] = speed * 100.0;
+        values[ODOM_ANGULAR_Z] = turn;
+        static const double sonarAngles[] = { 0.5, 0.0, -0.5 };
+        for (int i = 0; i < 3; i++) {
+            double range = min(wallDistance(x, y, heading + sonarAngles[i]), sonarMaxRange) + noise(rng);
+            if (uniform(rng) < 0.02) {
+                range = uniform(rng) * sonarMaxRange; // a stray echo
+            }
+            values[SONAR_LEFT + i] = max(0.0, range) * 100.0;
+        }
+
+        char frame[256];
+        int length = 0;
+        for (int i = 0; i < TELEMETRY_FIELD_COUNT; i++) {
+            length += snprintf(frame + length, sizeof (frame) - length, (i ? ",%g" : "%g"), values[i]);
+        }
+
+        ReplayEvent serial;
+        serial.time = time;
+        serial.type = SERIAL;
+        serial.frame = frame;
+        events.push_back(serial);
+
+        ReplayEvent pose;
+        pose.time = time + 0.01;
+        pose.type = POSE;
+        pose.pose = MobilityPose(x, y, heading);
+        events.push_back(pose);
+
+        if (elapsed < nextCamera) {
+            continue;
+        }
+        nextCamera = elapsed + cameraPeriod;
+
+        ReplayEvent tags;
+        tags.time = time + 0.02;
+        tags.type = TAGS;
+        for (size_t i = 0; i < targets.size(); i++) {
+            double distance = hypot(targets[i].x - x, targets[i].y - y);
+            double bearing = remainder(atan2(targets[i].y - y, targets[i].x - x) - heading, 2.0 * M_PI);
+            if (distance < 1.0 && fabs(bearing) < 0.5) {
+                tags.sightings.push_back(targets[i]);
+            }
+            if (distance < 0.2) {
+                ReplayEvent gripper;
+                gripper.time = time + 0.02;
+                gripper.type = GRIPPER;
+                events.push_back(gripper);
+                targets[i].x = targets[i].y = 100.0; // collected
+            }
+        }
+        if (!tags.sightings.empty()) {
+            events.push_back(tags);
+        }
+    }
+}
+
+static void printStage(const Stage& stage) {
+    if (stage.samples.empty()) {
+        printf("  %-18s %9d\n", stage.name, 0);
+        return;
+    }
+    vector<double> sorted = stage.samples;
+    sort(sorted.begin(), sorted.end());
+    size_t count = sorted.size();
+
+    printf("  %-18s %9lu %12.0f %9.2f %9.2f %9.2f %9.2f\n", stage.name, (unsigned long) count,
+           count / (stage.totalNs * 1e-9),
+           sorted[count / 2] / 1000.0,
+           sorted[min(count - 1, (size_t) (0.95 * count))] / 1000.0,
+           sorted[min(count - 1, (size_t) (0.99 * count))] / 1000.0,
+           sorted.back() / 1000.0);
+}
+
+int main(int argc, char** argv) {
+    int repeats = 20;
+    const char* writePath = NULL;
+    vector<ReplayEvent> events;
+    bool recorded = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            repeats = max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            writePath = argv[++i];
+        } else if (readRecordedRun(argv[i], events)) {
+            recorded = true;
+        } else {
+            printf("Could not read recorded run %s\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!recorded) {
+        synthesizeRun(syntheticDuration, 1, events);
+    }
+    stable_sort(events.begin(), events.end());
+    if (events.empty()) {
+        printf("The recorded run has no events\n");
+        return EXIT_FAILURE;
+    }
+    if (writePath) {
+        writeRecordedRun(writePath, events);
+    }
+
+    bool havePoses = false;
+    int serialFrames = 0;
+    for (size_t i = 0; i < events.size(); i++) {
+        havePoses = havePoses || events[i].type == POSE;
+        serialFrames += (events[i].type == SERIAL);
+    }
+    double duration = events.back().time - events.front().time;
+
+    Stage parser("parser");
+    Stage fuser("obstacle fuser");
+    Stage inputs("mobility inputs");
+    Stage step("mobility step");
+    Stage frameTotal("frame end to end");
+
+    unsigned long malformed = 0;
+    unsigned long obstacles = 0;
+    int collected = 0;
+    chrono::steady_clock::duration replayTime = chrono::steady_clock::duration::zero();
+
+    for (int repeat = 0; repeat < repeats; repeat++) {
+        MobilityStateMachine stateMachine(repeat + 1);
+        stateMachine.setMode(2);
+        ObstacleFuser obstacleFuser;
+        MobilityPose odomPose(0.0, 0.0, 0.0);
+        double nextStep = events.front().time;
+
+        chrono::steady_clock::time_point replayStart = chrono::steady_clock::now();
+        for (size_t i = 0; i < events.size(); i++) {
+            const ReplayEvent& event = events[i];
+
+            //the state machine timer keeps running between events
+            while (nextStep <= event.time) {
+                chrono::steady_clock::time_point start = chrono::steady_clock::now();
+                stateMachine.step(nextStep);
+                step.add(start, chrono::steady_clock::now());
+                nextStep += controlPeriod;
+            }
+
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            MobilityOutput output;
+            output.clear();
+
+            if (event.type == SERIAL) {
+                TelemetryFrame frame;
+                bool parsed = parseTelemetryFrame(event.frame.c_str(), event.frame.size(), frame) == TELEMETRY_OK;
+                chrono::steady_clock::time_point parsedTime = chrono::steady_clock::now();
+                parser.add(start, parsedTime);
+                if (!parsed) {
+                    malformed++;
+                    continue;
+                }
+
+                double ranges[ObstacleFuser::sonarCount];
+                for (int j = 0; j < ObstacleFuser::sonarCount; j++) {
+                    ranges[j] = frame.values[SONAR_LEFT + j] / 100.0;
+                }
+                ObstacleFuser::ObstacleMode mode;
+                bool publish = obstacleFuser.update(ranges, event.time, mode);
+                chrono::steady_clock::time_point fusedTime = chrono::steady_clock::now();
+                fuser.add(parsedTime, fusedTime);
+
+                if (!havePoses) {
+                    odomPose.x += frame.values[ODOM_DELTA_X] / 100.0;
+                    odomPose.y += frame.values[ODOM_DELTA_Y] / 100.0;
+                    odomPose.theta = frame.values[ODOM_YAW];
+                    stateMachine.setPose(odomPose);
+                }
+                stateMachine.setObstacleProximity(max(obstacleFuser.proximity(0), max(obstacleFuser.proximity(1), obstacleFuser.proximity(2))), event.time);
+                if (publish) {
+                    obstacles++;
+                    output = stateMachine.obstacleDetected(mode);
+                }
+                if (output.goalChanged) {
+                    stateMachine.step(event.time);
+                }
+                chrono::steady_clock::time_point end = chrono::steady_clock::now();
+                inputs.add(fusedTime, end);
+                frameTotal.add(start, end);
+                continue;
+            }
+
+            if (event.type == POSE) {
+                stateMachine.setPose(event.pose);
+            } else if (event.type == TAGS) {
+                output = stateMachine.targetsSeen(event.sightings, event.time);
+            } else {
+                output = stateMachine.targetInGripper();
+                collected++;
+            }
+            if (output.goalChanged) {
+                stateMachine.step(event.time);
+            }
+            inputs.add(start, chrono::steady_clock::now());
+        }
+        replayTime += chrono::steady_clock::now() - replayStart;
+    }
+
+    double replaySeconds = chrono::duration<double>(replayTime).count();
+    printf("Replayed %s run of %.1f s, %lu events (%d telemetry frames) %d times\n",
+           recorded ? "the recorded" : "a synthetic", duration, (unsigned long) events.size(), serialFrames, repeats);
+    printf("  %.3f s of replay, %.0fx real time, %lu malformed frames, %lu obstacle messages, %d pickups\n",
+           replaySeconds, duration * repeats / replaySeconds, malformed / repeats, obstacles / repeats, collected / repeats);
+    printf("  %-18s %9s %12s %9s %9s %9s %9s\n", "stage", "events", "events/s", "p50 us", "p95 us", "p99 us", "max us");
+    printStage(parser);
+    printStage(fuser);
+    printStage(inputs);
+    printStage(step);
+    printStage(frameTotal);
+
+    return EXIT_SUCCESS;
+}
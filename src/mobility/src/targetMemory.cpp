@@ -0,0 +1,144 @@
+#include "targetMemory.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stdlib.h>
+
+using namespace std;
+
+TargetMemory::TargetMemory(double mergeRadius, double cellSize) :
+    mergeRadius(mergeRadius), cellSize(max(cellSize, mergeRadius)) {
+    clear();
+}
+
+int TargetMemory::observe(double x, double y, double now) {
+    int key = nearestWithin(x, y, mergeRadius);
+    if (key >= 0) {
+        //refine the position with a running average of the sightings
+        removeFromCell(key);
+        RememberedTarget& target = targets[key];
+        target.sightings++;
+        target.x += (x - target.x) / target.sightings;
+        target.y += (y - target.y) / target.sightings;
+        target.lastSeen = now;
+        insertIntoCell(key);
+        return key;
+    }
+
+    if (!freeKeys.empty()) {
+        key = freeKeys.back();
+        freeKeys.pop_back();
+    } else {
+        key = targets.size();
+        targets.push_back(RememberedTarget());
+        active.push_back(false);
+    }
+
+    RememberedTarget& target = targets[key];
+    target.x = x;
+    target.y = y;
+    target.firstSeen = now;
+    target.lastSeen = now;
+    target.sightings = 1;
+    active[key] = true;
+    activeCount++;
+    insertIntoCell(key);
+    return key;
+}
+
+int TargetMemory::nearest(double x, double y) const {
+    return nearestWithin(x, y, INFINITY);
+}
+
+int TargetMemory::nearestWithin(double x, double y, double radius) const {
+    if (activeCount == 0) {
+        return -1;
+    }
+
+    int cellX = cellCoordinate(x);
+    int cellY = cellCoordinate(y);
+
+    //no occupied cell is further out than this ring
+    int lastRing = max(max(abs(cellX - minCellX), abs(cellX - maxCellX)), max(abs(cellY - minCellY), abs(cellY - maxCellY)));
+
+    int best = -1;
+    double bestDistance = radius;
+    for (int ring = 0; ring <= lastRing; ring++) {
+        //every point in this ring is at least (ring - 1) cells away
+        if ((ring - 1) * cellSize > bestDistance) {
+            break;
+        }
+
+        for (int i = cellX - ring; i <= cellX + ring; i++) {
+            //only the border of the square is new in this ring
+            int step = (i == cellX - ring || i == cellX + ring) ? 1 : 2 * ring;
+            for (int j = cellY - ring; j <= cellY + ring; j += max(step, 1)) {
+                unordered_map<CellKey, vector<int> >::const_iterator cell = cells.find(cellKey(i, j));
+                if (cell == cells.end()) {
+                    continue;
+                }
+                for (size_t k = 0; k < cell->second.size(); k++) {
+                    int key = cell->second[k];
+                    double distance = hypot(targets[key].x - x, targets[key].y - y);
+                    if (distance <= bestDistance) {
+                        best = key;
+                        bestDistance = distance;
+                    }
+                }
+            }
+        }
+    }
+    return best;
+}
+
+void TargetMemory::forget(int key) {
+    if (!contains(key)) {
+        return;
+    }
+    removeFromCell(key);
+    active[key] = false;
+    activeCount--;
+    freeKeys.push_back(key);
+}
+
+void TargetMemory::clear() {
+    targets.clear();
+    active.clear();
+    freeKeys.clear();
+    cells.clear();
+    activeCount = 0;
+    minCellX = maxCellX = minCellY = maxCellY = 0;
+}
+
+int TargetMemory::cellCoordinate(double value) const {
+    return (int) floor(value / cellSize);
+}
+
+TargetMemory::CellKey TargetMemory::cellKey(int cellX, int cellY) const {
+    return ((CellKey) cellX << 32) | (unsigned int) cellY;
+}
+
+void TargetMemory::insertIntoCell(int key) {
+    int cellX = cellCoordinate(targets[key].x);
+    int cellY = cellCoordinate(targets[key].y);
+    cells[cellKey(cellX, cellY)].push_back(key);
+
+    if (activeCount == 1 && cells.size() == 1) {
+        minCellX = maxCellX = cellX;
+        minCellY = maxCellY = cellY;
+    } else {
+        minCellX = min(minCellX, cellX);
+        maxCellX = max(maxCellX, cellX);
+        minCellY = min(minCellY, cellY);
+        maxCellY = max(maxCellY, cellY);
+    }
+}
+
+void TargetMemory::removeFromCell(int key) {
+    CellKey cell = cellKey(cellCoordinate(targets[key].x), cellCoordinate(targets[key].y));
+    vector<int>& members = cells[cell];
+    members.erase(std::remove(members.begin(), members.end(), key), members.end());
+    if (members.empty()) {
+        cells.erase(cell);
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef OBSTACLEFUSER_H
+#define	OBSTACLEFUSER_H
+
+#include <sonarFilter.h>
+
+// The obstacle decision of the obstacle node without ROS, so the pipeline
+// replay benchmark runs the same code. Ranges are indexed left, center, right.
+class ObstacleFuser {
+public:
+
+    static const int sonarCount = 3;
+
+    // Values published on /<rover>/obstacle
+    enum ObstacleMode {
+        CLEAR = 0,
+        BLOCKED_RIGHT = 1,  // collision on right side
+        BLOCKED_FRONT = 2   // collision in front or on left side
+    };
+
+    ObstacleFuser();
+
+    void configure(SonarFilter::Mode filterMode, int medianWindow, double emaAlpha,
+                   double collisionDistance, double clearDistance,
+                   double repeatInterval, double proximityRange);
+
+    // Filters one triplet of raw ranges in meters received at now (seconds).
+    // Returns true when the obstacle state should be published: immediately
+    // on a change, and every repeatInterval while an obstacle persists.
+    bool update(const double ranges[sonarCount], double now, ObstacleMode& mode);
+
+    // Filtered range of the last triplet
+    double range(int sonar) const { return filtered[sonar]; }
+
+    // 0 when nothing is within proximityRange, rising to 1 at
+    // collisionDistance or closer
+    double proximity(int sonar) const;
+
+private:
+
+    SonarFilter filters[sonarCount];
+    SonarHysteresis hysteresis[sonarCount];
+    double filtered[sonarCount];
+
+    double collisionDistance;
+    double repeatInterval;
+    double proximityRange;
+
+    int lastMode;
+    double lastPublish;
+};
+
+#endif	/* OBSTACLEFUSER_H */
@@ -0,0 +1,20 @@
+#ifndef OBSTACLENODE_H
+#define	OBSTACLENODE_H
+
+#include <ros/ros.h>
+
+#include <string>
+
+// Entry points shared by the obstacle node and the obstacle nodelet. The node
+// state is global, so a process hosts at most one obstacle instance.
+namespace obstacle_detection {
+
+    // Reads the parameters from param and subscribes to the sonars of the
+    // rover publishedName through nodeHandle
+    void start(ros::NodeHandle& nodeHandle, ros::NodeHandle& param, const std::string& publishedName);
+
+    // Shuts down everything start created, before a nodelet is unloaded
+    void stop();
+}
+
+#endif	/* OBSTACLENODE_H */
@@ -0,0 +1,63 @@
+#ifndef SONARFILTER_H
+#define	SONARFILTER_H
+
+#include <string>
+
+// Smooths the readings of one ultrasound sensor so a single noisy ping does
+// not register as an obstacle.
+//   none:   readings pass through unchanged
+//   median: median of the last window readings, rejects isolated spikes
+//   ema:    exponential moving average, filtered += alpha * (reading - filtered)
+class SonarFilter {
+public:
+
+    enum Mode { NONE, MEDIAN, EMA };
+
+    SonarFilter();
+
+    void configure(Mode mode, int window, double alpha);
+
+    // Adds a reading and returns the filtered range
+    double update(double range);
+
+    void reset();
+
+    // Converts "none", "median" or "ema". Returns false for anything else.
+    static bool parseMode(const std::string& name, Mode& mode);
+
+    static const int maxWindow = 15;
+
+private:
+
+    Mode mode;
+    int window;
+    double alpha;
+
+    double readings[maxWindow];
+    int readingCount;
+    int nextReading;
+    double average;
+};
+
+// Turns a filtered range into an obstacle flag with separate enter and exit
+// distances, so a range hovering around one threshold does not toggle it.
+class SonarHysteresis {
+public:
+
+    SonarHysteresis();
+
+    void configure(double enterDistance, double exitDistance);
+
+    // Returns whether an obstacle is currently flagged
+    bool update(double range);
+
+    bool blocked() const { return isBlocked; }
+
+private:
+
+    double enterDistance;
+    double exitDistance;
+    bool isBlocked;
+};
+
+#endif	/* SONARFILTER_H */
@@ -3,65 +3,293 @@
 //ROS libraries
 #include <message_filters/subscriber.h>
 #include <message_filters/time_synchronizer.h>
+#include <message_filters/synchronizer.h>
+#include <message_filters/sync_policies/approximate_time.h>
 
 //ROS messages
 #include <std_msgs/UInt8.h>
+#include <std_msgs/Float32MultiArray.h>
+#include <std_msgs/Float64MultiArray.h>
 #include <sensor_msgs/Range.h>
 
+//Package include
+#include <obstacleFuser.h>
+#include <obstacleNode.h>
+
+#include <algorithm>
+#include <cmath>
+
 using namespace std;
 
+namespace obstacle_detection {
+
+typedef message_filters::TimeSynchronizer<sensor_msgs::Range, sensor_msgs::Range, sensor_msgs::Range> ExactSonarSync;
+typedef message_filters::sync_policies::ApproximateTime<sensor_msgs::Range, sensor_msgs::Range, sensor_msgs::Range> ApproximateSonarPolicy;
+typedef message_filters::Synchronizer<ApproximateSonarPolicy> ApproximateSonarSync;
+
+enum Sonar { LEFT = 0, CENTER, RIGHT, SONAR_COUNT };
+
+// Layout of the Float32MultiArray published on /<rover>/obstacle_field.
+// Ranges are the filtered sonar ranges in meters. Proximities run from 0 when
+// nothing is within proximity_range to 1 at collision_distance or closer.
+enum ObstacleField {
+    FIELD_RANGE_LEFT = 0, FIELD_RANGE_CENTER, FIELD_RANGE_RIGHT,
+    FIELD_PROXIMITY_LEFT, FIELD_PROXIMITY_CENTER, FIELD_PROXIMITY_RIGHT,
+    FIELD_SIZE
+};
+
 //Globals
 double collisionDistance = 0.4; //meters the ultrasonic detectors will flag obstacles
+double clearDistance = 0.5; //meters a flagged sensor has to read before the obstacle is cleared
+double repeatInterval = 0.1; //seconds between repeats of an unchanged obstacle, 0 repeats every triplet
+double proximityRange = 1.0; //meters at which the obstacle field proximity starts to rise above 0
+double fieldRate = 10.0; //Hz, most obstacle field messages per second
+double fieldChangeThreshold = 0.02; //meters a range has to move before the field is republished
+double fieldKeepalive = 1.0; //seconds after which an unchanged field is republished anyway
+bool traceEnabled = false; //publish a latency trace with every obstacle message
 string publishedName;
-char host[128];
+
+// How the three sonar streams are combined into one triplet
+//   exact:       header stamps must match exactly
+//   approximate: closest stamps within the queue are paired
+//   latest:      most recent reading of each sonar, fused at fusion_rate
+string syncMode;
+double fusionRate = 10.0; //Hz, latest mode only
+double maxSonarAge = 0.5; //seconds before a reading is too old to fuse, latest mode only
+
+sensor_msgs::Range::ConstPtr latestSonar[SONAR_COUNT];
+ros::Time latestSonarReceived[SONAR_COUNT];
+bool latestSonarFused[SONAR_COUNT] = { true, true, true };
+
+unsigned long sonarMessagesReceived = 0;
+unsigned long tripletsMatched = 0;
+unsigned long readingsReplaced = 0; // latest mode readings overwritten before they were fused
+
+ObstacleFuser fuser;
+std_msgs::Float32MultiArray lastField;
+ros::Time lastFieldPublish;
 
 //Publishers
 ros::Publisher obstaclePublish;
+ros::Publisher obstacleFieldPublish;
+ros::Publisher obstacleTracePublish;
+
+//Subscribers, kept here so they outlive start()
+message_filters::Subscriber<sensor_msgs::Range> sonarLeftSubscriber;
+message_filters::Subscriber<sensor_msgs::Range> sonarCenterSubscriber;
+message_filters::Subscriber<sensor_msgs::Range> sonarRightSubscriber;
+boost::shared_ptr<ExactSonarSync> exactSync;
+boost::shared_ptr<ApproximateSonarSync> approximateSync;
+
+//Timers
+ros::Timer fusionTimer;
+ros::Timer fusionStatsTimer;
 
 //Callback handlers
 void sonarHandler(const sensor_msgs::Range::ConstPtr& sonarLeft, const sensor_msgs::Range::ConstPtr& sonarCenter, const sensor_msgs::Range::ConstPtr& sonarRight);
+void syncedSonarHandler(const sensor_msgs::Range::ConstPtr& sonarLeft, const sensor_msgs::Range::ConstPtr& sonarCenter, const sensor_msgs::Range::ConstPtr& sonarRight);
+void sonarReceived(const sensor_msgs::Range::ConstPtr& sonar, int index);
+void fusionTimerEventHandler(const ros::TimerEvent& event);
+void fusionStatsTimerEventHandler(const ros::TimerEvent& event);
+void publishObstacleField();
 
-int main(int argc, char** argv) {
-    gethostname(host, sizeof (host));
-    string hostname(host);
-    
-    if (argc >= 2) {
-        publishedName = argv[1];
-        cout << "Welcome to the world of tomorrow " << publishedName << "! Obstacle module started." << endl;
-    } else {
-        publishedName = hostname;
-        cout << "No name selected. Default is: " << publishedName << endl;
+void start(ros::NodeHandle& oNH, ros::NodeHandle& param, const string& name) {
+    publishedName = name;
+
+    param.param("sync_mode", syncMode, string("approximate"));
+    param.param("fusion_rate", fusionRate, fusionRate);
+    param.param("max_sonar_age", maxSonarAge, maxSonarAge);
+
+    string filterName;
+    int medianWindow;
+    double emaAlpha;
+    param.param("filter", filterName, string("median"));
+    param.param("median_window", medianWindow, 3);
+    param.param("ema_alpha", emaAlpha, 0.5);
+    param.param("collision_distance", collisionDistance, collisionDistance);
+    param.param("clear_distance", clearDistance, clearDistance);
+    param.param("repeat_interval", repeatInterval, repeatInterval);
+    param.param("proximity_range", proximityRange, proximityRange);
+    param.param("field_rate", fieldRate, fieldRate);
+    param.param("field_change_threshold", fieldChangeThreshold, fieldChangeThreshold);
+    param.param("field_keepalive", fieldKeepalive, fieldKeepalive);
+    param.param("trace", traceEnabled, traceEnabled);
+
+    SonarFilter::Mode filterMode;
+    if (!SonarFilter::parseMode(filterName, filterMode)) {
+        cout << "Unknown filter " << filterName << ", falling back to median" << endl;
+        filterMode = SonarFilter::MEDIAN;
+    }
+    fuser.configure(filterMode, medianWindow, emaAlpha, collisionDistance, clearDistance, repeatInterval, proximityRange);
+    if (syncMode != "exact" && syncMode != "approximate" && syncMode != "latest") {
+        cout << "Unknown sync_mode " << syncMode << ", falling back to approximate" << endl;
+        syncMode = "approximate";
     }
 
-    ros::init(argc, argv, (publishedName + "_OBSTACLE"));
-    ros::NodeHandle oNH;
-    
     obstaclePublish = oNH.advertise<std_msgs::UInt8>((publishedName + "/obstacle"), 10);
-    
-    message_filters::Subscriber<sensor_msgs::Range> sonarLeftSubscriber(oNH, (publishedName + "/sonarLeft"), 10);
-    message_filters::Subscriber<sensor_msgs::Range> sonarCenterSubscriber(oNH, (publishedName + "/sonarCenter"), 10);
-    message_filters::Subscriber<sensor_msgs::Range> sonarRightSubscriber(oNH, (publishedName + "/sonarRight"), 10);	
-    message_filters::TimeSynchronizer<sensor_msgs::Range, sensor_msgs::Range, sensor_msgs::Range> sonarSync(sonarLeftSubscriber, sonarCenterSubscriber, sonarRightSubscriber, 10);
-	sonarSync.registerCallback(boost::bind(&sonarHandler, _1, _2, _3));
+    obstacleFieldPublish = oNH.advertise<std_msgs::Float32MultiArray>((publishedName + "/obstacle_field"), 10);
+    if (traceEnabled) {
+        obstacleTracePublish = oNH.advertise<std_msgs::Float64MultiArray>((publishedName + "/obstacle/trace"), 10);
+    }
+
+    sonarLeftSubscriber.subscribe(oNH, (publishedName + "/sonarLeft"), 10);
+    sonarCenterSubscriber.subscribe(oNH, (publishedName + "/sonarCenter"), 10);
+    sonarRightSubscriber.subscribe(oNH, (publishedName + "/sonarRight"), 10);
+
+    // Every reading passes through sonarReceived so the fusion stats can count
+    // the readings that never become part of a triplet
+    sonarLeftSubscriber.registerCallback(boost::bind(&sonarReceived, _1, LEFT));
+    sonarCenterSubscriber.registerCallback(boost::bind(&sonarReceived, _1, CENTER));
+    sonarRightSubscriber.registerCallback(boost::bind(&sonarReceived, _1, RIGHT));
 
-    ros::spin();
+    if (syncMode == "exact") {
+        exactSync.reset(new ExactSonarSync(sonarLeftSubscriber, sonarCenterSubscriber, sonarRightSubscriber, 10));
+        exactSync->registerCallback(boost::bind(&syncedSonarHandler, _1, _2, _3));
+    } else if (syncMode == "approximate") {
+        approximateSync.reset(new ApproximateSonarSync(ApproximateSonarPolicy(10), sonarLeftSubscriber, sonarCenterSubscriber, sonarRightSubscriber));
+        approximateSync->registerCallback(boost::bind(&syncedSonarHandler, _1, _2, _3));
+    } else {
+        fusionTimer = oNH.createTimer(ros::Duration(1.0 / fusionRate), fusionTimerEventHandler);
+    }
+
+    fusionStatsTimer = oNH.createTimer(ros::Duration(30.0), fusionStatsTimerEventHandler);
+}
 
-    return EXIT_SUCCESS;
+void stop() {
+    fusionTimer.stop();
+    fusionStatsTimer.stop();
+    exactSync.reset();
+    approximateSync.reset();
+    sonarLeftSubscriber.unsubscribe();
+    sonarCenterSubscriber.unsubscribe();
+    sonarRightSubscriber.unsubscribe();
+    obstaclePublish.shutdown();
+    obstacleFieldPublish.shutdown();
+    obstacleTracePublish.shutdown();
 }
 
+void sonarReceived(const sensor_msgs::Range::ConstPtr& sonar, int index) {
+    sonarMessagesReceived++;
+
+    if (syncMode == "latest") {
+        if (!latestSonarFused[index]) {
+            readingsReplaced++;
+        }
+        latestSonar[index] = sonar;
+        latestSonarReceived[index] = ros::Time::now();
+        latestSonarFused[index] = false;
+    }
+}
+
+void syncedSonarHandler(const sensor_msgs::Range::ConstPtr& sonarLeft, const sensor_msgs::Range::ConstPtr& sonarCenter, const sensor_msgs::Range::ConstPtr& sonarRight) {
+    tripletsMatched++;
+    sonarHandler(sonarLeft, sonarCenter, sonarRight);
+}
+
+// Fuses the newest reading from each sonar. Skips the tick if nothing new has
+// arrived or any sonar has gone quiet for longer than max_sonar_age.
+void fusionTimerEventHandler(const ros::TimerEvent& event) {
+    ros::Time now = ros::Time::now();
+    bool anyNew = false;
+
+    for (int i = 0; i < SONAR_COUNT; i++) {
+        if (!latestSonar[i] || (now - latestSonarReceived[i]).toSec() > maxSonarAge) {
+            return;
+        }
+        anyNew = anyNew || !latestSonarFused[i];
+    }
+
+    if (!anyNew) {
+        return;
+    }
+
+    for (int i = 0; i < SONAR_COUNT; i++) {
+        latestSonarFused[i] = true;
+    }
+
+    tripletsMatched++;
+    sonarHandler(latestSonar[LEFT], latestSonar[CENTER], latestSonar[RIGHT]);
+}
+
+void fusionStatsTimerEventHandler(const ros::TimerEvent& event) {
+    unsigned long dropped;
+    if (syncMode == "latest") {
+        dropped = readingsReplaced;
+    } else {
+        // Readings still waiting in the synchronizer queue count as dropped
+        // until they are matched
+        unsigned long used = 3 * tripletsMatched;
+        dropped = (sonarMessagesReceived > used) ? sonarMessagesReceived - used : 0;
+    }
+
+    ROS_INFO("Sonar fusion (%s): %lu triplets matched, %lu of %lu readings dropped",
+             syncMode.c_str(), tripletsMatched, dropped, sonarMessagesReceived);
+}
+
+// Filters each range, applies the enter/exit hysteresis and publishes the
+// obstacle state when the fuser says so, see obstacleFuser.h
 void sonarHandler(const sensor_msgs::Range::ConstPtr& sonarLeft, const sensor_msgs::Range::ConstPtr& sonarCenter, const sensor_msgs::Range::ConstPtr& sonarRight) {
-	std_msgs::UInt8 obstacleMode;
-	
-	if ((sonarLeft->range > collisionDistance) && (sonarCenter->range > collisionDistance) && (sonarRight->range > collisionDistance)) {
-		obstacleMode.data = 0; //no collision
-	}
-	else if ((sonarLeft->range > collisionDistance) && (sonarRight->range < collisionDistance)) {
-		obstacleMode.data = 1; //collision on right side
+	ros::Time received = ros::Time::now();
+
+	double ranges[SONAR_COUNT];
+	ranges[LEFT] = sonarLeft->range;
+	ranges[CENTER] = sonarCenter->range;
+	ranges[RIGHT] = sonarRight->range;
+
+	ObstacleFuser::ObstacleMode mode;
+	bool publish = fuser.update(ranges, received.toSec(), mode);
+
+	publishObstacleField();
+
+	if (!publish) {
+		return;
 	}
-	else {
-		obstacleMode.data = 2; //collision in front or on left side
+
+	// Published by pointer so a nodelet subscriber gets it without a copy
+	std_msgs::UInt8Ptr obstacleMode(new std_msgs::UInt8);
+	obstacleMode->data = mode;
+
+	// Sent just ahead of the obstacle message so mobility can pair the two and
+	// forward the trace with the velocity command it causes
+	if (traceEnabled) {
+		std_msgs::Float64MultiArrayPtr trace(new std_msgs::Float64MultiArray);
+		trace->data.push_back(min(sonarLeft->header.stamp, min(sonarCenter->header.stamp, sonarRight->header.stamp)).toSec());
+		trace->data.push_back(received.toSec());
+		trace->data.push_back(ros::Time::now().toSec());
+		obstacleTracePublish.publish(trace);
 	}
-	
-        obstaclePublish.publish(obstacleMode);
+	obstaclePublish.publish(obstacleMode);
+}
+
+// Publishes the filtered ranges and per sector proximity. Skipped when no range
+// moved by more than fieldChangeThreshold, except every fieldKeepalive seconds,
+// and never sent faster than fieldRate.
+void publishObstacleField() {
+    ros::Time now = ros::Time::now();
+    double sincePublish = (now - lastFieldPublish).toSec();
+
+    if (fieldRate > 0 && sincePublish < 1.0 / fieldRate) {
+        return;
+    }
+
+    bool changed = (lastField.data.size() != FIELD_SIZE);
+    for (int i = 0; i < SONAR_COUNT && !changed; i++) {
+        changed = fabs(fuser.range(i) - lastField.data[FIELD_RANGE_LEFT + i]) > fieldChangeThreshold;
+    }
+    if (!changed && sincePublish < fieldKeepalive) {
+        return;
+    }
+
+    std_msgs::Float32MultiArrayPtr field(new std_msgs::Float32MultiArray);
+    field->data.resize(FIELD_SIZE);
+    for (int i = 0; i < SONAR_COUNT; i++) {
+        field->data[FIELD_RANGE_LEFT + i] = fuser.range(i);
+        field->data[FIELD_PROXIMITY_LEFT + i] = fuser.proximity(i);
+    }
+
+    lastField = *field;
+    lastFieldPublish = now;
+    obstacleFieldPublish.publish(field);
 }
 
+} // namespace obstacle_detection
@@ -0,0 +1,60 @@
+#include "obstacleFuser.h"
+
+#include <algorithm>
+
+using namespace std;
+
+const int ObstacleFuser::sonarCount;
+
+ObstacleFuser::ObstacleFuser() : lastMode(-1), lastPublish(0.0) {
+    configure(SonarFilter::MEDIAN, 3, 0.5, 0.4, 0.5, 0.1, 1.0);
+}
+
+void ObstacleFuser::configure(SonarFilter::Mode filterMode, int medianWindow, double emaAlpha,
+                              double collisionDistance, double clearDistance,
+                              double repeatInterval, double proximityRange) {
+    for (int i = 0; i < sonarCount; i++) {
+        filters[i].configure(filterMode, medianWindow, emaAlpha);
+        hysteresis[i].configure(collisionDistance, clearDistance);
+        filtered[i] = 0.0;
+    }
+    this->collisionDistance = collisionDistance;
+    this->repeatInterval = repeatInterval;
+    this->proximityRange = proximityRange;
+}
+
+bool ObstacleFuser::update(const double ranges[sonarCount], double now, ObstacleMode& mode) {
+    for (int i = 0; i < sonarCount; i++) {
+        filtered[i] = filters[i].update(ranges[i]);
+    }
+
+    bool left = hysteresis[0].update(filtered[0]);
+    bool center = hysteresis[1].update(filtered[1]);
+    bool right = hysteresis[2].update(filtered[2]);
+
+    if (!left && !center && !right) {
+        mode = CLEAR;
+    } else if (!left && right) {
+        mode = BLOCKED_RIGHT;
+    } else {
+        mode = BLOCKED_FRONT;
+    }
+
+    bool changed = (mode != lastMode);
+    bool repeatDue = (mode != CLEAR) && (now - lastPublish >= repeatInterval);
+    if (!changed && !repeatDue) {
+        return false;
+    }
+
+    lastMode = mode;
+    lastPublish = now;
+    return true;
+}
+
+double ObstacleFuser::proximity(int sonar) const {
+    double proximity = 1.0;
+    if (proximityRange > collisionDistance) {
+        proximity = (proximityRange - filtered[sonar]) / (proximityRange - collisionDistance);
+    }
+    return max(0.0, min(proximity, 1.0));
+}
@@ -0,0 +1,30 @@
+#include <ros/ros.h>
+
+#include <obstacleNode.h>
+
+using namespace std;
+
+int main(int argc, char** argv) {
+    char host[128];
+    gethostname(host, sizeof (host));
+    string hostname(host);
+    string publishedName;
+
+    if (argc >= 2) {
+        publishedName = argv[1];
+        cout << "Welcome to the world of tomorrow " << publishedName << "! Obstacle module started." << endl;
+    } else {
+        publishedName = hostname;
+        cout << "No name selected. Default is: " << publishedName << endl;
+    }
+
+    ros::init(argc, argv, (publishedName + "_OBSTACLE"));
+    ros::NodeHandle oNH;
+    ros::NodeHandle param("~");
+
+    obstacle_detection::start(oNH, param, publishedName);
+    ros::spin();
+    obstacle_detection::stop();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,40 @@
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+
+#include <obstacleNode.h>
+
+using namespace std;
+
+namespace obstacle_detection {
+
+// Runs obstacle detection inside a nodelet manager so the sonar readings from
+// abridge and the obstacle messages to mobility are passed as shared pointers
+// when those run in the same manager. The rover name is the first nodelet
+// argument, or the hostname.
+class ObstacleNodelet : public nodelet::Nodelet {
+public:
+
+    ~ObstacleNodelet() {
+        stop();
+    }
+
+private:
+
+    virtual void onInit() {
+        string publishedName;
+        if (!getMyArgv().empty()) {
+            publishedName = getMyArgv()[0];
+        } else {
+            char host[128];
+            gethostname(host, sizeof (host));
+            publishedName = host;
+        }
+        NODELET_INFO("Obstacle nodelet started for %s", publishedName.c_str());
+
+        start(getNodeHandle(), getPrivateNodeHandle(), publishedName);
+    }
+};
+
+}
+
+PLUGINLIB_EXPORT_CLASS(obstacle_detection::ObstacleNodelet, nodelet::Nodelet)
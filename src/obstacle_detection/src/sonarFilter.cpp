@@ -0,0 +1,85 @@
+#include "sonarFilter.h"
+
+#include <algorithm>
+
+using namespace std;
+
+const int SonarFilter::maxWindow;
+
+SonarFilter::SonarFilter() : mode(NONE), window(1), alpha(1.0) {
+    reset();
+}
+
+void SonarFilter::configure(Mode mode, int window, double alpha) {
+    this->mode = mode;
+    this->window = max(1, min(window, maxWindow));
+    this->alpha = max(0.0, min(alpha, 1.0));
+    reset();
+}
+
+double SonarFilter::update(double range) {
+    switch (mode) {
+        case MEDIAN:
+        {
+            readings[nextReading] = range;
+            nextReading = (nextReading + 1) % window;
+            if (readingCount < window) {
+                readingCount++;
+            }
+
+            double sorted[maxWindow];
+            copy(readings, readings + readingCount, sorted);
+            nth_element(sorted, sorted + readingCount / 2, sorted + readingCount);
+            return sorted[readingCount / 2];
+        }
+
+        case EMA:
+            if (readingCount == 0) {
+                average = range;
+                readingCount = 1;
+            } else {
+                average += alpha * (range - average);
+            }
+            return average;
+
+        case NONE:
+            break;
+    }
+    return range;
+}
+
+void SonarFilter::reset() {
+    readingCount = 0;
+    nextReading = 0;
+    average = 0.0;
+}
+
+bool SonarFilter::parseMode(const string& name, Mode& mode) {
+    if (name == "none") {
+        mode = NONE;
+    } else if (name == "median") {
+        mode = MEDIAN;
+    } else if (name == "ema") {
+        mode = EMA;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+SonarHysteresis::SonarHysteresis() : enterDistance(0.0), exitDistance(0.0), isBlocked(false) {
+}
+
+void SonarHysteresis::configure(double enterDistance, double exitDistance) {
+    this->enterDistance = enterDistance;
+    this->exitDistance = max(enterDistance, exitDistance);
+}
+
+bool SonarHysteresis::update(double range) {
+    if (isBlocked) {
+        isBlocked = (range <= exitDistance);
+    } else {
+        isBlocked = (range < enterDistance);
+    }
+    return isBlocked;
+}
@@ -0,0 +1,108 @@
+#include "ArenaLayout.h"
+#include <math.h>
+#include <stdlib.h>
+
+// Object clearance values: radius in meters. Values taken from the max dimension of the gazebo collision box for the object.
+// So one half the distance from two opposing corners of the bounding box. Values are rounded up to the nearest 10cm.
+static const float target_cluster_size_64_clearance = 0.8;
+static const float target_cluster_size_16_clearance = 0.6;
+static const float target_cluster_size_4_clearance = 0.2;
+static const float target_cluster_size_1_clearance = 0.1;
+
+static const float barrier_clearance = 0.5; // Used to prevent targets being placed to close to walls
+
+ArenaLayout::ArenaLayout(GazeboSimManager& sim_mgr, float arena_dim) : sim_mgr(sim_mgr), arena_dim(arena_dim)
+{
+}
+
+void ArenaLayout::queueWalls(QString barrier_model)
+{
+    // Setting wall clearance to zero - radius of a wall does not make sense. Barrier clearance values ensure models are not placed on the walls.
+    sim_mgr.queueModel(barrier_model, "Barrier_West", -arena_dim/2, 0, 0, 0 );
+    sim_mgr.queueModel(barrier_model, "Barrier_North", 0, -arena_dim/2, 0, 0, 0, M_PI/2, 0);
+    sim_mgr.queueModel(barrier_model, "Barrier_East", arena_dim/2, 0, 0, 0 );
+    sim_mgr.queueModel(barrier_model, "Barrier_South", 0, arena_dim/2, 0, 0, 0, M_PI/2, 0);
+}
+
+void ArenaLayout::queueUniformTargets()
+{
+    float proposed_x;
+    float proposed_y;
+
+    // 256 piles of 1 tag
+    for (int i = 0; i < target_count; i++)
+    {
+        proposeLocation(target_cluster_size_1_clearance, proposed_x, proposed_y);
+        sim_mgr.queueModel(QString("at")+QString::number(0), QString("at")+QString::number(i), proposed_x, proposed_y, 0, target_cluster_size_1_clearance);
+    }
+}
+
+void ArenaLayout::queueClusteredTargets()
+{
+    int target_index = 0;
+
+    // Four piles of 64
+    for (int i = 0; i < 4; i++) queueCluster(8, target_cluster_size_64_clearance, target_index);
+}
+
+void ArenaLayout::queuePowerLawTargets()
+{
+    int target_index = 0;
+
+    // One pile of 64
+    queueCluster(8, target_cluster_size_64_clearance, target_index);
+
+    // Four piles of 16
+    for (int i = 0; i < 4; i++) queueCluster(4, target_cluster_size_16_clearance, target_index);
+
+    // Sixteen piles of 4
+    for (int i = 0; i < 16; i++) queueCluster(2, target_cluster_size_4_clearance, target_index);
+
+    // Sixty-four piles of 1 (using tags 192 through 255 to avoid duplication with piles above)
+    while (target_index < target_count) queueCluster(1, target_cluster_size_1_clearance, target_index);
+}
+
+void ArenaLayout::queueCluster(int side, float clearance, int& target_index)
+{
+    float proposed_x, proposed_x2;
+    float proposed_y, proposed_y2;
+
+    proposeLocation(clearance, proposed_x, proposed_y);
+
+    // A single target is placed at the proposed location itself
+    if (side == 1)
+    {
+        sim_mgr.queueModel(QString("at")+QString::number(0), QString("at")+QString::number(target_index), proposed_x, proposed_y, 0, clearance);
+        target_index++;
+        return;
+    }
+
+    proposed_y2 = proposed_y - (target_cluster_size_1_clearance * side);
+
+    for(int j = 0; j < side; j++) {
+        proposed_x2 = proposed_x - (target_cluster_size_1_clearance * side);
+
+        for(int k = 0; k < side; k++) {
+            sim_mgr.queueModel(QString("at")+QString::number(0), QString("at")+QString::number(target_index), proposed_x2, proposed_y2, 0, target_cluster_size_1_clearance);
+            proposed_x2 += target_cluster_size_1_clearance;
+            target_index++;
+        }
+
+        proposed_y2 += target_cluster_size_1_clearance;
+    }
+}
+
+void ArenaLayout::proposeLocation(float clearance, float& x, float& y)
+{
+    // d is the distance from the center of the arena to the boundary minus the barrier clearance, i.e. the region where tags can be placed
+    // is d - U(0,2d) where U(a,b) is a uniform distribition bounded by a and b.
+    // (before checking for collisions including the collection disk at the center)
+    float d = arena_dim/2.0-(barrier_clearance+clearance);
+
+    do
+    {
+        x = d - ((float) rand()) / RAND_MAX*2*d;
+        y = d - ((float) rand()) / RAND_MAX*2*d;
+    }
+    while (sim_mgr.isLocationOccupied(x, y, clearance));
+}
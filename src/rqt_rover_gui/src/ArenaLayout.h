@@ -0,0 +1,40 @@
+#ifndef ARENALAYOUT_H
+#define ARENALAYOUT_H
+
+#include <QString>
+
+#include "GazeboSimManager.h"
+
+// Places the walls and targets of a competition arena through a GazeboSimManager. The models are
+// only queued so the caller decides how to wait on GazeboSimManager::spawnQueuedModels, the GUI with
+// a progress dialog and the experiment runner without one. Locations are drawn with rand() so callers
+// seed it with srand() to reproduce a layout.
+class ArenaLayout
+{
+public:
+    ArenaLayout(GazeboSimManager& sim_mgr, float arena_dim);
+
+    // The four walls around the arena, given the name of the barrier model for its size
+    void queueWalls(QString barrier_model);
+
+    // 256 single targets
+    void queueUniformTargets();
+    // 256 targets in four clusters of 64
+    void queueClusteredTargets();
+    // 256 targets in one cluster of 64, four of 16, sixteen of 4 and sixty four single targets
+    void queuePowerLawTargets();
+
+    // Number of targets queued by each of the layouts above
+    static const int target_count = 256;
+
+private:
+    // Queues a square cluster of side x side targets named from target_index onwards
+    void queueCluster(int side, float clearance, int& target_index);
+    // Draws locations until one is clear of every model already placed
+    void proposeLocation(float clearance, float& x, float& y);
+
+    GazeboSimManager& sim_mgr;
+    float arena_dim; // in meters
+};
+
+#endif // ARENALAYOUT_H
@@ -1,27 +1,42 @@
 #include <CameraFrame.h>
+#include "GUIProfiler.h"
+#include "RepaintScheduler.h"
 
 namespace rqt_rover_gui
 {
 
 CameraFrame::CameraFrame(QWidget *parent, Qt::WFlags flags) : QFrame(parent)
 {
-    connect(this, SIGNAL(delayedUpdate()), this, SLOT(update()), Qt::QueuedConnection);
+    RepaintScheduler::instance().add(this);
 
         frames = 0;
+        image_swap_rgb = false;
+        image_pending = false;
 }
 
 void CameraFrame::paintEvent(QPaintEvent* event)
 {
+    ScopedTimer timer("CameraFrame::paintEvent");
+
     QPainter painter(this);
     painter.setPen(Qt::white);
 
 
     image_update_mutex.lock();
-    if (!(image.isNull()))
+
+    // Convert the frame once, at the size it is drawn
+    if (!image.isNull() && (image_pending || display_image.size() != contentsRect().size()))
+    {
+        display_image = image.scaled(contentsRect().size(), Qt::IgnoreAspectRatio, Qt::FastTransformation);
+        if (image_swap_rgb) display_image = display_image.rgbSwapped();
+        image_pending = false;
+    }
+
+    if (!(display_image.isNull()))
     {
         //painter.drawText(QPoint(50,50), "Image Received From Camera");
 
-        painter.drawImage(contentsRect(), image);
+        painter.drawImage(contentsRect(), display_image);
 
         if(target_corners_1.size() > 0) 
         {
@@ -78,11 +93,25 @@ void CameraFrame::paintEvent(QPaintEvent* event)
 }
 
 void CameraFrame::setImage(const QImage& img)
+{
+    setImage(img.copy(), boost::shared_ptr<const void>(), false);
+}
+
+void CameraFrame::setImage(const QImage& img, boost::shared_ptr<const void> owner, bool swap_rgb)
 {
     image_update_mutex.lock();
-    image = img.copy();
+
+    // Only ask for a repaint if the last frame has been drawn, otherwise this one replaces it
+    bool repaint = !image_pending;
+
+    image = img;
+    image_owner = owner;
+    image_swap_rgb = swap_rgb;
+    image_pending = true;
+
     image_update_mutex.unlock();
-    emit delayedUpdate();
+
+    if (repaint) RepaintScheduler::instance().markDirty(this);
 }
 
 void CameraFrame::addTarget(std::pair<double,double> c1, std::pair<double,double> c2, std::pair<double,double> c3,
@@ -95,5 +124,10 @@ void CameraFrame::addTarget(std::pair<double,double> c1, std::pair<double,double
     target_centers.push_back(center);
 }
 
+CameraFrame::~CameraFrame()
+{
+    RepaintScheduler::instance().remove(this);
+}
+
 }
 
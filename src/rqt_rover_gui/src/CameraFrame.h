@@ -19,6 +19,7 @@
 #include <QMutex>
 #include <QPainter>
 #include <QPointF>
+#include <boost/shared_ptr.hpp>
 
 namespace rqt_rover_gui
 {
@@ -28,15 +29,19 @@ class CameraFrame : public QFrame
     Q_OBJECT
 public:
     CameraFrame(QWidget *parent, Qt::WFlags = 0);
+    ~CameraFrame();
 
     void setImage(const QImage& image);
+
+    // Shows a frame without copying it. The image may refer to memory held by owner,
+    // which is kept until the frame is replaced. The frame is only scaled to the
+    // display size, and has its red and blue swapped if swap_rgb is set, when it is
+    // drawn. A frame that arrives before the last one was drawn replaces it, so a
+    // slow display drops frames instead of queueing them.
+    void setImage(const QImage& image, boost::shared_ptr<const void> owner, bool swap_rgb);
     // four corners of tag
     void addTarget(std::pair<double,double> c1, std::pair<double,double> c2, std::pair<double,double> c3, std::pair<double,double> c4, std::pair<double,double> center);
 
-signals:
-
-    void delayedUpdate();
-
 public slots:
 
 
@@ -46,7 +51,12 @@ protected:
 
 private:
 
-    QImage image;
+    QImage image; // The latest frame as received
+    boost::shared_ptr<const void> image_owner;
+    bool image_swap_rgb;
+    bool image_pending; // A frame was received that has not been drawn yet
+
+    QImage display_image; // The latest frame as drawn
     mutable QMutex image_update_mutex;
 
     QTime frame_rate_timer;
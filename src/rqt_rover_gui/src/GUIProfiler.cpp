@@ -0,0 +1,130 @@
+#include "GUIProfiler.h"
+#include <QFile>
+#include <QMutexLocker>
+#include <QTextStream>
+#include <algorithm>
+#include <utility> // For pair
+#include <vector>
+
+GUIProfiler& GUIProfiler::instance()
+{
+    static GUIProfiler profiler;
+    return profiler;
+}
+
+GUIProfiler::GUIProfiler()
+{
+    enabled = false;
+}
+
+void GUIProfiler::setEnabled(bool enabled)
+{
+    this->enabled = enabled;
+}
+
+void GUIProfiler::record(const char* name, qint64 microseconds)
+{
+    if (!enabled) return;
+
+    // Clock differences between the rovers and the GUI can make message ages negative
+    microseconds = std::max(microseconds, (qint64) 0);
+
+    int bucket = 0;
+    while (bucket < bucket_count - 1 && (((qint64) 1) << bucket) <= microseconds) bucket++;
+
+    QMutexLocker lock(&mutex);
+    Histogram& histogram = histograms[name];
+    histogram.count++;
+    histogram.total += microseconds;
+    histogram.max = std::max(histogram.max, microseconds);
+    histogram.buckets[bucket]++;
+}
+
+void GUIProfiler::clear()
+{
+    QMutexLocker lock(&mutex);
+    histograms.clear();
+}
+
+QString GUIProfiler::summary()
+{
+    vector< pair<qint64, QString> > rows;
+
+    {
+        QMutexLocker lock(&mutex);
+        for (map<string, Histogram>::iterator it = histograms.begin(); it != histograms.end(); ++it)
+        {
+            const Histogram& histogram = it->second;
+            QString row = "<tr><td>" + QString::fromStdString(it->first) + "</td>"
+                    + "<td align=right>" + QString::number(histogram.count) + "</td>"
+                    + "<td align=right>" + QString::number(histogram.total / 1000.0 / histogram.count, 'f', 2) + "</td>"
+                    + "<td align=right>" + QString::number(histogram.percentile(0.5) / 1000.0, 'f', 2) + "</td>"
+                    + "<td align=right>" + QString::number(histogram.percentile(0.95) / 1000.0, 'f', 2) + "</td>"
+                    + "<td align=right>" + QString::number(histogram.percentile(0.99) / 1000.0, 'f', 2) + "</td>"
+                    + "<td align=right>" + QString::number(histogram.max / 1000.0, 'f', 2) + "</td>"
+                    + "<td align=right>" + QString::number(histogram.total / 1000.0, 'f', 0) + "</td></tr>";
+            rows.push_back(make_pair(histogram.total, row));
+        }
+    }
+
+    // The biggest costs first since they are the likeliest cause of a stall
+    sort(rows.begin(), rows.end());
+
+    QString output = "<table cellspacing=4><tr><th align=left>Timer</th><th>Count</th><th>Mean ms</th><th>p50 ms</th><th>p95 ms</th><th>p99 ms</th><th>Max ms</th><th>Total ms</th></tr>";
+    for (vector< pair<qint64, QString> >::reverse_iterator it = rows.rbegin(); it != rows.rend(); ++it) output += it->second;
+    output += "</table>";
+
+    return output;
+}
+
+bool GUIProfiler::exportToFile(QString path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) return false;
+
+    QTextStream output(&file);
+    output << "timer,count,total_us,max_us,p50_us,p95_us,p99_us";
+    for (int i = 0; i < bucket_count; i++) output << ",under_" << (((qint64) 1) << i) << "_us";
+    output << "\n";
+
+    QMutexLocker lock(&mutex);
+    for (map<string, Histogram>::iterator it = histograms.begin(); it != histograms.end(); ++it)
+    {
+        const Histogram& histogram = it->second;
+        output << QString::fromStdString(it->first) << "," << histogram.count << "," << histogram.total << "," << histogram.max
+               << "," << histogram.percentile(0.5) << "," << histogram.percentile(0.95) << "," << histogram.percentile(0.99);
+        for (int i = 0; i < bucket_count; i++) output << "," << histogram.buckets[i];
+        output << "\n";
+    }
+
+    file.close();
+    return file.error() == QFile::NoError;
+}
+
+GUIProfiler::Histogram::Histogram() : count(0), total(0), max(0)
+{
+    for (int i = 0; i < bucket_count; i++) buckets[i] = 0;
+}
+
+qint64 GUIProfiler::Histogram::percentile(double fraction) const
+{
+    qint64 rank = fraction * count;
+    qint64 seen = 0;
+    for (int i = 0; i < bucket_count; i++)
+    {
+        seen += buckets[i];
+        if (seen > rank) return std::min(((qint64) 1) << i, max);
+    }
+    return max;
+}
+
+ScopedTimer::ScopedTimer(const char* name) : name(name)
+{
+    active = GUIProfiler::instance().isEnabled();
+    if (active) timer.start();
+}
+
+ScopedTimer::~ScopedTimer()
+{
+    if (active) GUIProfiler::instance().record(name, timer.nsecsElapsed() / 1000);
+}
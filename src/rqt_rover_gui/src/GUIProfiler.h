@@ -0,0 +1,70 @@
+#ifndef GUIPROFILER_H
+#define GUIPROFILER_H
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+#include <atomic>
+#include <map>
+#include <string>
+
+using namespace std;
+
+// Collects how long the GUI spends in each ROS callback and paint event, and how long messages
+// waited before their callback ran, as histograms with power of two buckets in microseconds.
+// Nothing is recorded until setEnabled(true) so the timers cost a single check when unused.
+// Safe to use from the ROS callback threads and the GUI thread at the same time.
+class GUIProfiler
+{
+public:
+    static GUIProfiler& instance();
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return enabled; }
+
+    // Adds a duration to the histogram for name, which should be a string literal
+    void record(const char* name, qint64 microseconds);
+    void clear();
+
+    // A table row per histogram, most total time first, in milliseconds
+    QString summary();
+    // Writes every histogram as CSV. Returns false if the file could not be written.
+    bool exportToFile(QString path);
+
+private:
+    GUIProfiler();
+
+    static const int bucket_count = 32; // The last bucket holds everything over 2^30 us, about 18 minutes
+
+    struct Histogram
+    {
+        Histogram();
+
+        // Upper bound of the bucket holding the given fraction of the durations, capped by the maximum
+        qint64 percentile(double fraction) const;
+
+        qint64 count;
+        qint64 total;
+        qint64 max;
+        qint64 buckets[bucket_count]; // Bucket i holds the durations under 2^i us that are not in bucket i-1
+    };
+
+    atomic<bool> enabled;
+    QMutex mutex;
+    map<string, Histogram> histograms;
+};
+
+// Records the time from its construction to its destruction in the GUIProfiler under name
+class ScopedTimer
+{
+public:
+    ScopedTimer(const char* name);
+    ~ScopedTimer();
+
+private:
+    const char* name;
+    bool active; // Whether the profiler was enabled when the timer started
+    QElapsedTimer timer;
+};
+
+#endif // GUIPROFILER_H
@@ -1,6 +1,19 @@
 #include "GazeboSimManager.h"
 #include <QDir>
+#include <QFile>
+#include <QtConcurrentMap>
+#include <QtConcurrentRun>
+#include <boost/bind.hpp>
+#include <ros/ros.h>
+#include <ros/master.h>
+#include <ros/network.h>
+#include <XmlRpc.h>
+#include <gazebo_msgs/SpawnModel.h>
+#include <gazebo_msgs/DeleteModel.h>
+#include <gazebo_msgs/SetModelState.h>
+#include <gazebo_msgs/ApplyBodyWrench.h>
 #include <string>
+#include <signal.h> // For kill
 #include <unistd.h>
 #include <iostream>
 #include <utility> // For pair
@@ -11,7 +24,10 @@ GazeboSimManager::GazeboSimManager()
 {
     gazebo_client_process = NULL;
     gazebo_server_process = NULL;
+    gazebo_server_pid = 0;
     command_process = NULL;
+    models_spawned = 0;
+    models_to_spawn = 0;
 
     // Set the app_root by reading the evvironment variable SWARMATHON_APP_ROOT ideally set by the run.sh script.
     const char *name = "SWARMATHON_APP_ROOT";
@@ -48,9 +64,8 @@ QProcess* GazeboSimManager::startGazeboServer( QString path )
 
     gazebo_server_process = new QProcess();
 
-    QString command = QString("rosrun gazebo_ros gzserver ") + path;
-
-    gazebo_server_process->startDetached(command);
+    // Detached processes run in a session of their own, keep the id so stopGazeboServer only stops this server
+    QProcess::startDetached("rosrun", QStringList() << "gazebo_ros" << "gzserver" << path, QString(), &gazebo_server_pid);
 
     gazebo_server_process->waitForStarted();
 
@@ -76,12 +91,24 @@ QString GazeboSimManager::stopGazeboServer()
 {
     if (gazebo_server_process == NULL) return "Gazebo server is not running";
 
-    QString argument = "pkill gzserver";
-    QProcess sh;
-    sh.start("sh", QStringList() << "-c" << argument);
-    sh.waitForFinished();
-    QString output = sh.readAll();
-    sh.close();
+    QString output;
+
+    // Signal the whole process group since rosrun leaves gzserver running as a child of its script.
+    // Never signal our own group in case the server was not given one of its own.
+    pid_t server_group = gazebo_server_pid > 0 ? getpgid(gazebo_server_pid) : -1;
+    if (server_group > 0 && server_group != getpgrp())
+    {
+        if (kill(-server_group, SIGTERM) != 0) output = "Could not stop the gazebo server process group " + QString::number(server_group);
+    }
+    else
+    {
+        QString argument = "pkill gzserver";
+        QProcess sh;
+        sh.start("sh", QStringList() << "-c" << argument);
+        sh.waitForFinished();
+        output = sh.readAll();
+        sh.close();
+    }
 
     gazebo_server_process->close();
     cleanUpGazeboServer();
@@ -96,7 +123,9 @@ void GazeboSimManager::cleanUpGazeboServer()
     // Use delete later here because this function is called by a slot connected to a signal from this object which will segfault if delete directely with "delete gazebo_client_process;"
     gazebo_server_process->deleteLater();
     gazebo_server_process = NULL;
+    gazebo_server_pid = 0;
     model_locations.clear();
+    queued_models.clear();
 }
 
 void GazeboSimManager::cleanUpGazeboClient()
@@ -134,10 +163,40 @@ QString GazeboSimManager::stopRoverNode( QString rover_name )
 {
     if (rover_processes.find(rover_name) == rover_processes.end()) return "Could not stop " + rover_name + " rover process since it does not exist.";
 
+    QString output = shutdownRoverNodes(rover_name);
+
+    // Stop the launch process last so it does not have to wait on the nodes above
     rover_processes[rover_name]->terminate();
     rover_processes[rover_name]->waitForFinished();
     rover_processes.erase(rover_name);
 
+    return output;
+}
+
+QFuture<QString> GazeboSimManager::stopRoverNodes(QList<QString> rover_names)
+{
+    return QtConcurrent::mapped(rover_names, boost::bind(&GazeboSimManager::shutdownRoverNodes, this, _1));
+}
+
+QString GazeboSimManager::stopRoverProcesses()
+{
+    QString output;
+
+    for (map<QString, QProcess*>::iterator it = rover_processes.begin(); it != rover_processes.end(); ++it) it->second->terminate();
+
+    for (map<QString, QProcess*>::iterator it = rover_processes.begin(); it != rover_processes.end(); ++it)
+    {
+        if (!it->second->waitForFinished()) output += "<br><font color='red'>The " + it->first + " rover process did not exit</font>";
+    }
+
+    rover_processes.clear();
+
+    return output;
+}
+
+// Safe to call from any thread, it only talks to the ROS master and the nodes
+QString GazeboSimManager::shutdownRoverNodes( QString rover_name )
+{
     // Names of the nodes to kill. 
     vector<QString> nodes;
     nodes.push_back("APRILTAG");
@@ -146,18 +205,17 @@ QString GazeboSimManager::stopRoverNode( QString rover_name )
     nodes.push_back("MAP");
     nodes.push_back("MOBILITY");
     nodes.push_back("NAVSAT");
+    nodes.push_back("NODELET_MANAGER"); // Only running when the rover was launched with nodelets:=true
     nodes.push_back("OBSTACLE");
     nodes.push_back("ODOM");
 
-    // Kill nodes
+    // Kill nodes. Asking the nodes to shut down directly is what rosnode kill does,
+    // without starting a python process per node.
     QString output = "";
     for (int i = 0; i < nodes.size(); i++) {
-      QString argument = "rosnode kill "+rover_name+"_"+nodes[i];
-      QProcess sh;
-      sh.start("sh", QStringList() << "-c" << argument);
-      sh.waitForFinished();
-      output += "<br>" + sh.readAll();
-      sh.close();
+      QString node_name = "/"+rover_name+"_"+nodes[i];
+      if (shutdownNode(node_name.toStdString())) output += "<br>killed " + node_name;
+      else output += "<br>could not kill " + node_name;
     }
 
     return output;
@@ -178,185 +236,361 @@ QString GazeboSimManager::startRoverNode( QString rover_name )
 
 QString GazeboSimManager::addGroundPlane( QString ground_name )
 {
-    QString argument = QString("rosrun gazebo_ros spawn_model -sdf -file ")+app_root+"/simulation/models/" + ground_name + "/model.sdf -model " + ground_name;
-    QProcess sh;
-    sh.start("sh", QStringList() << "-c" << argument);
-
-    sh.waitForFinished();
-    QByteArray output = sh.readAll();
-    sh.close();
-
-    QString return_msg = "<br><font color='yellow'>" + output + "</font><br>";
-
-    return return_msg;
+    QueuedModel model;
+    model.model_name = ground_name;
+    model.unique_id = ground_name;
+    model.x = 0;
+    model.y = 0;
+    model.z = 0;
+    model.roll = 0;
+    model.pitch = 0;
+    model.yaw = 0;
+
+    QString output;
+    spawnModel(model, output);
+    return output;
 }
 
 QString GazeboSimManager::addRover(QString rover_name, float x, float y, float z)
 {
     float rover_clearance = 0.45; //meters
-    model_locations.insert(make_tuple(x, y, rover_clearance));
-
-    QString argument = "rosrun gazebo_ros spawn_model -sdf -file "+app_root+"/simulation/models/" + rover_name + "/model.sdf "
-               + "-model " + rover_name
-               + " -x " + QString::number(x)
-               + " -y " + QString::number(y)
-               + " -z " + QString::number(z);
-               + " -Y " + QString::number(M_PI);
-
-    QProcess sh;
-    sh.start("sh", QStringList() << "-c" << argument);
+    model_locations.insert(x, y, rover_clearance);
+
+    QueuedModel model;
+    model.model_name = rover_name;
+    model.unique_id = rover_name;
+    model.x = x;
+    model.y = y;
+    model.z = z;
+    model.roll = 0;
+    model.pitch = 0;
+    model.yaw = 0;
+
+    QString output;
+    spawnModel(model, output);
+    return output;
+}
 
-    sh.waitForFinished();
-    QByteArray output = sh.readAll();
-    sh.close();
+QString GazeboSimManager::removeRover( QString rover_name)
+{
+    return removeModel(rover_name);
+}
 
-    QString return_msg = "<br><font color='yellow'>" + output + "</font><br>";
+QString GazeboSimManager::removeGroundPlane( QString ground_name )
+{
+    return removeModel(ground_name);
+}
 
-    return return_msg;
+QString GazeboSimManager::addModel(QString model_name, QString unique_id, float x, float y, float z, float clearance)
+{
+    return addModel(model_name, unique_id, x, y, z, 0, 0, 0, clearance);
 }
 
-QString GazeboSimManager::removeRover( QString rover_name)
+QString GazeboSimManager::addModel(QString model_name, QString unique_id, float x, float y, float z, float roll, float pitch, float yaw, float clearance)
 {
-    QString argument;
-    argument = "rosservice call gazebo/delete_model '{model_name: "+rover_name+"}'";
+    model_locations.insert(x, y, clearance);
+
+    QueuedModel model;
+    model.model_name = model_name;
+    model.unique_id = unique_id;
+    model.x = x;
+    model.y = y;
+    model.z = z;
+    model.roll = roll;
+    model.pitch = pitch;
+    model.yaw = yaw;
+
+    QString output;
+    spawnModel(model, output);
+    return output;
+}
 
-    QProcess sh;
-    sh.start("sh", QStringList() << "-c" << argument);
+void GazeboSimManager::queueModel(QString model_name, QString unique_id, float x, float y, float z, float clearance)
+{
+    queueModel(model_name, unique_id, x, y, z, 0, 0, 0, clearance);
+}
 
-    sh.waitForFinished();
-    QByteArray output = sh.readAll();
-    sh.close();
+void GazeboSimManager::queueModel(QString model_name, QString unique_id, float x, float y, float z, float roll, float pitch, float yaw, float clearance)
+{
+    model_locations.insert(x, y, clearance);
+
+    QueuedModel model;
+    model.model_name = model_name;
+    model.unique_id = unique_id;
+    model.x = x;
+    model.y = y;
+    model.z = z;
+    model.roll = roll;
+    model.pitch = pitch;
+    model.yaw = yaw;
+    queued_models.push_back(model);
+}
 
-    QString return_msg = "<br><font color='yellow'>" + output + "</font><br>";
+void GazeboSimManager::queueRover(QString rover_name, float x, float y, float z)
+{
+    float rover_clearance = 0.45; //meters
+    queueModel(rover_name, rover_name, x, y, z, rover_clearance);
+}
 
-    return return_msg;
+// The ground plane covers the whole arena so it does not reserve a location
+void GazeboSimManager::queueGroundPlane(QString ground_name)
+{
+    QueuedModel model;
+    model.model_name = ground_name;
+    model.unique_id = ground_name;
+    model.x = 0;
+    model.y = 0;
+    model.z = 0;
+    model.roll = 0;
+    model.pitch = 0;
+    model.yaw = 0;
+    queued_models.push_back(model);
 }
 
-QString GazeboSimManager::removeGroundPlane( QString ground_name )
+QFuture<QString> GazeboSimManager::spawnQueuedModels()
 {
-    QString argument = "rosservice call gazebo/delete_model '{model_name: "+ground_name+"}'";
+    // Only one batch is in flight at a time so the progress counter stays meaningful
+    spawn_future.waitForFinished();
 
-    QProcess sh;
-    sh.start("sh", QStringList() << "-c" << argument);
+    vector<QueuedModel> models;
+    models.swap(queued_models);
 
-    sh.waitForFinished();
-    QByteArray output = sh.readAll();
-    sh.close();
-
-    QString return_msg = "<br><font color='yellow'>" + output + "</font><br>";
+    models_spawned = 0;
+    models_to_spawn = models.size();
 
-    return return_msg;
+    spawn_future = QtConcurrent::run(this, &GazeboSimManager::spawnModels, models);
+    return spawn_future;
 }
 
-QString GazeboSimManager::addModel(QString model_name, QString unique_id, float x, float y, float z, float clearance)
+float GazeboSimManager::getSpawnProgress()
 {
-    return addModel(model_name, unique_id, x, y, z, 0, 0, 0, clearance);
+    if (models_to_spawn == 0) return 1;
+    return models_spawned/(float)models_to_spawn;
 }
 
-QString GazeboSimManager::addModel(QString model_name, QString unique_id, float x, float y, float z, float roll, float pitch, float yaw, float clearance)
+// Runs on a QtConcurrent worker thread. The service lock is taken per model so calls
+// from the GUI thread are not held up until the whole batch is done.
+QString GazeboSimManager::spawnModels(vector<QueuedModel> models)
 {
-    model_locations.insert(make_tuple(x, y, clearance));
+    if (models.empty()) return "";
 
-    QString argument = "rosrun gazebo_ros spawn_model -sdf -file "+app_root+"/simulation/models/" + model_name + "/model.sdf "
-            + "-model " + unique_id
-            + " -x "    + QString::number(x)
-            + " -y "    + QString::number(y)
-            + " -z "    + QString::number(z)
-            + " -R "    + QString::number(roll)
-            + " -P "    + QString::number(pitch)
-            + " -Y "    + QString::number(yaw);
+    if (!ros::service::waitForService("/gazebo/spawn_sdf_model", ros::Duration(30)))
+    {
+        return "<br><font color='red'>The gazebo spawn service is not available. No models were added.</font><br>";
+    }
 
-    QProcess sh;
-    sh.start("sh", QStringList() << "-c" << argument);
+    QString output;
+    int n_failed = 0;
 
-    sh.waitForFinished();
-    QByteArray output = sh.readAll();
-    sh.close();
+    for (int i = 0; i < models.size(); i++)
+    {
+        QString spawn_output;
+        if (!spawnModel(models[i], spawn_output))
+        {
+            n_failed++;
+            output += spawn_output;
+        }
 
-    QString return_msg = "<br><font color='yellow'>" + output + "</font><br>";
+        models_spawned++;
+    }
 
-    return return_msg;
+    output += "<br><font color='yellow'>Added " + QString::number(models.size()-n_failed) + " of " + QString::number(models.size()) + " models</font><br>";
+
+    return output;
 }
 
-QString GazeboSimManager::removeModel( QString model_name )
+// Returns true if the model was spawned. The log message for the result is written to output.
+bool GazeboSimManager::spawnModel(const QueuedModel& model, QString& output)
 {
-    QString argument = "rosservice call gazebo/delete_model '{model_name: "+model_name+"}'";
+    gazebo_msgs::SpawnModel spawn;
+    spawn.request.model_name = model.unique_id.toStdString();
 
-    QProcess sh;
-    sh.start("sh", QStringList() << "-c" << argument);
+    {
+        QMutexLocker locker(&service_mutex);
 
-    sh.waitForFinished();
-    QByteArray output = sh.readAll();
-    sh.close();
+        // The model file is only read once per model type
+        if (model_sdf.find(model.model_name) == model_sdf.end())
+        {
+            QFile sdf_file(app_root+"/simulation/models/" + model.model_name + "/model.sdf");
+            if (!sdf_file.open(QIODevice::ReadOnly))
+            {
+                output = "<br><font color='red'>Failed to add " + model.unique_id + ": could not read " + sdf_file.fileName() + "</font><br>";
+                return false;
+            }
+            model_sdf[model.model_name] = sdf_file.readAll().toStdString();
+        }
 
-    QString return_msg = "<br><font color='yellow'>" + output + "</font><br>";
+        spawn.request.model_xml = model_sdf[model.model_name];
+    }
 
-    return return_msg;
+    spawn.request.initial_pose.position.x = model.x;
+    spawn.request.initial_pose.position.y = model.y;
+    spawn.request.initial_pose.position.z = model.z;
+
+    // Quaternion from the roll, pitch and yaw angles
+    double cr = cos(model.roll/2), sr = sin(model.roll/2);
+    double cp = cos(model.pitch/2), sp = sin(model.pitch/2);
+    double cy = cos(model.yaw/2), sy = sin(model.yaw/2);
+    spawn.request.initial_pose.orientation.w = cr*cp*cy + sr*sp*sy;
+    spawn.request.initial_pose.orientation.x = sr*cp*cy - cr*sp*sy;
+    spawn.request.initial_pose.orientation.y = cr*sp*cy + sr*cp*sy;
+    spawn.request.initial_pose.orientation.z = cr*cp*sy - sr*sp*cy;
+
+    if (!callService("/gazebo/spawn_sdf_model", spawn))
+    {
+        output = "<br><font color='red'>Failed to add " + model.unique_id + ": the gazebo spawn service is not available</font><br>";
+        return false;
+    }
+
+    if (!spawn.response.success)
+    {
+        output = "<br><font color='red'>Failed to add " + model.unique_id + ": " + QString::fromStdString(spawn.response.status_message) + "</font><br>";
+        return false;
+    }
+
+    output = "<br><font color='yellow'>" + QString::fromStdString(spawn.response.status_message) + "</font><br>";
+    return true;
 }
 
-QString GazeboSimManager::moveRover(QString rover_name, float x, float y, float z)
+QString GazeboSimManager::removeModel( QString model_name )
 {
-            QString x_str = QString::number(x,'f',1);
-            QString y_str = QString::number(y,'f',1);
-            QString z_str = QString::number(z,'f',1);
-           // QString duration_str = QString::number(duration,'f',1);
-
-            QString argument = "rosservice call /gazebo/set_model_state '{model_state: { model_name: alpha, pose: { position: { x: 5, y: 0 ,z: 0 }, orientation: {x: 0, y: 0, z: 1, w: 1 } }, twist: { linear: {x: 0.0 , y: 0 ,z: 0 } , angular: { x: 0.0 , y: 0 , z: 0.0 } } , reference_frame: world } }'";
+    gazebo_msgs::DeleteModel remove;
+    remove.request.model_name = model_name.toStdString();
 
-            QProcess sh;
-            sh.start("sh", QStringList() << "-c" << argument);
+    if (!callService("/gazebo/delete_model", remove))
+    {
+        return "<br><font color='red'>Could not remove " + model_name + ": the gazebo delete service is not available</font><br>";
+    }
 
-            sh.waitForFinished();
-            QByteArray output = sh.readAll();
-            sh.close();
+    return "<br><font color='yellow'>" + QString::fromStdString(remove.response.status_message) + "</font><br>";
+}
 
-            QString return_msg = "<br><font color='yellow'>" + output + "</font><br>";
+QString GazeboSimManager::moveRover(QString rover_name, float x, float y, float z)
+{
+    gazebo_msgs::SetModelState move;
+    move.request.model_state.model_name = rover_name.toStdString();
+    move.request.model_state.pose.position.x = x;
+    move.request.model_state.pose.position.y = y;
+    move.request.model_state.pose.position.z = z;
+    move.request.model_state.pose.orientation.w = 1;
+    move.request.model_state.reference_frame = "world";
+
+    if (!callService("/gazebo/set_model_state", move))
+    {
+        return "<br><font color='red'>Could not move " + rover_name + ": the gazebo set model state service is not available</font><br>";
+    }
 
-            return return_msg;
+    return "<br><font color='yellow'>" + QString::fromStdString(move.response.status_message) + "</font><br>";
 }
 
 QString GazeboSimManager::applyForceToRover(QString rover_name, float x, float y, float z, float duration)
 {
-            QString x_str = QString::number(x,'f',1);
-            QString y_str = QString::number(y,'f',1);
-            QString z_str = QString::number(z,'f',1);
-           // QString duration_str = QString::number(duration,'f',1);
-
-            QString argument = "rosservice call /gazebo/apply_body_wrench '{ body_name: \"beta::base_link\", reference_frame: \"beta::base_link\", wrench: { force: { x: 1000, y: 0, z: 0 } }, start_time: 0, duration: 2 }'";
+    gazebo_msgs::ApplyBodyWrench push;
+    push.request.body_name = rover_name.toStdString() + "::base_link";
+    push.request.reference_frame = push.request.body_name;
+    push.request.wrench.force.x = x;
+    push.request.wrench.force.y = y;
+    push.request.wrench.force.z = z;
+    push.request.start_time = ros::Time(0);
+    push.request.duration = ros::Duration(duration);
+
+    if (!callService("/gazebo/apply_body_wrench", push))
+    {
+        return "<br><font color='red'>Could not push " + rover_name + ": the gazebo apply body wrench service is not available</font><br>";
+    }
 
-            QProcess sh;
-            sh.start("sh", QStringList() << "-c" << argument);
+    return "<br><font color='yellow'>" + QString::fromStdString(push.response.status_message) + "</font><br>";
+}
 
-            sh.waitForFinished();
-            QByteArray output = sh.readAll();
-            sh.close();
+QFuture<QString> GazeboSimManager::removeModelAsync(QString model_name)
+{
+    return QtConcurrent::run(this, &GazeboSimManager::removeModel, model_name);
+}
 
-            QString return_msg = "<br><font color='yellow'>" + output + "</font><br>";
+QFuture<QString> GazeboSimManager::moveRoverAsync(QString rover_name, float x, float y, float z)
+{
+    return QtConcurrent::run(this, &GazeboSimManager::moveRover, rover_name, x, y, z);
+}
 
-            return return_msg;
+QFuture<QString> GazeboSimManager::applyForceToRoverAsync(QString rover_name, float x, float y, float z, float duration)
+{
+    return QtConcurrent::run(this, &GazeboSimManager::applyForceToRover, rover_name, x, y, z, duration);
 }
 
-// Takes the center x and center y positions of an object along with its clearance and checks if any objects are within that area
-bool GazeboSimManager::isLocationOccupied(float x, float y, float clearance)
+// Calls the service over a persistent connection. Each call takes an idle connection to the service,
+// or opens one if they are all in use, so calls from several threads run side by side rather than
+// queueing behind one connection. The mutex is only held to take and return connections.
+// A failed call usually means gazebo restarted, so the idle connections are dropped with the one
+// that failed and the call is tried once more on a new connection.
+template <class Service>
+bool GazeboSimManager::callService(const string& service_name, Service& service)
 {
-    set<tuple<float, float, float>>::iterator it;
-    for (it = model_locations.begin(); it != model_locations.end(); it++)
+    ros::NodeHandle nh;
+
+    for (int attempt = 0; attempt < 2; attempt++)
     {
-        float used_x = get<0>(*it);
-        float used_y = get<1>(*it);
-        float used_clearance = get<2>(*it);
+        ros::ServiceClient client;
+        {
+            QMutexLocker locker(&service_mutex);
+            vector<ros::ServiceClient>& idle = idle_clients[service_name];
+            if (!idle.empty())
+            {
+                client = idle.back();
+                idle.pop_back();
+            }
+        }
+
+        if (!client.isValid())
+        {
+            // Gazebo may still be starting up when the simulation is being built
+            if (!ros::service::waitForService(service_name, ros::Duration(30))) return false;
+            client = nh.serviceClient<Service>(service_name, true);
+        }
 
-        // Distance between circle centers
-        float d = sqrt(pow(x-used_x,2)+pow(y-used_y,2));
-        if (d < clearance+used_clearance)
+        if (client.call(service))
         {
+            QMutexLocker locker(&service_mutex);
+            idle_clients[service_name].push_back(client);
             return true;
         }
+
+        client.shutdown();
+
+        QMutexLocker locker(&service_mutex);
+        idle_clients[service_name].clear();
     }
 
     return false;
 }
 
+// Asks the node to shut down through its XML-RPC API, the same way rosnode kill does
+bool GazeboSimManager::shutdownNode(const string& node_name)
+{
+    XmlRpc::XmlRpcValue args, result, payload;
+    args[0] = ros::this_node::getName();
+    args[1] = node_name;
+
+    if (!ros::master::execute("lookupNode", args, result, payload, false)) return false;
+
+    string uri = payload;
+    string host;
+    uint32_t port;
+    if (!ros::network::splitURI(uri, host, port)) return false;
+
+    XmlRpc::XmlRpcClient node(host.c_str(), port, "/");
+    XmlRpc::XmlRpcValue shutdown_args, shutdown_result;
+    shutdown_args[0] = ros::this_node::getName();
+    shutdown_args[1] = "stopped by the rover GUI";
+
+    return node.execute("shutdown", shutdown_args, shutdown_result) && !node.isFault();
+}
+
+// Takes the center x and center y positions of an object along with its clearance and checks if any objects are within that area
+bool GazeboSimManager::isLocationOccupied(float x, float y, float clearance)
+{
+    return model_locations.overlaps(x, y, clearance);
+}
+
 bool GazeboSimManager::isGazeboServerRunning()
 {
     return gazebo_server_process != NULL;
@@ -375,6 +609,7 @@ void GazeboSimManager::setCustomWorldPath(QString path)
 
 GazeboSimManager::~GazeboSimManager()
 {
+    spawn_future.waitForFinished();
     stopGazeboServer();
     stopGazeboClient();
     if (gazebo_server_process) gazebo_server_process->close();
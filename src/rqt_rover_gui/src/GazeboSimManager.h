@@ -1,16 +1,11 @@
 /*!
- * \brief   This class is intended as an interface to the Gazebo Simulation. This is acheived
- *          by calling shell commands. A single gazebo process is created that lasts the life of the
- *          program. Other opererations on the simulation are performed by creating a shell process that only
- *          exists as long as the command takes to complete.
+ * \brief   This class is intended as an interface to the Gazebo Simulation. A single gazebo process
+ *          is created that lasts the life of the program. Models are added, removed and moved through
+ *          persistent connections to the gazebo_ros services, and rover nodes are started with roslaunch
+ *          and shut down through their XML-RPC API.
  * \author  Matthew Fricke
  * \date    November 11th 2015
- * \todo    A better solution would be to write a gazebo plugin that would pass on gazebo commands.
- *          Using a plugin would reduce the need to manage the shell processes spawned to manipulate models
- *          in the simulation.
- *          addModel can add any model including rovers and ground planes. The addRover and addGroundPlane
- *          functions should just call addModel to avoid duplication of code.
- *          stopGazebo is buggy. It needs to be rewritten so gazebo is closed and the rover nodes shutdown
+ * \todo    stopGazebo is buggy. It needs to be rewritten so gazebo is closed and the rover nodes shutdown
  *          without closing the GUI nodes.
  * \class   GazeboSimManager
  */
@@ -18,15 +13,30 @@
 #ifndef GazeboSimManager_H
 #define GazeboSimManager_H
 
+#include <QFuture>
+#include <QList>
+#include <QMutex>
 #include <QProcess>
 #include <QString>
+#include <atomic>
 #include <map>
-#include <set>
 #include <string>
-#include <tuple>
+#include <vector>
+#include <ros/service_client.h>
+
+#include "ModelLocations.h"
 
 using namespace std;
 
+// A model waiting in the spawn queue, see GazeboSimManager::queueModel
+struct QueuedModel
+{
+    QString model_name;
+    QString unique_id;
+    float x, y, z;
+    float roll, pitch, yaw;
+};
+
 class GazeboSimManager
 {
 public:
@@ -39,6 +49,12 @@ public:
     QString removeRover(QString rover_name);
     QString startRoverNode(QString rover_name);
     QString stopRoverNode(QString rover_name);
+    // Shuts down the ROS nodes of each rover in parallel on the global thread pool. The future has one
+    // log message per rover and its progress counts the rovers that are done. The launch processes are
+    // left to stopRoverProcesses since they belong to the calling thread.
+    QFuture<QString> stopRoverNodes(QList<QString> rover_names);
+    // Terminates the launch processes of all the rovers together and then waits for them to exit
+    QString stopRoverProcesses();
     QProcess* startGazeboServer();
     QProcess* startGazeboServer( QString path );
     QProcess* startGazeboClient();
@@ -47,8 +63,26 @@ public:
     QString removeModel( QString model_name );
     QString addModel(QString model_name, QString unique_id, float x, float y, float z, float clearance);
     QString addModel(QString model_name, QString unique_id, float x, float y, float z, float R, float P, float Y, float clearance);
+
+    // Reserves the location of a model like addModel but defers spawning it until spawnQueuedModels is called
+    void queueModel(QString model_name, QString unique_id, float x, float y, float z, float clearance);
+    void queueModel(QString model_name, QString unique_id, float x, float y, float z, float R, float P, float Y, float clearance);
+    void queueRover(QString rover_name, float x, float y, float z);
+    void queueGroundPlane(QString ground_name);
+    // Spawns every queued model on a worker thread through one persistent connection to the
+    // gazebo spawn service. The future holds the log message once all the models are in the simulation.
+    QFuture<QString> spawnQueuedModels();
+    // Fraction of the models handed to the last spawnQueuedModels call that have been spawned so far
+    float getSpawnProgress();
+
     QString moveRover(QString rover_name, float x, float y, float z);
     QString applyForceToRover(QString rover_name, float x, float y, float z, float duration);
+
+    // The same calls made on a worker thread, for callers that should not wait on gazebo. Calls made
+    // at the same time run side by side, each over a connection of its own.
+    QFuture<QString> removeModelAsync(QString model_name);
+    QFuture<QString> moveRoverAsync(QString rover_name, float x, float y, float z);
+    QFuture<QString> applyForceToRoverAsync(QString rover_name, float x, float y, float z, float duration);
     bool isLocationOccupied(float x, float y, float clearence);
     bool isGazeboServerRunning();
     bool isGazeboClientRunning();
@@ -59,15 +93,32 @@ public:
 private:
     QString app_root; // Path to the application root directory
     QProcess* gazebo_server_process;
+    qint64 gazebo_server_pid; // The detached server process, 0 if not known
     QProcess* gazebo_client_process;
     QProcess* command_process;
     map<QString, QProcess*> rover_processes;
 
     // Contains the positions of objects in the simulation and clearance value (the xy plane radius of the object)
-    // center x, center y, clearance
-    set< tuple<float, float, float> > model_locations;
+    ModelLocations model_locations;
 
     QString custom_world_path;
+
+    vector<QueuedModel> queued_models;
+    QFuture<QString> spawn_future;
+    atomic<int> models_spawned;
+    int models_to_spawn;
+
+    // Persistent connections to the gazebo_ros services that no call is using, by service name, and the
+    // model files. Both are guarded by service_mutex, which is never held during a call.
+    QMutex service_mutex;
+    map<string, vector<ros::ServiceClient> > idle_clients;
+    map<QString, string> model_sdf; // Model file contents by model name
+
+    QString spawnModels(vector<QueuedModel> models);
+    bool spawnModel(const QueuedModel& model, QString& output);
+    template <class Service> bool callService(const string& service_name, Service& service);
+    bool shutdownNode(const string& node_name);
+    QString shutdownRoverNodes(QString rover_name);
 };
 
 #endif // GazeboSimManager_H
@@ -6,13 +6,15 @@
 #include <cmath>
 
 #include <IMUFrame.h>
+#include "GUIProfiler.h"
+#include "RepaintScheduler.h"
 
 namespace rqt_rover_gui
 {
 
 IMUFrame::IMUFrame(QWidget *parent, Qt::WFlags flags) : QFrame(parent)
 {
-    connect(this, SIGNAL(delayedUpdate()), this, SLOT(update()), Qt::QueuedConnection);
+    RepaintScheduler::instance().add(this);
 
         linear_acceleration = make_tuple(0,0,0); // ROS Geometry Messages Vector3: <x, y, z> -- Initialize to all 0s
         angular_velocity = make_tuple(0,0,0); // ROS Geometry Messages Vector3: <x, y, z>    -- Initialize to all 0s
@@ -92,11 +94,12 @@ void IMUFrame::rotateTimerEventHandler()
         cube[i] = rotateAboutAxis(cube[i], M_PI/10, axis_of_rotation);
 
 
-    emit delayedUpdate();
+    RepaintScheduler::instance().markDirty(this);
 }
 
 void IMUFrame::paintEvent(QPaintEvent* event)
 {
+    ScopedTimer timer("IMUFrame::paintEvent");
 
     QPainter painter(this);
     painter.setPen(Qt::white);
@@ -337,13 +340,13 @@ painter.drawLine( QPoint(projected_accel_end_head_x_right.x()+center_x, projecte
 void IMUFrame::setLinearAcceleration(float x, float y, float z)
 {
     linear_acceleration = make_tuple(x, y, z);
-    emit delayedUpdate();
+    RepaintScheduler::instance().markDirty(this);
 }
 
 void IMUFrame::setAngularVelocity(float x, float y, float z)
 {
     angular_velocity = make_tuple(x, y, z);
-    emit delayedUpdate();
+    RepaintScheduler::instance().markDirty(this);
 }
 
 void IMUFrame::setOrientation(float w, float x, float y, float z)
@@ -371,7 +374,7 @@ void IMUFrame::setOrientation(float w, float x, float y, float z)
     rotated_line2_end = inverseRotateByQuaternion(line2_end, quaternion);
 
 
-    emit delayedUpdate();
+    RepaintScheduler::instance().markDirty(this);
 }
 
 QPoint IMUFrame::cameraTransform( tuple<float, float, float> point_3D, tuple<float, float, float> eye, tuple<float, float, float> camera_position, tuple<float, float, float> camera_angle )
@@ -513,5 +516,10 @@ float** IMUFrame::setUpRotationMatrix(float angle, tuple<float, float, float> ax
         return rotateByQuaternion(v,  make_tuple(get<0>(quaternion), -get<1>(quaternion), -get<2>(quaternion), -get<3>(quaternion)));
     }
 
+IMUFrame::~IMUFrame()
+{
+    RepaintScheduler::instance().remove(this);
+}
+
 }
 #endif
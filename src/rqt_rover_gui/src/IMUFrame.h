@@ -34,14 +34,11 @@ class IMUFrame : public QFrame
     Q_OBJECT
 public:
     IMUFrame(QWidget *parent, Qt::WFlags = 0);
+    ~IMUFrame();
     void setLinearAcceleration(float x, float y, float z);
     void setAngularVelocity(float x, float y, float z);
     void setOrientation(float w, float x, float y, float z);
 
-signals:
-
-    void delayedUpdate();
-
 public slots:
     void rotateTimerEventHandler();
 
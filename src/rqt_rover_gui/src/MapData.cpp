@@ -1,80 +1,177 @@
 #include "MapData.h"
+#include <algorithm>
+#include <QString>
 
 using namespace std;
 
-MapData::MapData( )
+MapData::MapData(size_t path_point_budget) : path_point_budget(path_point_budget), replay_log(NULL), replay_position(0)
 {
 
 }
 
-void MapData::addToGPSRoverPath(string rover, float x, float y)
+void MapData::setPathPointBudget(size_t path_point_budget)
 {
-  // Negate the y direction to orient the map so up is north.
-  y = -y;
+    update_mutex.lock();
 
-    if (x > max_gps_seen_x[rover]) max_gps_seen_x[rover] = x;
-    if (y > max_gps_seen_y[rover]) max_gps_seen_y[rover] = y;
-    if (x < min_gps_seen_x[rover]) min_gps_seen_x[rover] = x;
-    if (y < min_gps_seen_y[rover]) min_gps_seen_y[rover] = y;
+    this->path_point_budget = path_point_budget;
+
+    for (size_t i = 0; i < rover_maps.size(); i++)
+    {
+        rover_maps[i].gps.setPointBudget(path_point_budget);
+        rover_maps[i].ekf.setPointBudget(path_point_budget);
+        rover_maps[i].encoder.setPointBudget(path_point_budget);
+    }
+
+    update_mutex.unlock();
+}
+
+int MapData::registerRover(const string& rover_name)
+{
+    map<string, int>::iterator it = rover_ids.find(rover_name);
+    if (it != rover_ids.end()) return it->second;
 
     update_mutex.lock();
-    gps_rover_path[rover].push_back(pair<float,float>(x,y));
+
+    int rover_id = rover_names.size();
+    rover_ids[rover_name] = rover_id;
+    rover_names.push_back(rover_name);
+    rover_maps.push_back(RoverMap(path_point_budget));
+    run_log.addRoverName(rover_id, rover_name);
+    resizeReceivedPoints();
+
     update_mutex.unlock();
 
+    return rover_id;
 }
 
-void MapData::addToEncoderRoverPath(string rover, float x, float y)
+void MapData::resizeReceivedPoints()
+{
+    // The callbacks index received_points so it only changes size while they are kept out
+    received_mutex.lock();
+    received_points.resize(rover_names.size());
+    received_mutex.unlock();
+    flushing_points.resize(rover_names.size());
+}
+
+int MapData::getRoverID(const string& rover_name) const
+{
+    map<string, int>::const_iterator it = rover_ids.find(rover_name);
+    return it == rover_ids.end() ? -1 : it->second;
+}
+
+const string& MapData::getRoverName(int rover_id) const
+{
+    return rover_names[rover_id];
+}
+
+int MapData::getRoverCount() const
+{
+    return rover_names.size();
+}
+
+void MapData::addToGPSRoverPath(int rover_id, float x, float y)
 {
   // Negate the y direction to orient the map so up is north.
   y = -y;
 
-    if (x > max_encoder_seen_x[rover]) max_encoder_seen_x[rover] = x;
-    if (y > max_encoder_seen_y[rover]) max_encoder_seen_y[rover] = y;
-    if (x < min_encoder_seen_x[rover]) min_encoder_seen_x[rover] = x;
-    if (y < min_encoder_seen_y[rover]) min_encoder_seen_y[rover] = y;
+    ReceivedPoint point = {x, y, RunLogWriter::now()};
 
-    update_mutex.lock();
-    encoder_rover_path[rover].push_back(pair<float,float>(x,y));
-    update_mutex.unlock();
+    received_mutex.lock();
+    received_points[rover_id].gps.push_back(point);
+    received_mutex.unlock();
+}
 
+void MapData::addToEncoderRoverPath(int rover_id, float x, float y)
+{
+  // Negate the y direction to orient the map so up is north.
+  y = -y;
+
+    ReceivedPoint point = {x, y, RunLogWriter::now()};
+
+    received_mutex.lock();
+    received_points[rover_id].encoder.push_back(point);
+    received_mutex.unlock();
 }
 
 
-void MapData::addToEKFRoverPath(string rover, float x, float y)
+void MapData::addToEKFRoverPath(int rover_id, float x, float y)
 {
   // Negate the y direction to orient the map so up is north.
   y = -y;
 
-    if (x > max_ekf_seen_x[rover]) max_ekf_seen_x[rover] = x;
-    if (y > max_ekf_seen_y[rover]) max_ekf_seen_y[rover] = y;
-    if (x < min_ekf_seen_x[rover]) min_ekf_seen_x[rover] = x;
-    if (y < min_ekf_seen_y[rover]) min_ekf_seen_y[rover] = y;
+    ReceivedPoint point = {x, y, RunLogWriter::now()};
 
-    update_mutex.lock();
-    ekf_rover_path[rover].push_back(pair<float,float>(x,y));
-    update_mutex.unlock();
+    received_mutex.lock();
+    received_points[rover_id].ekf.push_back(point);
+    received_mutex.unlock();
+}
 
+void MapData::flushReceivedPoints()
+{
+    received_mutex.lock();
+    received_points.swap(flushing_points);
+    received_mutex.unlock();
+
+    for (size_t rover_id = 0; rover_id < flushing_points.size(); rover_id++)
+    {
+        ReceivedPoints& received = flushing_points[rover_id];
+        RoverMap& rover = rover_maps[rover_id];
+
+        for (size_t i = 0; i < received.gps.size(); i++)
+        {
+            const ReceivedPoint& point = received.gps[i];
+            rover.gps.add(point.x, point.y);
+            rover.gps_bounds.include(point.x, point.y);
+            run_log.add(RUN_LOG_GPS_POINT, rover_id, point.x, point.y, point.time);
+        }
+
+        for (size_t i = 0; i < received.ekf.size(); i++)
+        {
+            const ReceivedPoint& point = received.ekf[i];
+            rover.ekf.add(point.x, point.y);
+            rover.ekf_bounds.include(point.x, point.y);
+            run_log.add(RUN_LOG_EKF_POINT, rover_id, point.x, point.y, point.time);
+        }
+
+        for (size_t i = 0; i < received.encoder.size(); i++)
+        {
+            const ReceivedPoint& point = received.encoder[i];
+            rover.encoder.add(point.x, point.y);
+            rover.encoder_bounds.include(point.x, point.y);
+            run_log.add(RUN_LOG_ENCODER_POINT, rover_id, point.x, point.y, point.time);
+        }
+
+        // Keep the storage for the next time these are swapped in
+        received.gps.clear();
+        received.ekf.clear();
+        received.encoder.clear();
+    }
+
+    // The batch of points is written to the log together
+    run_log.flush();
 }
 
-void MapData::addTargetLocation(string rover, float x, float y)
+void MapData::addTargetLocation(int rover_id, float x, float y)
 {
   //The QT drawing coordinate system is reversed from the robot coordinate system in the y direction
     y = -y;
 
     update_mutex.lock();
-    target_locations[rover].push_back(pair<float,float>(x,y));
+    rover_maps[rover_id].target_locations.push_back(pair<float,float>(x,y));
+    run_log.add(RUN_LOG_TARGET_LOCATION, rover_id, x, y);
     update_mutex.unlock();
 
 }
 
 
-void MapData::addCollectionPoint(string rover, float x, float y)
+void MapData::addCollectionPoint(int rover_id, float x, float y)
 {
     // The QT drawing coordinate system is reversed from the robot coordinate system in the y direction
     y = -y;
 
     update_mutex.lock();
-    collection_points[rover].push_back(pair<float,float>(x,y));
+    rover_maps[rover_id].collection_points.push_back(pair<float,float>(x,y));
+    run_log.add(RUN_LOG_COLLECTION_POINT, rover_id, x, y);
     update_mutex.unlock();
 
 }
@@ -84,118 +181,297 @@ void MapData::clear()
 {
     update_mutex.lock();
 
-    ekf_rover_path.clear();
-    encoder_rover_path.clear();
-    gps_rover_path.clear();
-    target_locations.clear();
-    collection_points.clear();
+    // Rovers keep their IDs, only what is on the map is removed
+    received_mutex.lock();
+    for (size_t i = 0; i < received_points.size(); i++)
+    {
+        received_points[i] = ReceivedPoints();
+    }
+    received_mutex.unlock();
+
+    for (size_t i = 0; i < rover_maps.size(); i++)
+    {
+        flushing_points[i] = ReceivedPoints();
+        rover_maps[i] = RoverMap(path_point_budget);
+    }
+
+    run_log.add(RUN_LOG_CLEAR_ALL, 0);
 
     update_mutex.unlock();
 }
 
-void MapData::clear(string rover)
+void MapData::clear(int rover_id)
 {
     update_mutex.lock();
 
-    ekf_rover_path[rover].clear();
-    encoder_rover_path[rover].clear();
-    gps_rover_path[rover].clear();
-    target_locations[rover].clear();
-    collection_points[rover].clear();
+    received_mutex.lock();
+    received_points[rover_id] = ReceivedPoints();
+    received_mutex.unlock();
+
+    flushing_points[rover_id] = ReceivedPoints();
+    rover_maps[rover_id] = RoverMap(path_point_budget);
 
-    ekf_rover_path.erase(rover);
-    encoder_rover_path.erase(rover);
-    gps_rover_path.erase(rover);
-    target_locations.erase(rover);
-    collection_points.erase(rover);
+    run_log.add(RUN_LOG_CLEAR_ROVER, rover_id);
 
     update_mutex.unlock();
 }
 
-std::vector< std::pair<float,float> >* MapData::getEKFPath(std::string rover_name)
+bool MapData::startRunLog(const string& path)
+{
+    update_mutex.lock();
+
+    bool opened = run_log.open(QString::fromStdString(path));
+    for (size_t i = 0; opened && i < rover_names.size(); i++)
+    {
+        run_log.addRoverName(i, rover_names[i]);
+    }
+    run_log.flush();
+
+    update_mutex.unlock();
+
+    return opened;
+}
+
+void MapData::stopRunLog()
+{
+    update_mutex.lock();
+    run_log.close();
+    update_mutex.unlock();
+}
+
+bool MapData::openReplay(const string& path)
+{
+    RunLogReader* log = new RunLogReader();
+    if (!log->open(QString::fromStdString(path)))
+    {
+        delete log;
+        return false;
+    }
+
+    update_mutex.lock();
+
+    delete replay_log;
+    replay_log = log;
+    replay_position = 0;
+
+    rover_names.clear();
+    rover_maps.clear();
+    rover_ids.clear();
+    resizeReceivedPoints();
+
+    // The first checkpoint is the empty map at the start of the run
+    replay_checkpoints.assign(1, ReplayCheckpoint());
+
+    update_mutex.unlock();
+
+    return true;
+}
+
+float MapData::getReplayDuration() const
+{
+    return replay_log ? replay_log->getDuration() : 0;
+}
+
+void MapData::seekReplay(float time)
+{
+    if (!replay_log) return;
+
+    update_mutex.lock();
+
+    size_t target = replay_log->find(time);
+
+    // Start from the last checkpoint before the target when going back, or when it skips records going forwards
+    size_t checkpoint = min(target / replay_checkpoint_interval, replay_checkpoints.size()-1);
+    if (target < replay_position || checkpoint * replay_checkpoint_interval > replay_position)
+    {
+        rover_names = replay_checkpoints[checkpoint].rover_names;
+        rover_maps = replay_checkpoints[checkpoint].rover_maps;
+
+        rover_ids.clear();
+        for (size_t i = 0; i < rover_names.size(); i++)
+        {
+            rover_ids[rover_names[i]] = i;
+        }
+        resizeReceivedPoints();
+
+        replay_position = checkpoint * replay_checkpoint_interval;
+    }
+
+    for (; replay_position < target; replay_position++)
+    {
+        if (replay_position == replay_checkpoints.size() * replay_checkpoint_interval)
+        {
+            replay_checkpoints.push_back(ReplayCheckpoint());
+            replay_checkpoints.back().rover_names = rover_names;
+            replay_checkpoints.back().rover_maps = rover_maps;
+        }
+
+        applyRecord((*replay_log)[replay_position]);
+    }
+
+    update_mutex.unlock();
+}
+
+void MapData::applyRecord(const RunLogRecord& record)
+{
+    int rover_id = record.rover_id;
+
+    if (record.kind == RUN_LOG_ROVER_NAME)
+    {
+        // The first record of a name registers the rover, later ones add to the name
+        if (rover_id == (int)rover_names.size())
+        {
+            rover_names.push_back(string());
+            rover_maps.push_back(RoverMap(path_point_budget));
+            resizeReceivedPoints();
+        }
+        if (rover_id >= (int)rover_names.size()) return;
+
+        rover_ids.erase(rover_names[rover_id]);
+        rover_names[rover_id].append((const char*)&record.x, min<size_t>(record.name_length, sizeof(record.x) + sizeof(record.y)));
+        rover_ids[rover_names[rover_id]] = rover_id;
+        return;
+    }
+
+    if (record.kind == RUN_LOG_CLEAR_ALL)
+    {
+        for (size_t i = 0; i < rover_maps.size(); i++)
+        {
+            rover_maps[i] = RoverMap(path_point_budget);
+        }
+        return;
+    }
+
+    // Ignore records for rovers the log never registered
+    if (rover_id >= (int)rover_maps.size()) return;
+
+    RoverMap& rover = rover_maps[rover_id];
+
+    switch (record.kind)
+    {
+    case RUN_LOG_GPS_POINT:
+        rover.gps.add(record.x, record.y);
+        rover.gps_bounds.include(record.x, record.y);
+        break;
+    case RUN_LOG_EKF_POINT:
+        rover.ekf.add(record.x, record.y);
+        rover.ekf_bounds.include(record.x, record.y);
+        break;
+    case RUN_LOG_ENCODER_POINT:
+        rover.encoder.add(record.x, record.y);
+        rover.encoder_bounds.include(record.x, record.y);
+        break;
+    case RUN_LOG_TARGET_LOCATION:
+        rover.target_locations.push_back(pair<float,float>(record.x, record.y));
+        break;
+    case RUN_LOG_COLLECTION_POINT:
+        rover.collection_points.push_back(pair<float,float>(record.x, record.y));
+        break;
+    case RUN_LOG_CLEAR_ROVER:
+        rover = RoverMap(path_point_budget);
+        break;
+    }
+}
+
+const std::vector< std::pair<float,float> >* MapData::getEKFPath(int rover_id) const
+{
+    return rover_maps[rover_id].ekf.getPoints();
+}
+
+const std::vector< std::pair<float,float> >* MapData::getGPSPath(int rover_id) const
+{
+    return rover_maps[rover_id].gps.getPoints();
+}
+
+const std::vector< std::pair<float,float> >* MapData::getEncoderPath(int rover_id) const
+{
+    return rover_maps[rover_id].encoder.getPoints();
+}
+
+unsigned long MapData::getEKFPathRevision(int rover_id) const
 {
-    return &ekf_rover_path[rover_name];
+    return rover_maps[rover_id].ekf.getRevision();
 }
 
-std::vector< std::pair<float,float> >* MapData::getGPSPath(std::string rover_name)
+unsigned long MapData::getGPSPathRevision(int rover_id) const
 {
-    return &gps_rover_path[rover_name];
+    return rover_maps[rover_id].gps.getRevision();
 }
 
-std::vector< std::pair<float,float> >* MapData::getEncoderPath(std::string rover_name)
+unsigned long MapData::getEncoderPathRevision(int rover_id) const
 {
-    return &encoder_rover_path[rover_name];
+    return rover_maps[rover_id].encoder.getRevision();
 }
 
-std::vector< std::pair<float,float> >* MapData::getTargetLocations(std::string rover_name)
+const std::vector< std::pair<float,float> >* MapData::getTargetLocations(int rover_id) const
 {
-    return &target_locations[rover_name];
+    return &rover_maps[rover_id].target_locations;
 }
 
-std::vector< std::pair<float,float> >* MapData::getCollectionPoints(std::string rover_name)
+const std::vector< std::pair<float,float> >* MapData::getCollectionPoints(int rover_id) const
 {
-    return &collection_points[rover_name];
+    return &rover_maps[rover_id].collection_points;
 }
 
 // These functions report the maximum and minimum map values seen. This is useful for the GUI when it is calculating the map coordinate system.
-float MapData::getMaxGPSX(string rover_name)
+float MapData::getMaxGPSX(int rover_id) const
 {
-    return max_gps_seen_x[rover_name];
+    return rover_maps[rover_id].gps_bounds.max_x;
 }
 
-float MapData::getMaxGPSY(string rover_name)
+float MapData::getMaxGPSY(int rover_id) const
 {
-    return max_gps_seen_y[rover_name];
+    return rover_maps[rover_id].gps_bounds.max_y;
 }
 
-float MapData::getMinGPSX(string rover_name)
+float MapData::getMinGPSX(int rover_id) const
 {
-    return min_gps_seen_x[rover_name];
+    return rover_maps[rover_id].gps_bounds.min_x;
 }
 
-float MapData::getMinGPSY(string rover_name)
+float MapData::getMinGPSY(int rover_id) const
 {
-    return min_gps_seen_y[rover_name];
+    return rover_maps[rover_id].gps_bounds.min_y;
 }
 
-float MapData::getMaxEKFX(string rover_name)
+float MapData::getMaxEKFX(int rover_id) const
 {
-    return max_ekf_seen_x[rover_name];
+    return rover_maps[rover_id].ekf_bounds.max_x;
 }
 
-float MapData::getMaxEKFY(string rover_name)
+float MapData::getMaxEKFY(int rover_id) const
 {
-    return max_ekf_seen_y[rover_name];
+    return rover_maps[rover_id].ekf_bounds.max_y;
 }
 
-float MapData::getMinEKFX(string rover_name)
+float MapData::getMinEKFX(int rover_id) const
 {
-    return min_ekf_seen_x[rover_name];
+    return rover_maps[rover_id].ekf_bounds.min_x;
 }
 
-float MapData::getMinEKFY(string rover_name)
+float MapData::getMinEKFY(int rover_id) const
 {
-    return min_ekf_seen_y[rover_name];
+    return rover_maps[rover_id].ekf_bounds.min_y;
 }
 
-float MapData::getMaxEncoderX(string rover_name)
+float MapData::getMaxEncoderX(int rover_id) const
 {
-    return max_encoder_seen_x[rover_name];
+    return rover_maps[rover_id].encoder_bounds.max_x;
 }
 
-float MapData::getMaxEncoderY(string rover_name)
+float MapData::getMaxEncoderY(int rover_id) const
 {
-    return max_encoder_seen_y[rover_name];
+    return rover_maps[rover_id].encoder_bounds.max_y;
 }
 
-float MapData::getMinEncoderX(string rover_name)
+float MapData::getMinEncoderX(int rover_id) const
 {
-    return min_encoder_seen_x[rover_name];
+    return rover_maps[rover_id].encoder_bounds.min_x;
 }
 
-float MapData::getMinEncoderY(string rover_name)
+float MapData::getMinEncoderY(int rover_id) const
 {
-    return min_encoder_seen_y[rover_name];
+    return rover_maps[rover_id].encoder_bounds.min_y;
 }
 
 void MapData::lock()
@@ -211,5 +487,8 @@ void MapData::unlock()
 
 MapData::~MapData()
 {
+    // The log ends with the map as it was rather than cleared
+    stopRunLog();
     clear();
+    delete replay_log;
 }
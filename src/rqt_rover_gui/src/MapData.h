@@ -9,6 +9,8 @@
 #include <QMutex>
 
 #include "MapData.h"
+#include "RoverPath.h"
+#include "RunLog.h"
 
 // This class is the "model" for std::map frame in the model-view UI pattern,
 // where std::mapFrame is the view.
@@ -16,68 +18,182 @@
 class MapData
 {
 public:
-    MapData();
+    MapData(size_t path_point_budget = 4000);
 
-    void addToGPSRoverPath(std::string rover, float x, float y);
-    void addToEncoderRoverPath(std::string rover, float x, float y);
-    void addToEKFRoverPath(std::string rover, float x, float y);
-    void addTargetLocation(std::string rover, float x, float y);
-    void addCollectionPoint(std::string rover, float x, float y);
+    // The most points kept for each of a rover's paths. Longer paths are decimated so
+    // memory and the cost of drawing them do not grow with the length of the run.
+    void setPathPointBudget(size_t path_point_budget);
+
+    // Gives a rover a small ID when it connects, or returns the one it already has.
+    // Everything else takes the ID so the per-point paths index flat arrays instead
+    // of looking up rover names. IDs are never reused so a message that arrives
+    // after its rover disconnected cannot end up in another rover's map.
+    int registerRover(const std::string& rover_name);
+
+    // The ID of a registered rover, or -1 if it has not connected
+    int getRoverID(const std::string& rover_name) const;
+    const std::string& getRoverName(int rover_id) const;
+    int getRoverCount() const;
+
+    // Called from the ROS callbacks. The points are queued and only added to the
+    // paths by flushReceivedPoints, so a callback never waits for the map to be drawn.
+    void addToGPSRoverPath(int rover_id, float x, float y);
+    void addToEncoderRoverPath(int rover_id, float x, float y);
+    void addToEKFRoverPath(int rover_id, float x, float y);
+
+    // Adds the queued points to the paths and their bounds. Call from the GUI thread
+    // with the map data locked before reading the paths.
+    void flushReceivedPoints();
+
+    void addTargetLocation(int rover_id, float x, float y);
+    void addCollectionPoint(int rover_id, float x, float y);
 
     void clear();
-    void clear(std::string rover_name);
+    void clear(int rover_id);
+
+    // Writes everything added to the map from now on to a run log, see RunLog.h,
+    // including the rovers that are already registered. Returns false if the log
+    // could not be written.
+    bool startRunLog(const std::string& path);
+    void stopRunLog();
+
+    // Replaces the map with a run log to be replayed with seekReplay. Nothing else
+    // should be added to this map data. Returns false if the file is not a run log.
+    bool openReplay(const std::string& path);
+    float getReplayDuration() const;
+
+    // Shows the map as it was the given number of seconds into the logged run.
+    // Seeking forwards applies the records since the last seek, seeking backwards
+    // starts again from the last checkpoint, so neither replays the whole log.
+    void seekReplay(float time);
+
     void lock();
     void unlock();
 
-    std::vector< std::pair<float,float> >* getEKFPath(std::string rover_name);
-    std::vector< std::pair<float,float> >* getGPSPath(std::string rover_name);
-    std::vector< std::pair<float,float> >* getEncoderPath(std::string rover_name);
-    std::vector< std::pair<float,float> >* getTargetLocations(std::string rover_name);
-    std::vector< std::pair<float,float> >* getCollectionPoints(std::string rover_name);
+    const std::vector< std::pair<float,float> >* getEKFPath(int rover_id) const;
+    const std::vector< std::pair<float,float> >* getGPSPath(int rover_id) const;
+    const std::vector< std::pair<float,float> >* getEncoderPath(int rover_id) const;
+
+    // See RoverPath::getRevision, lets views append new points to what they have already drawn
+    unsigned long getEKFPathRevision(int rover_id) const;
+    unsigned long getGPSPathRevision(int rover_id) const;
+    unsigned long getEncoderPathRevision(int rover_id) const;
+    const std::vector< std::pair<float,float> >* getTargetLocations(int rover_id) const;
+    const std::vector< std::pair<float,float> >* getCollectionPoints(int rover_id) const;
 
     // These functions provide a fast way to get the min and max coords
-    float getMaxGPSX(std::string rover_name);
-    float getMaxGPSY(std::string rover_name);
-    float getMinGPSX(std::string rover_name);
-    float getMinGPSY(std::string rover_name);
+    float getMaxGPSX(int rover_id) const;
+    float getMaxGPSY(int rover_id) const;
+    float getMinGPSX(int rover_id) const;
+    float getMinGPSY(int rover_id) const;
 
-    float getMaxEKFX(std::string rover_name);
-    float getMaxEKFY(std::string rover_name);
-    float getMinEKFX(std::string rover_name);
-    float getMinEKFY(std::string rover_name);
+    float getMaxEKFX(int rover_id) const;
+    float getMaxEKFY(int rover_id) const;
+    float getMinEKFX(int rover_id) const;
+    float getMinEKFY(int rover_id) const;
 
-    float getMaxEncoderX(std::string rover_name);
-    float getMaxEncoderY(std::string rover_name);
-    float getMinEncoderX(std::string rover_name);
-    float getMinEncoderY(std::string rover_name);
+    float getMaxEncoderX(int rover_id) const;
+    float getMaxEncoderY(int rover_id) const;
+    float getMinEncoderX(int rover_id) const;
+    float getMinEncoderY(int rover_id) const;
 
     ~MapData();
 
 private:
 
-    std::map<std::string, std::vector< std::pair<float,float> > > gps_rover_path;
-    std::map<std::string, std::vector< std::pair<float,float> > >  ekf_rover_path;
-    std::map<std::string, std::vector< std::pair<float,float> > >  encoder_rover_path;
+    // The extent of a path. Starts at the origin, where the rover starts.
+    struct PathBounds
+    {
+        PathBounds() : min_x(0), max_x(0), min_y(0), max_y(0) {}
+
+        void include(float x, float y)
+        {
+            if (x > max_x) max_x = x;
+            if (y > max_y) max_y = y;
+            if (x < min_x) min_x = x;
+            if (y < min_y) min_y = y;
+        }
+
+        float min_x;
+        float max_x;
+        float min_y;
+        float max_y;
+    };
+
+    // Everything on the map for one rover
+    struct RoverMap
+    {
+        RoverMap(size_t path_point_budget) : gps(path_point_budget), ekf(path_point_budget), encoder(path_point_budget) {}
+
+        RoverPath gps;
+        RoverPath ekf;
+        RoverPath encoder;
+
+        PathBounds gps_bounds;
+        PathBounds ekf_bounds;
+        PathBounds encoder_bounds;
+
+        std::vector< std::pair<float,float> > target_locations;
+        std::vector< std::pair<float,float> > collection_points;
+    };
+
+    // The map as it was before a record of the replayed log
+    struct ReplayCheckpoint
+    {
+        std::vector<std::string> rover_names;
+        std::vector<RoverMap> rover_maps;
+    };
+
+    // A point from a ROS callback, stamped when it was received so the run log
+    // keeps its time rather than the time it was flushed
+    struct ReceivedPoint
+    {
+        float x;
+        float y;
+        qint64 time; // From RunLogWriter::now
+    };
+
+    // Points from the ROS callbacks that have not been added to the paths yet
+    struct ReceivedPoints
+    {
+        std::vector<ReceivedPoint> gps;
+        std::vector<ReceivedPoint> ekf;
+        std::vector<ReceivedPoint> encoder;
+    };
+
+    size_t path_point_budget;
+
+    // Indexed by rover ID
+    std::vector<std::string> rover_names;
+    std::vector<RoverMap> rover_maps;
+
+    std::map<std::string, int> rover_ids;
+
+    // The callbacks append to received_points. flushReceivedPoints swaps it with
+    // flushing_points, which keeps the vectors it has already allocated, so the
+    // callbacks only ever wait for the swap. Both are indexed by rover ID.
+    std::vector<ReceivedPoints> received_points;
+    std::vector<ReceivedPoints> flushing_points;
+    QMutex received_mutex;
 
-    std::map<std::string, std::vector< std::pair<float,float> > >  collection_points;
-    std::map<std::string, std::vector< std::pair<float,float> > >  target_locations;
+    QMutex update_mutex; // To prevent race conditions when the data is being displayed by MapFrame
 
-    std::map<std::string, float> max_gps_seen_x;
-    std::map<std::string, float> max_gps_seen_y;
-    std::map<std::string, float> min_gps_seen_x;
-    std::map<std::string, float> min_gps_seen_y;
+    // Sizes the received points to the rovers, call with update_mutex locked
+    void resizeReceivedPoints();
 
-    std::map<std::string, float> max_encoder_seen_x;
-    std::map<std::string, float> max_encoder_seen_y;
-    std::map<std::string, float> min_encoder_seen_x;
-    std::map<std::string, float> min_encoder_seen_y;
+    // Only written to with update_mutex locked
+    RunLogWriter run_log;
 
-    std::map<std::string, float> max_ekf_seen_x;
-    std::map<std::string, float> max_ekf_seen_y;
-    std::map<std::string, float> min_ekf_seen_x;
-    std::map<std::string, float> min_ekf_seen_y;
+    // Applies a record of the replayed log to the map
+    void applyRecord(const RunLogRecord& record);
 
-    QMutex update_mutex; // To prevent race conditions when the data is being displayed by MapFrame
+    // A checkpoint takes a copy of the map, a few hundred kB with the default budget,
+    // so this keeps them to a few dozen for a run of several hours
+    static const size_t replay_checkpoint_interval = 65536;
+
+    RunLogReader* replay_log;
+    size_t replay_position; // The records already applied to the map
+    std::vector<ReplayCheckpoint> replay_checkpoints; // Checkpoint i is taken before record i*replay_checkpoint_interval
 };
 
 #endif // MAPDATA_H
@@ -8,7 +8,11 @@
 #include <QGridLayout>
 #include <QLabel>
 #include <QMouseEvent>
+#include <QPen>
+#include <QTransform>
 #include <MapData.h>
+#include "GUIProfiler.h"
+#include "RepaintScheduler.h"
 #include "MapFrame.h"
 
 namespace rqt_rover_gui
@@ -16,7 +20,8 @@ namespace rqt_rover_gui
 
 MapFrame::MapFrame(QWidget *parent, Qt::WFlags flags) : QFrame(parent)
 {
-    connect(this, SIGNAL(delayedUpdate()), this, SLOT(update()), Qt::QueuedConnection);
+    // Repainted at a capped rate, see markDirty calls below
+    RepaintScheduler::instance().add(this);
 
     // Scale coordinates
     frame_width = this->width();
@@ -70,10 +75,11 @@ void MapFrame::createPopoutWindow( MapData * map_data )
     popout_window->setStyleSheet("background-color: rgb(0, 0, 0); border-color: rgb(255, 255, 255);");
     popout_window->setCentralWidget(central_widget);
 
-    connect(this, SIGNAL(delayedUpdate()), popout_mapframe, SLOT(update()), Qt::QueuedConnection);
 }
 
 void MapFrame::paintEvent(QPaintEvent* event) {
+    ScopedTimer timer("MapFrame::paintEvent");
+
     // Begin drawing the map
     QPainter painter(this);
     painter.setPen(Qt::white);
@@ -114,6 +120,9 @@ void MapFrame::paintEvent(QPaintEvent* event) {
 
     map_data->lock();
 
+    // Add the points received since the last frame
+    map_data->flushReceivedPoints();
+
     // Colorblind friendly colors
     QColor green(17, 192, 131);
     QColor red(255, 65, 30);
@@ -132,7 +141,7 @@ void MapFrame::paintEvent(QPaintEvent* event) {
     // Repeat the display code for each rover selected by the user - Using C++11 range syntax
     for(auto rover_to_display : display_list) {
 	    if (map_data->getEKFPath(rover_to_display)->empty() && map_data->getEncoderPath(rover_to_display)->empty() && map_data->getGPSPath(rover_to_display)->empty() && map_data->getTargetLocations(rover_to_display)->empty() && map_data->getCollectionPoints(rover_to_display)->empty()) {
-        painter.drawText(QPoint(50,50+no_data_offset), QString::fromStdString(rover_to_display) + ": No data.");
+        painter.drawText(QPoint(50,50+no_data_offset), QString::fromStdString(map_data->getRoverName(rover_to_display)) + ": No data.");
         no_data_offset += 10;
 	    }
 
@@ -289,95 +298,92 @@ void MapFrame::paintEvent(QPaintEvent* event) {
 
     // End draw scale bars
 
-    // Repeat the display code for each rover selected by the user - Using C++11 range syntax
+    // Bring the cached geometry of each rover up to date while the map data is locked
+    if (rover_cache.size() < (size_t)map_data->getRoverCount()) rover_cache.resize(map_data->getRoverCount());
     for(auto rover_to_display : display_list)
     {
-        // scale coordinates
+        RoverCache& cache = rover_cache[rover_to_display];
 
-        std::vector<QPoint> scaled_target_locations;
-        for(std::vector< pair<float,float> >::iterator it = map_data->getTargetLocations(rover_to_display)->begin(); it < map_data->getTargetLocations(rover_to_display)->end(); ++it) {
+        updatePathCache(cache.ekf, map_data->getEKFPath(rover_to_display), map_data->getEKFPathRevision(rover_to_display));
+        updatePathCache(cache.gps, map_data->getGPSPath(rover_to_display), map_data->getGPSPathRevision(rover_to_display));
+        updatePathCache(cache.encoder, map_data->getEncoderPath(rover_to_display), map_data->getEncoderPathRevision(rover_to_display));
+
+        cache.target_locations.clear();
+        for(std::vector< pair<float,float> >::const_iterator it = map_data->getTargetLocations(rover_to_display)->begin(); it < map_data->getTargetLocations(rover_to_display)->end(); ++it) {
             pair<float,float> coordinate  = *it;
             QPoint point;
             point.setX(map_origin_x+coordinate.first*map_width);
             point.setY(map_origin_y+coordinate.second*map_height);
-            scaled_target_locations.push_back(point);
+            cache.target_locations.push_back(point);
         }
 
-        std::vector<QPoint> scaled_collection_points;
-        for(std::vector< pair<float,float> >::iterator it = map_data->getCollectionPoints(rover_to_display)->begin(); it < map_data->getCollectionPoints(rover_to_display)->end(); ++it) {
+        cache.collection_points.clear();
+        for(std::vector< pair<float,float> >::const_iterator it = map_data->getCollectionPoints(rover_to_display)->begin(); it < map_data->getCollectionPoints(rover_to_display)->end(); ++it) {
             pair<float,float> coordinate  = *it;
             QPoint point;
             point.setX(map_origin_x+coordinate.first*map_width);
             point.setY(map_origin_y+coordinate.second*map_height);
-            scaled_collection_points.push_back(point);
+            cache.collection_points.push_back(point);
         }
+    }
 
-        std::vector<QPoint> scaled_gps_rover_points;
-        for(std::vector< pair<float,float> >::iterator it = map_data->getGPSPath(rover_to_display)->begin(); it < map_data->getGPSPath(rover_to_display)->end(); ++it) {
-            pair<float,float> coordinate  = *it;
-
-            float x = map_origin_x+((coordinate.first-min_seen_x)/max_seen_width)*(map_width-map_origin_x);
-            float y = map_origin_y+((coordinate.second-min_seen_y)/max_seen_height)*(map_height-map_origin_y);
-            scaled_gps_rover_points.push_back( QPoint(x,y) );
-        }
+    // Drawing does not need the map data so let the ROS callbacks add to it
+    map_data->unlock();
 
-        QPainterPath scaled_ekf_rover_path;
-        for(std::vector< pair<float,float> >::iterator it = map_data->getEKFPath(rover_to_display)->begin(); it < map_data->getEKFPath(rover_to_display)->end(); ++it) {
-            pair<float,float> coordinate  = *it;
-            QPoint point;
-            float x = map_origin_x+((coordinate.first-min_seen_x)/max_seen_width)*(map_width-map_origin_x);
-            float y = map_origin_y+((coordinate.second-min_seen_y)/max_seen_height)*(map_height-map_origin_y);
+    // Map coordinates to widget coordinates, there is no extent to scale to until the rover has moved
+    QTransform map_transform;
+    map_transform.translate(map_origin_x, map_origin_y);
+    if (max_seen_width > 0 && max_seen_height > 0) map_transform.scale((map_width-map_origin_x)/max_seen_width, (map_height-map_origin_y)/max_seen_height);
+    map_transform.translate(-min_seen_x, -min_seen_y);
 
-            // Move to the starting point of the path without drawing a line
-            if (it == map_data->getEKFPath(rover_to_display)->begin()) scaled_ekf_rover_path.moveTo(x, y);
-            scaled_ekf_rover_path.lineTo(x, y);
+    // Repeat the display code for each rover selected by the user - Using C++11 range syntax
+    for(auto rover_to_display : display_list)
+    {
+        RoverCache& cache = rover_cache[rover_to_display];
+
+        // The paths are drawn in map coordinates with pens that keep their width under the transform
+        painter.save();
+        painter.setTransform(map_transform);
+
+        QPen gps_pen(red);
+        gps_pen.setCosmetic(true);
+        painter.setPen(gps_pen);
+        if (display_gps_data && cache.gps.has_current) {
+            painter.drawPoints(cache.gps.points.data(), cache.gps.points.size());
+            painter.drawPoint(cache.gps.current);
         }
 
-        QPainterPath scaled_encoder_rover_path;
-        for(std::vector< pair<float,float> >::iterator it = map_data->getEncoderPath(rover_to_display)->begin(); it < map_data->getEncoderPath(rover_to_display)->end(); ++it) {
-         
-            pair<float,float> coordinate  = *it;
-            QPoint point;
-            float x = map_origin_x+((coordinate.first-min_seen_x)/max_seen_width)*(map_width-map_origin_x);
-            float y = map_origin_y+((coordinate.second-min_seen_y)/max_seen_height)*(map_height-map_origin_y);
-
-            // Move to the starting point of the path without drawing a line
-            if (it == map_data->getEncoderPath(rover_to_display)->begin()) scaled_encoder_rover_path.moveTo(x, y);
-
-            scaled_encoder_rover_path.lineTo(x, y);
+        QPen ekf_pen(Qt::white);
+        ekf_pen.setCosmetic(true);
+        painter.setPen(ekf_pen);
+        if (display_ekf_data && cache.ekf.committed > 0) {
+            painter.drawPath(cache.ekf.path);
+            painter.drawLine(cache.ekf.points.back(), cache.ekf.current);
         }
 
-        painter.setPen(red);
-        if (display_gps_data) painter.drawPoints(&scaled_gps_rover_points[0], scaled_gps_rover_points.size());
-        // if (display_gps_data) painter.drawPath(scaled_gps_rover_path);
+        QPen encoder_pen(green);
+        encoder_pen.setCosmetic(true);
+        painter.setPen(encoder_pen);
+        if (display_encoder_data && cache.encoder.committed > 0) {
+            painter.drawPath(cache.encoder.path);
+            painter.drawLine(cache.encoder.points.back(), cache.encoder.current);
+        }
 
-        painter.setPen(Qt::white);
-        if (display_ekf_data) painter.drawPath(scaled_ekf_rover_path);
-        painter.setPen(green);
-        if (display_encoder_data) painter.drawPath(scaled_encoder_rover_path);
+        painter.restore();
 
         painter.setPen(red);
-        QPoint* point_array = &scaled_collection_points[0];
-        painter.drawPoints(point_array, scaled_collection_points.size());
+        painter.drawPoints(cache.collection_points.data(), cache.collection_points.size());
         painter.setPen(green);
-        point_array = &scaled_target_locations[0];
-        painter.drawPoints(point_array, scaled_target_locations.size());
+        painter.drawPoints(cache.target_locations.data(), cache.target_locations.size());
 
         // Draw a yellow circle at the current EKF estimated rover location
         painter.setPen(Qt::yellow);
-        pair<float,float> current_coordinate; //check if EKFPath is empty before takeing coordinates off the back
-        if(!map_data->getEKFPath(rover_to_display)->empty()) {
-          current_coordinate = map_data->getEKFPath(rover_to_display)->back();
-        }
-        QPoint point;
-        float x = map_origin_x+((current_coordinate.first-min_seen_x)/max_seen_width)*(map_width-map_origin_x);
-        float y = map_origin_y+((current_coordinate.second-min_seen_y)/max_seen_height)*(map_height-map_origin_y);
+        QPointF current_coordinate = cache.ekf.has_current ? cache.ekf.current : QPointF(0,0);
+        QPointF point = map_transform.map(current_coordinate);
         float radius = 2.5;
         //painter.drawArc(x-radius,y-radius,2*radius,2*radius,0,16*360);
-        painter.drawEllipse(QPointF(x,y), radius, radius);
-        painter.drawText(QPoint(x,y), QString::fromStdString(rover_to_display));
-
-        map_data->unlock();
+        painter.drawEllipse(point, radius, radius);
+        painter.drawText(point.toPoint(), QString::fromStdString(map_data->getRoverName(rover_to_display)));
 
         painter.setPen(Qt::white);
     } // End rover display list set iteration
@@ -399,6 +405,35 @@ void MapFrame::paintEvent(QPaintEvent* event) {
 }
 
 
+void MapFrame::updatePathCache(PathCache& cache, const std::vector< std::pair<float,float> >* path, unsigned long revision)
+{
+    // The points before the current position only change when the path is compacted
+    if (cache.revision != revision || path->size() < cache.committed+1)
+    {
+        cache.revision = revision;
+        cache.committed = 0;
+        cache.path = QPainterPath();
+        cache.points.clear();
+    }
+
+    cache.has_current = !path->empty();
+    if (!cache.has_current) return;
+
+    size_t committed = path->size()-1;
+    for (size_t i = cache.committed; i < committed; i++)
+    {
+        QPointF point((*path)[i].first, (*path)[i].second);
+
+        // Move to the starting point of the path without drawing a line
+        if (i == 0) cache.path.moveTo(point);
+        else cache.path.lineTo(point);
+
+        cache.points.push_back(point);
+    }
+    cache.committed = committed;
+    cache.current = QPointF(path->back().first, path->back().second);
+}
+
 void MapFrame::setDisplayEncoderData(bool display)
 {
     display_encoder_data = display;
@@ -420,22 +455,25 @@ void MapFrame::setDisplayEKFData(bool display)
     if(popout_mapframe) popout_mapframe->setDisplayEKFData(display);
 }
 
-void MapFrame::setWhetherToDisplay(string rover, bool yes)
+void MapFrame::setWhetherToDisplay(int rover_id, bool yes)
 {
+    // Rovers that never connected have nothing to display
+    if (rover_id < 0) return;
+
     map_data->lock();
 
     if (yes)
     {
-        display_list.insert(rover);
+        display_list.insert(rover_id);
     }
     else
     {
-        display_list.erase(rover);
+        display_list.erase(rover_id);
     }
 
     map_data->unlock();
 
-    if(popout_mapframe) popout_mapframe->setWhetherToDisplay(rover, yes);
+    if(popout_mapframe) popout_mapframe->setWhetherToDisplay(rover_id, yes);
 }
 
 void MapFrame::mouseReleaseEvent(QMouseEvent *event) {
@@ -569,13 +607,15 @@ void MapFrame::clear()
 {
     map_data->lock();
     display_list.clear();
+    rover_cache.clear();
     map_data->unlock();
 }
 
-void MapFrame::clear(string rover)
+void MapFrame::clear(int rover_id)
 {
     map_data->lock();
-    display_list.erase(rover);
+    display_list.erase(rover_id);
+    if (rover_id >= 0 && rover_id < (int)rover_cache.size()) rover_cache[rover_id] = RoverCache();
     map_data->unlock();
 }
 
@@ -589,35 +629,44 @@ void MapFrame::popout()
      map_data = data;
  }
 
- void MapFrame::addToGPSRoverPath(std::string rover, float x, float y)
+ void MapFrame::addToGPSRoverPath(int rover_id, float x, float y)
  {
      if (map_data)
      {
-        map_data->addToGPSRoverPath(rover, x, y);
-        emit delayedUpdate();
+        map_data->addToGPSRoverPath(rover_id, x, y);
+        markDirty();
      }
  }
 
- void MapFrame::addToEncoderRoverPath(std::string rover, float x, float y)
+ void MapFrame::addToEncoderRoverPath(int rover_id, float x, float y)
  {
      if (map_data)
      {
-        map_data->addToEncoderRoverPath(rover, x, y);
-        emit delayedUpdate();
+        map_data->addToEncoderRoverPath(rover_id, x, y);
+        markDirty();
      }
 }
 
- void MapFrame::addToEKFRoverPath(std::string rover, float x, float y)
+ void MapFrame::addToEKFRoverPath(int rover_id, float x, float y)
  {
      if (map_data)
      {
-         map_data->addToEKFRoverPath(rover, x, y);
-         emit delayedUpdate();
+         map_data->addToEKFRoverPath(rover_id, x, y);
+         markDirty();
      }
  }
 
+// Repaints this frame and its popout copy at the scheduler's rate
+void MapFrame::markDirty()
+{
+    RepaintScheduler::instance().markDirty(this);
+    if (popout_mapframe) RepaintScheduler::instance().markDirty(popout_mapframe);
+}
+
 MapFrame::~MapFrame()
 {
+    RepaintScheduler::instance().remove(this);
+
     // Safely erase map data - locks to make sure a frame isnt being drawn
     // clearMap();
     if (popout_window) delete popout_window;
@@ -22,6 +22,8 @@
 #include <QImage>
 #include <QMutex>
 #include <QPainter>
+#include <QPainterPath>
+#include <QPointF>
 #include <vector>
 #include <set>
 #include <utility> // For STL pair
@@ -45,21 +47,22 @@ namespace rqt_rover_gui
 
       MapFrame(QWidget *parent, Qt::WFlags = 0);
 
-      void setWhetherToDisplay(string rover, bool yes);
+      // Rovers are identified by the ID MapData::registerRover gave them
+      void setWhetherToDisplay(int rover_id, bool yes);
       void createPopoutWindow(MapData *map_data);
 
       void setDisplayEncoderData(bool display);
       void setDisplayGPSData(bool display);
       void setDisplayEKFData(bool display);
 
-      void addToGPSRoverPath(std::string rover, float x, float y);
-      void addToEncoderRoverPath(std::string rover, float x, float y);
-      void addToEKFRoverPath(std::string rover, float x, float y);
+      void addToGPSRoverPath(int rover_id, float x, float y);
+      void addToEncoderRoverPath(int rover_id, float x, float y);
+      void addToEKFRoverPath(int rover_id, float x, float y);
 
       void setMapData(MapData* map_data);
 
       void clear();
-      void clear(std::string rover);
+      void clear(int rover_id);
 
       // Set the map scale and translation using user mouse clicks
       // wheel for zooming in and out
@@ -79,7 +82,6 @@ namespace rqt_rover_gui
     signals:
 
       void sendInfoLogMessage(QString msg);
-      void delayedUpdate();
 
     public slots:
 
@@ -93,6 +95,40 @@ namespace rqt_rover_gui
 
     private:
 
+      // Queues a repaint of this frame and the popout copy
+      void markDirty();
+
+      // Geometry of one path in map coordinates. It is drawn through the map
+      // transform so zooming, panning and rescaling do not rebuild it. Points
+      // are appended as the path grows and it is only rebuilt when MapData
+      // compacts the path, which changes the revision.
+      struct PathCache
+      {
+        PathCache() : revision(0), committed(0), has_current(false) {}
+
+        unsigned long revision;
+        size_t committed; // Points other than the current position already in the cache
+        QPainterPath path;
+        std::vector<QPointF> points;
+        bool has_current;
+        QPointF current; // The last point in the path, the most recent position
+      };
+
+      // Everything drawn for a rover, copied from MapData while it is locked
+      struct RoverCache
+      {
+        PathCache ekf;
+        PathCache gps;
+        PathCache encoder;
+        std::vector<QPoint> target_locations;
+        std::vector<QPoint> collection_points;
+      };
+
+      // Appends the points added to the path since the last frame
+      void updatePathCache(PathCache& cache, const std::vector< std::pair<float,float> >* path, unsigned long revision);
+
+      std::vector<RoverCache> rover_cache; // Indexed by rover ID
+
       mutable QMutex update_mutex;
       int frame_width;
       int frame_height;
@@ -104,7 +140,7 @@ namespace rqt_rover_gui
       QTime frame_rate_timer;
       int frames;
 
-      set<string> display_list;
+      set<int> display_list;
 
       // For external pop out window
       QMainWindow* popout_window;
@@ -0,0 +1,76 @@
+#include "ModelLocations.h"
+
+#include <cmath>
+
+using namespace std;
+
+ModelLocations::ModelLocations(float cell_size) :
+    cell_size(cell_size),
+    max_clearance(0),
+    n_locations(0)
+{
+}
+
+void ModelLocations::insert(float x, float y, float clearance)
+{
+    Location location;
+    location.x = x;
+    location.y = y;
+    location.clearance = clearance;
+    cells[cellKey(cellCoordinate(x), cellCoordinate(y))].push_back(location);
+
+    if (clearance > max_clearance) max_clearance = clearance;
+    n_locations++;
+}
+
+void ModelLocations::clear()
+{
+    cells.clear();
+    max_clearance = 0;
+    n_locations = 0;
+}
+
+bool ModelLocations::overlaps(float x, float y, float clearance) const
+{
+    if (n_locations == 0) return false;
+
+    // Any overlapping model has its center within this distance of (x, y)
+    float reach = clearance + max_clearance;
+
+    int min_cell_x = cellCoordinate(x - reach);
+    int max_cell_x = cellCoordinate(x + reach);
+    int min_cell_y = cellCoordinate(y - reach);
+    int max_cell_y = cellCoordinate(y + reach);
+
+    for (int i = min_cell_x; i <= max_cell_x; i++)
+    {
+        for (int j = min_cell_y; j <= max_cell_y; j++)
+        {
+            unordered_map<CellKey, vector<Location> >::const_iterator cell = cells.find(cellKey(i, j));
+            if (cell == cells.end()) continue;
+
+            for (size_t k = 0; k < cell->second.size(); k++)
+            {
+                const Location& used = cell->second[k];
+
+                // Compare squared distances between the circle centers
+                float dx = x - used.x;
+                float dy = y - used.y;
+                float min_distance = clearance + used.clearance;
+                if (dx*dx + dy*dy < min_distance*min_distance) return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+int ModelLocations::cellCoordinate(float value) const
+{
+    return (int) floor(value / cell_size);
+}
+
+ModelLocations::CellKey ModelLocations::cellKey(int cell_x, int cell_y) const
+{
+    return ((CellKey) cell_x << 32) | (unsigned int) cell_y;
+}
@@ -0,0 +1,45 @@
+#ifndef MODELLOCATIONS_H
+#define MODELLOCATIONS_H
+
+#include <unordered_map>
+#include <vector>
+
+// The footprints of the models in the simulation, each a circle in the xy
+// plane given by its center and clearance. Footprints are bucketed by center
+// in a uniform grid so an overlap query only looks at the cells within reach
+// of the query circle and the largest clearance seen so far, instead of
+// every model in the arena.
+class ModelLocations
+{
+public:
+    ModelLocations(float cell_size = 1.0);
+
+    void insert(float x, float y, float clearance);
+    void clear();
+
+    // True if the circle overlaps the footprint of any model
+    bool overlaps(float x, float y, float clearance) const;
+
+    int size() const { return n_locations; }
+
+private:
+    struct Location
+    {
+        float x;
+        float y;
+        float clearance;
+    };
+
+    typedef long long CellKey;
+
+    int cellCoordinate(float value) const;
+    CellKey cellKey(int cell_x, int cell_y) const;
+
+    float cell_size;
+    float max_clearance;
+    int n_locations;
+
+    std::unordered_map<CellKey, std::vector<Location> > cells;
+};
+
+#endif // MODELLOCATIONS_H
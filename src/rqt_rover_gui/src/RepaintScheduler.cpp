@@ -0,0 +1,78 @@
+#include "RepaintScheduler.h"
+#include <QMutexLocker>
+#include <QTimerEvent>
+#include <algorithm>
+
+RepaintScheduler& RepaintScheduler::instance()
+{
+    static RepaintScheduler scheduler;
+    return scheduler;
+}
+
+RepaintScheduler::RepaintScheduler() : max_rate(30), timer_id(0)
+{
+}
+
+void RepaintScheduler::add(QWidget* widget)
+{
+    {
+        QMutexLocker lock(&mutex);
+        widgets.insert(widget);
+    }
+
+    if (timer_id == 0) restartTimer();
+}
+
+void RepaintScheduler::remove(QWidget* widget)
+{
+    bool empty;
+
+    {
+        QMutexLocker lock(&mutex);
+        widgets.erase(widget);
+        dirty_widgets.erase(widget);
+        empty = widgets.empty();
+    }
+
+    if (empty && timer_id != 0)
+    {
+        killTimer(timer_id);
+        timer_id = 0;
+    }
+}
+
+void RepaintScheduler::markDirty(QWidget* widget)
+{
+    QMutexLocker lock(&mutex);
+    if (widgets.count(widget)) dirty_widgets.insert(widget);
+}
+
+void RepaintScheduler::setMaxRate(float max_rate)
+{
+    this->max_rate = std::max(max_rate, 1.0f);
+    if (timer_id != 0) restartTimer();
+}
+
+void RepaintScheduler::restartTimer()
+{
+    if (timer_id != 0) killTimer(timer_id);
+    timer_id = startTimer(1000 / max_rate);
+}
+
+void RepaintScheduler::timerEvent(QTimerEvent* event)
+{
+    if (event->timerId() != timer_id) return;
+
+    std::set<QWidget*> repaint;
+
+    {
+        QMutexLocker lock(&mutex);
+        repaint.swap(dirty_widgets);
+    }
+
+    // Widgets are only removed on this thread so the ones taken above are still alive
+    for (std::set<QWidget*>::iterator it = repaint.begin(); it != repaint.end(); ++it)
+    {
+        if ((*it)->isVisible()) (*it)->update();
+    }
+}
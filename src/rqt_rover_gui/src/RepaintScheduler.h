@@ -0,0 +1,45 @@
+#ifndef REPAINTSCHEDULER_H
+#define REPAINTSCHEDULER_H
+
+#include <QMutex>
+#include <QObject>
+#include <QWidget>
+#include <set>
+
+// Repaints the GUI frames at a capped rate no matter how fast their data arrives. The ROS
+// callbacks mark a frame dirty, from any thread, and a timer on the GUI thread updates the
+// dirty frames at most max_rate times a second. Frames that are not visible, such as those on
+// a hidden tab of a BWTabWidget or in a closed popout window, are skipped since Qt paints them
+// anyway when they are shown.
+class RepaintScheduler : public QObject
+{
+public:
+    static RepaintScheduler& instance();
+
+    // Called from the GUI thread, normally in the frame's constructor and destructor
+    void add(QWidget* widget);
+    void remove(QWidget* widget);
+
+    // Safe to call from any thread. Does nothing for a widget that was not added.
+    void markDirty(QWidget* widget);
+
+    // Repaints per second, 30 by default
+    void setMaxRate(float max_rate);
+
+protected:
+    void timerEvent(QTimerEvent* event);
+
+private:
+    RepaintScheduler();
+
+    void restartTimer();
+
+    QMutex mutex;
+    std::set<QWidget*> widgets;
+    std::set<QWidget*> dirty_widgets;
+
+    float max_rate;
+    int timer_id; // 0 while no widgets are added so no timer outlives the GUI
+};
+
+#endif // REPAINTSCHEDULER_H
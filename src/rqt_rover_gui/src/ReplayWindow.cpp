@@ -0,0 +1,108 @@
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QSlider>
+#include <QTime>
+#include <QVBoxLayout>
+#include <cmath>
+
+#include "MapData.h"
+#include "MapFrame.h"
+#include "ReplayWindow.h"
+
+namespace rqt_rover_gui
+{
+
+// The slider moves in tenths of a second
+static const int slider_steps_per_second = 10;
+
+static QString formatRunTime(float seconds)
+{
+    return QTime(0, 0).addMSecs(seconds * 1000).toString("hh:mm:ss");
+}
+
+ReplayWindow::ReplayWindow(QWidget *parent) : QMainWindow(parent)
+{
+    map_data = new MapData();
+
+    map_frame = new MapFrame(0, 0);
+    map_frame->setMapData(map_data);
+
+    seek_slider = new QSlider(Qt::Horizontal);
+    seek_slider->setEnabled(false);
+    connect(seek_slider, SIGNAL(valueChanged(int)), this, SLOT(seekSliderEventHandler(int)));
+
+    time_label = new QLabel();
+    time_label->setStyleSheet("color: rgb(255, 255, 255);");
+
+    QHBoxLayout* seek_layout = new QHBoxLayout();
+    seek_layout->addWidget(seek_slider);
+    seek_layout->addWidget(time_label);
+
+    QVBoxLayout* layout = new QVBoxLayout();
+    layout->addWidget(map_frame, 1);
+    layout->addLayout(seek_layout);
+
+    QWidget* central_widget = new QWidget();
+    central_widget->setLayout(layout);
+
+    setGeometry(QRect(10, 10, 500, 540));
+    setStyleSheet("background-color: rgb(0, 0, 0); border-color: rgb(255, 255, 255);");
+    setCentralWidget(central_widget);
+}
+
+bool ReplayWindow::open(QString path)
+{
+    if (!map_data->openReplay(path.toStdString())) return false;
+
+    setWindowTitle("Replay: " + path);
+
+    seek_slider->setRange(0, ceil(map_data->getReplayDuration() * slider_steps_per_second));
+    seek_slider->setEnabled(true);
+
+    // Start with the whole run on the map
+    seek_slider->setValue(seek_slider->maximum());
+    seekSliderEventHandler(seek_slider->value());
+
+    return true;
+}
+
+void ReplayWindow::setDisplayEncoderData(bool display)
+{
+    map_frame->setDisplayEncoderData(display);
+}
+
+void ReplayWindow::setDisplayGPSData(bool display)
+{
+    map_frame->setDisplayGPSData(display);
+}
+
+void ReplayWindow::setDisplayEKFData(bool display)
+{
+    map_frame->setDisplayEKFData(display);
+}
+
+void ReplayWindow::seekSliderEventHandler(int value)
+{
+    float time = (float)value / slider_steps_per_second;
+    map_data->seekReplay(time);
+
+    // Seeking back replaces the paths, so the frame drops what it has cached. Every rover
+    // in the log is shown, including those that registered since the last seek.
+    map_frame->clear();
+    for (int rover_id = 0; rover_id < map_data->getRoverCount(); rover_id++)
+    {
+        map_frame->setWhetherToDisplay(rover_id, true);
+    }
+    map_frame->update();
+
+    time_label->setText(formatRunTime(time) + " / " + formatRunTime(map_data->getReplayDuration()));
+}
+
+ReplayWindow::~ReplayWindow()
+{
+    // The frame draws from the map data so it goes first
+    delete map_frame;
+    delete map_data;
+}
+
+}
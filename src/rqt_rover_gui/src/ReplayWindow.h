@@ -0,0 +1,52 @@
+/*!
+ * \brief   A window that replays a run log written by MapData, so the map of
+ *          a finished or crashed run can be reviewed without rosbag or the
+ *          rovers. The slider seeks to any time in the run. The live map in
+ *          the GUI keeps running while the replay is open.
+ * \class   ReplayWindow
+ */
+
+#ifndef REPLAYWINDOW_H
+#define REPLAYWINDOW_H
+
+#include <QMainWindow>
+#include <QString>
+
+class QLabel;
+class QSlider;
+class MapData;
+
+using namespace std;
+
+namespace rqt_rover_gui
+{
+
+class MapFrame;
+
+class ReplayWindow : public QMainWindow
+{
+    Q_OBJECT
+public:
+    ReplayWindow(QWidget *parent = 0);
+    ~ReplayWindow();
+
+    // Returns false if the file is not a run log
+    bool open(QString path);
+
+    void setDisplayEncoderData(bool display);
+    void setDisplayGPSData(bool display);
+    void setDisplayEKFData(bool display);
+
+private slots:
+    void seekSliderEventHandler(int value);
+
+private:
+    MapData* map_data;
+    MapFrame* map_frame;
+    QSlider* seek_slider;
+    QLabel* time_label;
+};
+
+}
+
+#endif // REPLAYWINDOW_H
@@ -0,0 +1,84 @@
+#include <RoverDiscovery.h>
+
+#include <algorithm>
+#include <iterator>
+#include <ros/ros.h>
+
+using namespace std;
+
+namespace rqt_rover_gui
+{
+
+RoverDiscovery::RoverDiscovery(int poll_interval_ms) : QObject(NULL)
+{
+    poll_interval = poll_interval_ms;
+    poll_timer = NULL;
+}
+
+void RoverDiscovery::start()
+{
+    // Created here so the timer belongs to the discovery thread
+    if (!poll_timer)
+    {
+        poll_timer = new QTimer(this);
+        connect(poll_timer, SIGNAL(timeout()), this, SLOT(poll()));
+    }
+
+    poll_timer->start(poll_interval);
+    poll();
+}
+
+void RoverDiscovery::stop()
+{
+    if (poll_timer) poll_timer->stop();
+}
+
+void RoverDiscovery::poll()
+{
+    set<string> new_rovers;
+
+    ros::master::V_TopicInfo master_topics;
+    ros::master::getTopics(master_topics);
+
+    // Rovers are the namespaces that have a status topic
+    for (ros::master::V_TopicInfo::iterator it = master_topics.begin() ; it != master_topics.end(); it++)
+    {
+        const ros::master::TopicInfo& info = *it;
+
+        std::size_t found = info.name.find("/status");
+        if (found!=std::string::npos)
+        {
+            string rover_name = info.name.substr(1,found-1);
+
+            found = rover_name.find("/"); // Eliminate potential names with / in them
+            if (found==std::string::npos)
+            {
+                new_rovers.insert(rover_name);
+            }
+        }
+    }
+
+    if (new_rovers == rovers) return;
+
+    set<string> disconnected;
+    std::set_difference(rovers.begin(), rovers.end(), new_rovers.begin(), new_rovers.end(),
+        std::inserter(disconnected, disconnected.end()));
+
+    set<string> connected;
+    std::set_difference(new_rovers.begin(), new_rovers.end(), rovers.begin(), rovers.end(),
+        std::inserter(connected, connected.end()));
+
+    rovers = new_rovers;
+
+    for (set<string>::iterator it = disconnected.begin(); it != disconnected.end(); ++it)
+    {
+        emit roverDisconnected(QString::fromStdString(*it));
+    }
+
+    for (set<string>::iterator it = connected.begin(); it != connected.end(); ++it)
+    {
+        emit roverConnected(QString::fromStdString(*it));
+    }
+}
+
+}
@@ -0,0 +1,49 @@
+/*!
+ * \brief   Finds the connected rovers by looking for their status topics on
+ *          the ROS master. The master is queried from the thread this object
+ *          has been moved to, so a slow master does not block the GUI, and
+ *          only changes to the set of rovers are reported.
+ * \class   RoverDiscovery
+ */
+
+#ifndef ROVERDISCOVERY_H
+#define ROVERDISCOVERY_H
+
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <set>
+#include <string>
+
+namespace rqt_rover_gui
+{
+
+class RoverDiscovery : public QObject
+{
+    Q_OBJECT
+public:
+    RoverDiscovery(int poll_interval_ms);
+
+public slots:
+
+    // Polls now and then every poll interval. Call from the thread this object lives in.
+    void start();
+    void stop();
+    void poll();
+
+signals:
+
+    void roverConnected(QString rover_name);
+    void roverDisconnected(QString rover_name);
+
+private:
+
+    int poll_interval;
+    QTimer* poll_timer;
+
+    std::set<std::string> rovers; // The rovers found by the last poll
+};
+
+}
+
+#endif // ROVERDISCOVERY_H
@@ -0,0 +1,97 @@
+#include "RoverPath.h"
+
+#include <atomic>
+#include <cmath>
+
+using namespace std;
+
+// Shared by all paths so a path that replaces another never reuses its revision
+static atomic<unsigned long> next_revision(1);
+
+RoverPath::RoverPath(size_t point_budget, float spacing, float turn_angle) :
+    point_budget(point_budget < 3 ? 3 : point_budget),
+    initial_spacing(spacing),
+    spacing(spacing),
+    turn_angle(turn_angle),
+    revision(next_revision++),
+    has_direction(false)
+{
+    points.reserve(this->point_budget + 1);
+}
+
+void RoverPath::add(float x, float y)
+{
+    // The first point and the current position are always kept
+    if (points.size() < 2)
+    {
+        points.push_back(pair<float,float>(x,y));
+        return;
+    }
+
+    // The last point is the current position, the one before it is the last point we committed to
+    const pair<float,float>& anchor = points[points.size()-2];
+
+    float dx = x - anchor.first;
+    float dy = y - anchor.second;
+    float distance = hypot(dx, dy);
+
+    bool keep_current = false;
+    if (!has_direction)
+    {
+        if (distance >= spacing)
+        {
+            has_direction = true;
+            direction_x = dx;
+            direction_y = dy;
+            furthest = distance;
+        }
+    }
+    else
+    {
+        // Keep the current position if the rover turned or started coming back
+        float turned = fabs(atan2(direction_x*dy - direction_y*dx, direction_x*dx + direction_y*dy));
+        keep_current = turned > turn_angle || distance < furthest - spacing;
+        if (distance > furthest) furthest = distance;
+    }
+
+    if (!keep_current)
+    {
+        points.back() = pair<float,float>(x,y);
+        return;
+    }
+
+    // The current position becomes the point we measure from
+    has_direction = false;
+    points.push_back(pair<float,float>(x,y));
+    if (points.size() > point_budget) compact();
+}
+
+void RoverPath::compact()
+{
+    // Keep every other point between the first and the current position
+    size_t last = points.size()-1;
+    size_t kept = 1;
+    for (size_t i = 2; i < last; i += 2)
+    {
+        points[kept++] = points[i];
+    }
+    points[kept++] = points[last];
+    points.resize(kept);
+
+    spacing *= 2;
+    revision = next_revision++;
+}
+
+void RoverPath::setPointBudget(size_t point_budget)
+{
+    this->point_budget = point_budget < 3 ? 3 : point_budget;
+    while (points.size() > this->point_budget) compact();
+}
+
+void RoverPath::clear()
+{
+    points.clear();
+    spacing = initial_spacing;
+    has_direction = false;
+    revision = next_revision++;
+}
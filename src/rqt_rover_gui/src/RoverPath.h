@@ -0,0 +1,52 @@
+#ifndef ROVERPATH_H
+#define ROVERPATH_H
+
+#include <vector>
+#include <utility> // For STL std::pair
+#include <cstddef>
+
+// A rover path with a bounded number of points. Points closer than the
+// current spacing to the last kept point are merged, and points along a
+// straight line are replaced by the newest one until the direction from the
+// last kept point turns by more than the turn angle or the rover heads back. When the budget is
+// reached every other point is dropped and the spacing doubles, so the whole
+// run stays visible at a resolution that coarsens as the run gets longer.
+// The last point is always the most recent position.
+class RoverPath
+{
+public:
+    RoverPath(size_t point_budget = 4000, float spacing = 0.05, float turn_angle = 0.1);
+
+    void add(float x, float y);
+    void clear();
+
+    // Changes the budget, compacting the path if it is already over it
+    void setPointBudget(size_t point_budget);
+
+    const std::vector< std::pair<float,float> >* getPoints() const { return &points; }
+
+    // Changes whenever points other than the last are moved or removed. While it
+    // stays the same points are only appended before the current position.
+    unsigned long getRevision() const { return revision; }
+
+private:
+    void compact();
+
+    std::vector< std::pair<float,float> > points;
+
+    size_t point_budget;
+    float initial_spacing;
+    float spacing;
+    float turn_angle;
+
+    unsigned long revision;
+
+    // Direction from the last kept point once the rover has moved one spacing
+    // away from it, and the furthest it has been from that point since
+    bool has_direction;
+    float direction_x;
+    float direction_y;
+    float furthest;
+};
+
+#endif // ROVERPATH_H
@@ -0,0 +1,185 @@
+#include "RunLog.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+namespace
+{
+    struct RunLogHeader
+    {
+        char magic[8];
+        unsigned int version;
+        unsigned int record_size;
+    };
+
+    const char run_log_magic[8] = {'R', 'O', 'V', 'E', 'R', 'L', 'O', 'G'};
+    const unsigned int run_log_version = 1;
+
+    // Smaller buffers are written by flush, this only bounds the memory between flushes
+    const size_t max_buffered_records = 4096;
+
+    bool recordBefore(float time, const RunLogRecord& record)
+    {
+        return time < record.time;
+    }
+
+    bool recordEarlier(const RunLogRecord& a, const RunLogRecord& b)
+    {
+        return a.time < b.time;
+    }
+}
+
+bool RunLogWriter::open(const QString& path)
+{
+    close();
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+
+    RunLogHeader header;
+    memcpy(header.magic, run_log_magic, sizeof(header.magic));
+    header.version = run_log_version;
+    header.record_size = sizeof(RunLogRecord);
+
+    if (file.write((const char*)&header, sizeof(header)) != sizeof(header))
+    {
+        file.close();
+        return false;
+    }
+
+    file.flush();
+    clock.start();
+    flushed_time = 0;
+    return true;
+}
+
+void RunLogWriter::close()
+{
+    if (!file.isOpen()) return;
+
+    flush();
+    file.close();
+}
+
+qint64 RunLogWriter::now()
+{
+    QElapsedTimer timer;
+    timer.start();
+    return timer.msecsSinceReference();
+}
+
+void RunLogWriter::add(RunLogKind kind, int rover_id, float x, float y)
+{
+    add(kind, rover_id, x, y, now());
+}
+
+void RunLogWriter::add(RunLogKind kind, int rover_id, float x, float y, qint64 time)
+{
+    if (!file.isOpen()) return;
+
+    RunLogRecord record;
+    // Data that arrived before the log was started is logged at its start
+    record.time = max<qint64>(time - clock.msecsSinceReference(), 0) / 1000.0;
+    record.rover_id = rover_id;
+    record.kind = kind;
+    record.name_length = 0;
+    record.x = x;
+    record.y = y;
+    buffer.push_back(record);
+
+    if (buffer.size() >= max_buffered_records) flush();
+}
+
+void RunLogWriter::addRoverName(int rover_id, const string& rover_name)
+{
+    if (!file.isOpen()) return;
+
+    // An empty name still needs a record to register the rover. The records of a name
+    // are stamped with the same time so other records are not sorted in between them.
+    qint64 time = now();
+    size_t written = 0;
+    do
+    {
+        add(RUN_LOG_ROVER_NAME, rover_id, 0, 0, time);
+
+        RunLogRecord& record = buffer.back();
+        record.name_length = min(rover_name.size() - written, sizeof(record.x) + sizeof(record.y));
+        memcpy(&record.x, rover_name.data() + written, record.name_length);
+
+        written += record.name_length;
+    } while (written < rover_name.size());
+}
+
+void RunLogWriter::flush()
+{
+    if (!file.isOpen() || buffer.empty()) return;
+
+    // Records received since the last flush were stamped from more than one thread, and a
+    // full buffer is written before the rest of a batch, so the order is restored here
+    stable_sort(buffer.begin(), buffer.end(), recordEarlier);
+    for (size_t i = 0; i < buffer.size(); i++)
+    {
+        buffer[i].time = max(buffer[i].time, flushed_time);
+    }
+    flushed_time = buffer.back().time;
+
+    file.write((const char*)&buffer[0], buffer.size() * sizeof(RunLogRecord));
+    file.flush();
+    buffer.clear();
+}
+
+RunLogWriter::~RunLogWriter()
+{
+    close();
+}
+
+RunLogReader::RunLogReader() : mapping(NULL), records(NULL), count(0)
+{
+}
+
+bool RunLogReader::open(const QString& path)
+{
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    RunLogHeader header;
+    if (file.read((char*)&header, sizeof(header)) != sizeof(header)
+            || memcmp(header.magic, run_log_magic, sizeof(header.magic)) != 0
+            || header.version != run_log_version
+            || header.record_size != sizeof(RunLogRecord))
+    {
+        file.close();
+        return false;
+    }
+
+    // A record that was only partly written when the GUI stopped is left out
+    count = (file.size() - sizeof(header)) / sizeof(RunLogRecord);
+    if (count == 0) return true;
+
+    mapping = file.map(sizeof(header), count * sizeof(RunLogRecord));
+    if (!mapping)
+    {
+        count = 0;
+        file.close();
+        return false;
+    }
+
+    records = (const RunLogRecord*)mapping;
+    return true;
+}
+
+size_t RunLogReader::find(float time) const
+{
+    return upper_bound(records, records + count, time, recordBefore) - records;
+}
+
+float RunLogReader::getDuration() const
+{
+    return count ? records[count-1].time : 0;
+}
+
+RunLogReader::~RunLogReader()
+{
+    if (mapping) file.unmap(mapping);
+}
@@ -0,0 +1,93 @@
+#ifndef RUNLOG_H
+#define RUNLOG_H
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QString>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// A run log is a 16 byte header followed by fixed size records in the order of the
+// times they were stamped with, so their times never decrease. Being fixed size a reader can map the
+// file and binary search it by time without reading it first, and a log cut short by
+// a crash only loses the last record it was writing. The values are in the byte
+// order of the machine that wrote them.
+
+enum RunLogKind
+{
+    RUN_LOG_ROVER_NAME,  // Up to 8 characters of the rover's name, a name takes as many records as it needs
+    RUN_LOG_GPS_POINT,
+    RUN_LOG_EKF_POINT,
+    RUN_LOG_ENCODER_POINT,
+    RUN_LOG_TARGET_LOCATION,
+    RUN_LOG_COLLECTION_POINT,
+    RUN_LOG_CLEAR_ROVER, // Everything the rover had on the map was removed
+    RUN_LOG_CLEAR_ALL
+};
+
+struct RunLogRecord
+{
+    float time; // Seconds since the log was started
+    unsigned short rover_id;
+    unsigned char kind; // A RunLogKind
+    unsigned char name_length; // Characters held in x and y by a RUN_LOG_ROVER_NAME record
+    float x;
+    float y;
+};
+
+class RunLogWriter
+{
+public:
+    // Replaces the file with an empty log. Returns false if it could not be written.
+    bool open(const QString& path);
+    void close();
+    bool isOpen() const { return file.isOpen(); }
+
+    // The clock records are stamped with, in milliseconds. Data that is logged some time
+    // after it arrives is stamped with the time now() returned when it arrived.
+    static qint64 now();
+
+    // The points are in map coordinates, as MapData stores them
+    void add(RunLogKind kind, int rover_id, float x = 0, float y = 0);
+    void add(RunLogKind kind, int rover_id, float x, float y, qint64 time);
+    void addRoverName(int rover_id, const std::string& rover_name);
+
+    // Writes the records added since the last flush in the order of their times. They
+    // are handed to the system so they are kept if the GUI crashes.
+    void flush();
+
+    ~RunLogWriter();
+
+private:
+    QFile file;
+    QElapsedTimer clock;
+    std::vector<RunLogRecord> buffer;
+    float flushed_time; // Of the last record written, no record is written with an earlier time
+};
+
+class RunLogReader
+{
+public:
+    RunLogReader();
+
+    // Maps the log into memory. Returns false if it is not a run log.
+    bool open(const QString& path);
+
+    size_t size() const { return count; }
+    const RunLogRecord& operator[](size_t i) const { return records[i]; }
+
+    // The number of records added at or before time
+    size_t find(float time) const;
+    float getDuration() const;
+
+    ~RunLogReader();
+
+private:
+    QFile file;
+    uchar* mapping;
+    const RunLogRecord* records;
+    size_t count;
+};
+
+#endif // RUNLOG_H
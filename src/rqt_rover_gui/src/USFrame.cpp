@@ -5,13 +5,15 @@
 #include <cmath>
 
 #include <USFrame.h>
+#include "GUIProfiler.h"
+#include "RepaintScheduler.h"
 
 namespace rqt_rover_gui
 {
 
 USFrame::USFrame(QWidget *parent, Qt::WFlags flags) : QFrame(parent)
 {
-    connect(this, SIGNAL(delayedUpdate()), this, SLOT(update()), Qt::QueuedConnection);
+    RepaintScheduler::instance().add(this);
     left_range = 3.0;
     right_range = 3.0;
     center_range = 3.0;
@@ -27,6 +29,8 @@ USFrame::USFrame(QWidget *parent, Qt::WFlags flags) : QFrame(parent)
 
 void USFrame::paintEvent(QPaintEvent* event)
 {
+    ScopedTimer timer("USFrame::paintEvent");
+
     QPainter painter(this);
     painter.setPen(Qt::white);
 
@@ -98,7 +102,7 @@ void USFrame::setCenterRange(float r, float min, float max)
     center_range = r;
     center_min_range = min;
     center_max_range = max;
-    emit delayedUpdate();
+    RepaintScheduler::instance().markDirty(this);
 }
 
 void USFrame::setLeftRange(float r, float min, float max)
@@ -106,7 +110,7 @@ void USFrame::setLeftRange(float r, float min, float max)
     left_range = r;
     left_min_range = min;
     left_max_range = max;
-    emit delayedUpdate();
+    RepaintScheduler::instance().markDirty(this);
 }
 
 void USFrame::setRightRange(float r, float min, float max)
@@ -114,7 +118,12 @@ void USFrame::setRightRange(float r, float min, float max)
     right_range = r;
     right_min_range = min;
     right_max_range = max;
-    emit delayedUpdate();
+    RepaintScheduler::instance().markDirty(this);
+}
+
+USFrame::~USFrame()
+{
+    RepaintScheduler::instance().remove(this);
 }
 
 }
@@ -32,14 +32,11 @@ class USFrame : public QFrame
     Q_OBJECT
 public:
     USFrame(QWidget *parent, Qt::WFlags = 0);
+    ~USFrame();
     void setCenterRange(float r, float min, float max);
     void setLeftRange(float r, float min, float max);
     void setRightRange(float r, float min, float max);
 
-signals:
-
-    void delayedUpdate();
-
 public slots:
 
 
@@ -0,0 +1,418 @@
+// Runs batches of simulated Swarmathon trials without the GUI. Each trial builds the same
+// simulation as the GUI's build button, through GazeboSimManager and ArenaLayout, puts every
+// rover in autonomous mode and records how many targets are on the collection disk over
+// simulated time. Trials run in parallel as child processes of this program, each with its
+// own ROS master and gazebo server on their own ports so they cannot see each other.
+// The results of all the trials are merged into one CSV file.
+//
+// Run with: experiment_runner [--trials N] [--parallel N] [--rovers N] [--duration seconds]
+//                             [--sample-period seconds] [--distribution uniform|clustered|powerlaw]
+//                             [--round prelim|final] [--seed N] [--output results.csv]
+//                             [--world path] [--ros-port N] [--gazebo-port N]
+// SWARMATHON_APP_ROOT must be set as it is for the GUI.
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QProcess>
+#include <QStringList>
+#include <QTextStream>
+#include <ros/ros.h>
+#include <gazebo_msgs/ModelStates.h>
+#include <std_msgs/UInt8.h>
+#include <atomic>
+#include <iostream>
+#include <math.h>
+#include <stdlib.h>
+#include <unistd.h> // For usleep
+#include <vector>
+
+#include "ArenaLayout.h"
+#include "GazeboSimManager.h"
+
+using namespace std;
+
+static const float collection_disk_radius = 0.5; // meters
+static const double stalled_timeout = 60.0; // wall seconds without the simulation clock advancing before a trial is abandoned
+
+struct ExperimentOptions
+{
+    int trials;
+    int parallel;
+    int rovers;
+    double duration;
+    double sample_period;
+    QString distribution;
+    QString round;
+    int seed;
+    QString output;
+    QString world; // Empty for the GUI's default world
+    int ros_port;
+    int gazebo_port;
+    int trial; // Index of the trial to run in this process, -1 when running the whole batch
+};
+
+static bool parseOptions(const QStringList& arguments, ExperimentOptions& options)
+{
+    options.trials = 1;
+    options.parallel = 1;
+    options.rovers = 3;
+    options.duration = 1800;
+    options.sample_period = 10;
+    options.distribution = "powerlaw";
+    options.round = "prelim";
+    options.seed = 1;
+    options.output = "results.csv";
+    options.world = "";
+    options.ros_port = 11411; // Clear of the default ports so a GUI session can run alongside
+    options.gazebo_port = 11445;
+    options.trial = -1;
+
+    for (int i = 1; i < arguments.size(); i++)
+    {
+        if (i + 1 >= arguments.size())
+        {
+            cerr << "Missing value for " << arguments[i].toStdString() << endl;
+            return false;
+        }
+
+        QString name = arguments[i];
+        QString value = arguments[++i];
+
+        if (name == "--trials") options.trials = value.toInt();
+        else if (name == "--parallel") options.parallel = value.toInt();
+        else if (name == "--rovers") options.rovers = value.toInt();
+        else if (name == "--duration") options.duration = value.toDouble();
+        else if (name == "--sample-period") options.sample_period = value.toDouble();
+        else if (name == "--distribution") options.distribution = value;
+        else if (name == "--round") options.round = value;
+        else if (name == "--seed") options.seed = value.toInt();
+        else if (name == "--output") options.output = value;
+        else if (name == "--world") options.world = value;
+        else if (name == "--ros-port") options.ros_port = value.toInt();
+        else if (name == "--gazebo-port") options.gazebo_port = value.toInt();
+        else if (name == "--trial") options.trial = value.toInt();
+        else
+        {
+            cerr << "Unknown option " << name.toStdString() << endl;
+            return false;
+        }
+    }
+
+    if (options.trials < 1 || options.parallel < 1 || options.rovers < 1 || options.rovers > 6 || options.duration <= 0 || options.sample_period <= 0)
+    {
+        cerr << "The trials, parallel, duration and sample period must be positive and there can be 1 to 6 rovers" << endl;
+        return false;
+    }
+
+    if (options.distribution != "uniform" && options.distribution != "clustered" && options.distribution != "powerlaw")
+    {
+        cerr << "Unknown target distribution " << options.distribution.toStdString() << endl;
+        return false;
+    }
+
+    if (options.round != "prelim" && options.round != "final")
+    {
+        cerr << "Unknown round " << options.round.toStdString() << endl;
+        return false;
+    }
+
+    return true;
+}
+
+static QString trialOutputPath(const ExperimentOptions& options, int trial)
+{
+    return options.output + ".trial" + QString::number(trial);
+}
+
+// Counts the targets resting on the collection disk each time gazebo publishes the model states
+class CollectionCounter
+{
+public:
+    CollectionCounter() : targets_collected(0) {}
+
+    void modelStatesEventHandler(const gazebo_msgs::ModelStates::ConstPtr& msg)
+    {
+        int collected = 0;
+        for (size_t i = 0; i < msg->name.size() && i < msg->pose.size(); i++)
+        {
+            // Targets are named at0 through at255 by ArenaLayout
+            if (msg->name[i].compare(0, 2, "at") != 0) continue;
+            if (hypot(msg->pose[i].position.x, msg->pose[i].position.y) <= collection_disk_radius) collected++;
+        }
+        targets_collected = collected;
+    }
+
+    int getTargetsCollected() { return targets_collected; }
+
+private:
+    atomic<int> targets_collected;
+};
+
+// Runs one trial against the ROS master and gazebo server on the ports in options, writing
+// a row per sample to the trial's output file
+static int runTrial(int argc, char** argv, const ExperimentOptions& options)
+{
+    int seed = options.seed + options.trial;
+
+    // Every process started from here on, roscore, gazebo and the rover launch files, inherits these
+    QString ros_master_uri = "http://localhost:" + QString::number(options.ros_port);
+    QString gazebo_master_uri = "http://localhost:" + QString::number(options.gazebo_port);
+    setenv("ROS_MASTER_URI", ros_master_uri.toStdString().c_str(), 1);
+    setenv("GAZEBO_MASTER_URI", gazebo_master_uri.toStdString().c_str(), 1);
+
+    QProcess roscore;
+    roscore.start("roscore", QStringList() << "-p" << QString::number(options.ros_port));
+    if (!roscore.waitForStarted())
+    {
+        cerr << "Trial " << options.trial << ": could not start roscore" << endl;
+        return 1;
+    }
+
+    ros::init(argc, argv, "experiment_runner", ros::init_options::NoSigintHandler);
+
+    int master_wait = 0;
+    while (!ros::master::check())
+    {
+        if (master_wait++ > 120)
+        {
+            cerr << "Trial " << options.trial << ": the ROS master at " << ros_master_uri.toStdString() << " did not come up" << endl;
+            roscore.terminate();
+            roscore.waitForFinished();
+            return 1;
+        }
+        usleep(500000);
+    }
+
+    // Has to be set before the node starts so ros::Time follows the simulation clock
+    ros::param::set("/use_sim_time", true);
+
+    ros::NodeHandle nh;
+    CollectionCounter counter;
+    ros::Subscriber model_states_subscriber = nh.subscribe("/gazebo/model_states", 1, &CollectionCounter::modelStatesEventHandler, &counter);
+    ros::AsyncSpinner spinner(1);
+    spinner.start();
+
+    GazeboSimManager sim_mgr;
+    if (!options.world.isEmpty()) sim_mgr.setCustomWorldPath(options.world);
+    sim_mgr.startGazeboServer();
+
+    // The same arena the GUI builds for the selected round
+    float arena_dim = 15;
+    QString barrier_model = "barrier_prelim_round";
+    if (options.round == "final")
+    {
+        arena_dim = 23.1;
+        barrier_model = "barrier_final_round";
+    }
+
+    // The arena and the rovers are spawned in one batch
+    ArenaLayout layout(sim_mgr, arena_dim);
+    layout.queueWalls(barrier_model);
+    sim_mgr.queueGroundPlane("mars_ground_plane");
+    sim_mgr.queueModel("collection_disk", "collection_disk", 0, 0, 0, collection_disk_radius);
+
+    QString rovers[6] = {"achilles", "aeneas", "ajax", "diomedes", "hector", "paris"};
+    float rover_positions[6][2] = {{0,1}, {1,1}, {1,0}, {-1,0}, {0,-1}, {-1,-1}};
+
+    QList<QString> rover_names;
+    for (int i = 0; i < options.rovers; i++)
+    {
+        sim_mgr.queueRover(rovers[i], rover_positions[i][0], rover_positions[i][1], 0);
+        rover_names.append(rovers[i]);
+    }
+    cout << sim_mgr.spawnQueuedModels().result().toStdString() << endl;
+
+    for (int i = 0; i < options.rovers; i++) sim_mgr.startRoverNode(rovers[i]);
+
+    // Seed just before placing the targets so a trial's layout only depends on its seed
+    srand(seed);
+    if (options.distribution == "uniform") layout.queueUniformTargets();
+    else if (options.distribution == "clustered") layout.queueClusteredTargets();
+    else layout.queuePowerLawTargets();
+    cout << sim_mgr.spawnQueuedModels().result().toStdString() << endl;
+
+    // Latched so the rover nodes pick up the mode whenever they subscribe
+    vector<ros::Publisher> control_mode_publishers;
+    std_msgs::UInt8 control_mode_msg;
+    control_mode_msg.data = 2; // 2 indicates autonomous control
+    for (int i = 0; i < options.rovers; i++)
+    {
+        control_mode_publishers.push_back(nh.advertise<std_msgs::UInt8>("/"+rovers[i].toStdString()+"/mode", 10, true));
+        control_mode_publishers.back().publish(control_mode_msg);
+    }
+
+    QFile output_file(trialOutputPath(options, options.trial));
+    output_file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text);
+    QTextStream output(&output_file);
+
+    int status = 0;
+
+    // Sample against the simulation clock, which starts once gazebo publishes it
+    ros::Time start_time;
+    ros::WallTime last_progress = ros::WallTime::now();
+    while (ros::ok() && (start_time = ros::Time::now()).isZero())
+    {
+        if ((ros::WallTime::now() - last_progress).toSec() > stalled_timeout) break;
+        usleep(10000);
+    }
+
+    double next_sample = 0;
+    ros::Time last_time = start_time;
+    while (ros::ok() && !start_time.isZero())
+    {
+        ros::Time now = ros::Time::now();
+        double elapsed = (now - start_time).toSec();
+
+        if (now != last_time)
+        {
+            last_time = now;
+            last_progress = ros::WallTime::now();
+        }
+        else if ((ros::WallTime::now() - last_progress).toSec() > stalled_timeout)
+        {
+            cerr << "Trial " << options.trial << ": the simulation clock stopped at " << elapsed << " s" << endl;
+            status = 1;
+            break;
+        }
+
+        if (elapsed >= next_sample)
+        {
+            output << options.trial << "," << seed << "," << next_sample << "," << counter.getTargetsCollected() << "\n";
+            output.flush();
+            next_sample += options.sample_period;
+        }
+
+        if (elapsed >= options.duration) break;
+
+        usleep(10000);
+    }
+
+    if (start_time.isZero())
+    {
+        cerr << "Trial " << options.trial << ": the simulation clock never started" << endl;
+        status = 1;
+    }
+
+    output_file.close();
+
+    // Tear down in the same order as the GUI's clear simulation button
+    QFuture<QString> stopping = sim_mgr.stopRoverNodes(rover_names);
+    stopping.waitForFinished();
+    sim_mgr.stopRoverProcesses();
+    sim_mgr.stopGazeboServer();
+
+    spinner.stop();
+    ros::shutdown();
+
+    roscore.terminate();
+    roscore.waitForFinished();
+
+    return status;
+}
+
+// Arguments for a child process running one trial on the ports of the given slot
+static QStringList trialArguments(const ExperimentOptions& options, int trial, int slot)
+{
+    return QStringList()
+        << "--rovers" << QString::number(options.rovers)
+        << "--duration" << QString::number(options.duration)
+        << "--sample-period" << QString::number(options.sample_period)
+        << "--distribution" << options.distribution
+        << "--round" << options.round
+        << "--seed" << QString::number(options.seed)
+        << "--output" << options.output
+        << "--world" << options.world
+        << "--ros-port" << QString::number(options.ros_port + slot)
+        << "--gazebo-port" << QString::number(options.gazebo_port + slot)
+        << "--trial" << QString::number(trial);
+}
+
+// Runs every trial, at most options.parallel at a time, and merges their rows into options.output
+static int runBatch(const ExperimentOptions& options)
+{
+    vector<QProcess*> trial_processes(options.parallel, (QProcess*) NULL);
+    vector<int> slot_trials(options.parallel, -1);
+    vector<bool> trial_succeeded(options.trials, false);
+    int next_trial = 0;
+    int running = 0;
+
+    while (next_trial < options.trials || running > 0)
+    {
+        for (int slot = 0; slot < options.parallel; slot++)
+        {
+            if (trial_processes[slot] != NULL && trial_processes[slot]->state() == QProcess::NotRunning)
+            {
+                int trial = slot_trials[slot];
+                trial_succeeded[trial] = trial_processes[slot]->exitStatus() == QProcess::NormalExit && trial_processes[slot]->exitCode() == 0;
+                cout << "Trial " << trial << (trial_succeeded[trial] ? " finished" : " failed") << endl;
+
+                delete trial_processes[slot];
+                trial_processes[slot] = NULL;
+                running--;
+            }
+
+            if (trial_processes[slot] == NULL && next_trial < options.trials)
+            {
+                QProcess* child = new QProcess();
+                child->setProcessChannelMode(QProcess::ForwardedChannels);
+                child->start(QCoreApplication::applicationFilePath(), trialArguments(options, next_trial, slot));
+
+                cout << "Trial " << next_trial << " started on ROS master port " << options.ros_port + slot << endl;
+
+                trial_processes[slot] = child;
+                slot_trials[slot] = next_trial;
+                next_trial++;
+                running++;
+            }
+        }
+
+        // Block on one of the children for a little while rather than spinning
+        for (int slot = 0; slot < options.parallel; slot++)
+        {
+            if (trial_processes[slot] != NULL)
+            {
+                trial_processes[slot]->waitForFinished(1000);
+                break;
+            }
+        }
+    }
+
+    QFile output_file(options.output);
+    if (!output_file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+    {
+        cerr << "Could not write " << options.output.toStdString() << endl;
+        return 1;
+    }
+
+    QTextStream output(&output_file);
+    output << "trial,seed,sim_time,targets_collected\n";
+
+    int failed = 0;
+    for (int trial = 0; trial < options.trials; trial++)
+    {
+        if (!trial_succeeded[trial]) failed++;
+
+        // Rows from a failed trial are kept up to the point it failed
+        QFile trial_file(trialOutputPath(options, trial));
+        if (!trial_file.open(QIODevice::ReadOnly | QIODevice::Text)) continue;
+        output << trial_file.readAll();
+        trial_file.close();
+        trial_file.remove();
+    }
+
+    cout << "Wrote " << options.output.toStdString() << ", " << options.trials - failed << " of " << options.trials << " trials succeeded" << endl;
+
+    return failed == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    ExperimentOptions options;
+    if (!parseOptions(app.arguments(), options)) return 1;
+
+    if (options.trial >= 0) return runTrial(argc, argv, options);
+
+    return runBatch(options);
+}
@@ -23,26 +23,44 @@
 #include <QStringList>
 #include <QLCDNumber>
 #include <QFileDialog>
+#include <QFileInfo>
+#include <QDateTime>
 #include <QComboBox>
 #include <std_msgs/Float32.h>
 #include <std_msgs/UInt8.h>
+#include <ros/file_log.h>
 #include <algorithm>
+#include <unistd.h> // For usleep
 
 #include <boost/property_tree/xml_parser.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/foreach.hpp>
+#include <boost/bind.hpp>
 
 //#include <regex> // For regex expressions
 
+#include "ArenaLayout.h"
+#include "GUIProfiler.h"
+#include "RepaintScheduler.h"
 #include "MapData.h"
+#include "ReplayWindow.h"
 
 #include <cv_bridge/cv_bridge.h>
+#include <sensor_msgs/image_encodings.h>
 #include <opencv/cv.h>
 
 using namespace std;
 
 using boost::property_tree::ptree;
 
+// Records how long a message took to reach its callback, from the stamp in its header or the time
+// it was received. Unstamped messages are skipped.
+static void recordMessageAge(const char* name, const ros::Time& since)
+{
+    if (!GUIProfiler::instance().isEnabled() || since.isZero()) return;
+    GUIProfiler::instance().record(name, (ros::Time::now() - since).toNSec() / 1000);
+}
+
 namespace rqt_rover_gui 
 {
   RoverGUIPlugin::RoverGUIPlugin() : rqt_gui_cpp::Plugin(), widget(0),
@@ -68,17 +86,12 @@ namespace rqt_rover_gui
     // Set object clearance values: radius in meters. Values taken from the max dimension of the gazebo collision box for the object.
     // So one half the distance from two opposing corners of the bounding box.
     // In the case of the collection disk a bounding circle is used which gives the radius directly.
-    // Values are rounded up to the nearest 10cm.
-    target_cluster_size_64_clearance = 0.8;
-    target_cluster_size_16_clearance = 0.6;
-    target_cluster_size_4_clearance = 0.2;
-    target_cluster_size_1_clearance = 0.1;
+    // Values are rounded up to the nearest 10cm. The target and barrier clearances are kept by ArenaLayout.
     rover_clearance = 0.4;
     collection_disk_clearance = 0.5;
 
-    barrier_clearance = 0.5; // Used to prevent targets being placed to close to walls
-
     map_data = new MapData();
+    selected_rover_id = -1;
   }
 
   void RoverGUIPlugin::initPlugin(qt_gui_cpp::PluginContext& context)
@@ -125,6 +138,7 @@ namespace rqt_rover_gui
     connect(ui.map_auto_radio_button, SIGNAL(toggled(bool)), this, SLOT(mapAutoRadioButtonEventHandler(bool)));
     connect(ui.map_manual_radio_button, SIGNAL(toggled(bool)), this, SLOT(mapManualRadioButtonEventHandler(bool)));
     connect(ui.map_popout_button, SIGNAL(pressed()), this, SLOT(mapPopoutButtonEventHandler()));
+    connect(ui.map_replay_button, SIGNAL(pressed()), this, SLOT(mapReplayButtonEventHandler()));
 
 
     // Joystick output display - Drive
@@ -146,6 +160,8 @@ namespace rqt_rover_gui
     connect(ui.custom_world_path_button, SIGNAL(pressed()), this, SLOT(customWorldButtonEventHandler()));
     connect(ui.custom_distribution_radio_button, SIGNAL(toggled(bool)), this, SLOT(customWorldRadioButtonEventHandler(bool)));
     connect(ui.override_num_rovers_checkbox, SIGNAL(toggled(bool)), this, SLOT(overrideNumRoversCheckboxToggledEventHandler(bool)));
+    connect(ui.profiler_checkbox, SIGNAL(toggled(bool)), this, SLOT(profilerCheckboxToggledEventHandler(bool)));
+    connect(ui.profiler_export_button, SIGNAL(pressed()), this, SLOT(profilerExportButtonEventHandler()));
 
 
     // Receive log messages from contained frames
@@ -158,13 +174,56 @@ namespace rqt_rover_gui
     // Create a subscriber to listen for joystick events
     joystick_subscriber = nh.subscribe("/joy", 1000, &RoverGUIPlugin::joyEventHandler, this);
 
+    // All stop and all autonomous reach every rover with one message. It is not latched, a mobility node that
+    // starts later is sent its rover's current mode when it subscribes to the rover's own mode topic.
+    all_rovers_mode_publisher = nh.advertise<std_msgs::UInt8>("/allRovers/mode", 10);
+
+    // The compressed transports keep the camera from saturating the wireless link
+    ros::NodeHandle("~").param<string>("camera_transport", camera_transport, "theora");
+
+    // Sensor frames repaint at most this often however fast their topics arrive
+    float max_repaint_rate;
+    ros::NodeHandle("~").param<float>("max_repaint_rate", max_repaint_rate, 30);
+    RepaintScheduler::instance().setMaxRate(max_repaint_rate);
+
+    // Everything drawn on the map is also recorded so the run can be replayed. An empty path turns this off.
+    string run_log;
+    ros::NodeHandle("~").param<string>("run_log", run_log, ros::file_log::getLogDirectory() + "/rover_gui_map_"
+                                       + QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss").toStdString() + ".runlog");
+    if (!run_log.empty())
+    {
+        if (map_data->startRunLog(run_log))
+        {
+            run_log_path = QString::fromStdString(run_log);
+            emit sendInfoLogMessage("Recording the map to " + run_log_path);
+        }
+        else
+        {
+            emit sendInfoLogMessage("<font color=red>Could not write the map run log " + QString::fromStdString(run_log) + "</font>");
+        }
+    }
+
     emit sendInfoLogMessage("Searching for rovers...");
 
-    // Add discovered rovers to the GUI list
+    // Update the status of the rovers in the GUI list
     rover_poll_timer = new QTimer(this);
     connect(rover_poll_timer, SIGNAL(timeout()), this, SLOT(pollRoversTimerEventHandler()));
     rover_poll_timer->start(5000);
 
+    // Only runs while the profiler checkbox is ticked
+    profiler_timer = new QTimer(this);
+    connect(profiler_timer, SIGNAL(timeout()), this, SLOT(profilerTimerEventHandler()));
+
+    // Add discovered rovers to the GUI list. The ROS master is queried from a worker thread
+    // which only tells us about rovers that connected or disconnected.
+    rover_discovery_thread = new QThread(this);
+    rover_discovery = new RoverDiscovery(5000);
+    rover_discovery->moveToThread(rover_discovery_thread);
+    connect(rover_discovery_thread, SIGNAL(started()), rover_discovery, SLOT(start()));
+    connect(rover_discovery, SIGNAL(roverConnected(QString)), this, SLOT(roverConnectedEventHandler(QString)));
+    connect(rover_discovery, SIGNAL(roverDisconnected(QString)), this, SLOT(roverDisconnectedEventHandler(QString)));
+    rover_discovery_thread->start();
+
     // Setup the initial display parameters for the map
     ui.map_frame->setMapData(map_data);
     ui.map_frame->createPopoutWindow(map_data); // This has to happen before the display radio buttons are set
@@ -205,10 +264,18 @@ namespace rqt_rover_gui
 
   void RoverGUIPlugin::shutdownPlugin()
   {
+    map_data->stopRunLog(); // So the log ends with the map as it was rather than cleared
     map_data->clear(); // Clear the map and stop drawing before the map_frame is destroyed
     ui.map_frame->clear();
     clearSimulationButtonEventHandler();
     rover_poll_timer->stop();
+    profiler_timer->stop();
+
+    QMetaObject::invokeMethod(rover_discovery, "stop", Qt::BlockingQueuedConnection);
+    rover_discovery_thread->quit();
+    rover_discovery_thread->wait();
+    delete rover_discovery;
+
     stopROSJoyNode();
     ros::shutdown();
   }
@@ -225,6 +292,9 @@ void RoverGUIPlugin::restoreSettings(const qt_gui_cpp::Settings& plugin_settings
 // Receives messages from the ROS joystick driver and used them to articulate the gripper and drive the rover.
 void RoverGUIPlugin::joyEventHandler(const sensor_msgs::Joy::ConstPtr& joy_msg)
 {
+    ScopedTimer timer("joyEventHandler");
+    recordMessageAge("joyEventHandler message age", joy_msg->header.stamp);
+
      // Give the array values some helpful names:
     int left_stick_x_axis = 0; // Gripper fingers close and open
     int left_stick_y_axis = 1; // Gripper wrist up and down
@@ -337,142 +407,84 @@ void RoverGUIPlugin::joyEventHandler(const sensor_msgs::Joy::ConstPtr& joy_msg)
     }
 }
 
-void RoverGUIPlugin::EKFEventHandler(const ros::MessageEvent<const nav_msgs::Odometry> &event)
+void RoverGUIPlugin::EKFEventHandler(const nav_msgs::Odometry::ConstPtr& msg, int rover_id)
 {
-    const std::string& publisher_name = event.getPublisherName();
-    const ros::M_string& header = event.getConnectionHeader();
-    ros::Time receipt_time = event.getReceiptTime();
-
-    const boost::shared_ptr<const nav_msgs::Odometry> msg = event.getMessage();
+    ScopedTimer timer("EKFEventHandler");
+    recordMessageAge("EKFEventHandler message age", msg->header.stamp);
 
     float x = msg->pose.pose.position.x;
     float y = msg->pose.pose.position.y;
 
-    QString x_str; x_str.setNum(x);
-    QString y_str; y_str.setNum(y);
-    // Extract rover name from the message source. Publisher is in the format /*rover_name*_MAP
-    size_t found = publisher_name.find("_MAP");
-    string rover_name = publisher_name.substr(1,found-1);
-
-    // Store map info for the appropriate rover name
-    ui.map_frame->addToEKFRoverPath(rover_name, x, y);
+    // Store map info for the rover this subscriber was created for
+    ui.map_frame->addToEKFRoverPath(rover_id, x, y);
 }
 
 
-void RoverGUIPlugin::encoderEventHandler(const ros::MessageEvent<const nav_msgs::Odometry> &event)
+void RoverGUIPlugin::encoderEventHandler(const nav_msgs::Odometry::ConstPtr& msg, int rover_id)
 {
-    const std::string& publisher_name = event.getPublisherName();
-    const ros::M_string& header = event.getConnectionHeader();
-    ros::Time receipt_time = event.getReceiptTime();
+    ScopedTimer timer("encoderEventHandler");
+    recordMessageAge("encoderEventHandler message age", msg->header.stamp);
 
-    string topic = header.at("topic");
-
-    const boost::shared_ptr<const nav_msgs::Odometry> msg = event.getMessage();
     float x = msg->pose.pose.position.x;
     float y = msg->pose.pose.position.y;
 
-    QString x_str; x_str.setNum(x);
-    QString y_str; y_str.setNum(y);
-
-    // Extract rover name from the message source. Get the topic name from the event header. Can't use publisher_name here because it is just /gazebo.
-    size_t found = topic.find("/odom/filtered");
-    string rover_name = topic.substr(1,found-1);
-
-    // Store map info for the appropriate rover name
-   ui.map_frame->addToEncoderRoverPath(rover_name, x, y);
+    // Store map info for the rover this subscriber was created for
+    ui.map_frame->addToEncoderRoverPath(rover_id, x, y);
 }
 
 
-void RoverGUIPlugin::GPSEventHandler(const ros::MessageEvent<const nav_msgs::Odometry> &event)
+void RoverGUIPlugin::GPSEventHandler(const nav_msgs::Odometry::ConstPtr& msg, int rover_id)
 {
-    const std::string& publisher_name = event.getPublisherName();
-    const ros::M_string& header = event.getConnectionHeader();
-    ros::Time receipt_time = event.getReceiptTime();
+    ScopedTimer timer("GPSEventHandler");
+    recordMessageAge("GPSEventHandler message age", msg->header.stamp);
 
-    const boost::shared_ptr<const nav_msgs::Odometry> msg = event.getMessage();
     float x = msg->pose.pose.position.x;
     float y = msg->pose.pose.position.y;
 
-    QString x_str; x_str.setNum(x);
-    QString y_str; y_str.setNum(y);
-
-    // Extract rover name from the message source. Publisher is in the format /*rover_name*_NAVSAT
-    size_t found = publisher_name.find("_NAVSAT");
-    string rover_name = publisher_name.substr(1,found-1);
-
-    // Store map info for the appropriate rover name
-    ui.map_frame->addToGPSRoverPath(rover_name, x, y);
+    // Store map info for the rover this subscriber was created for
+    ui.map_frame->addToGPSRoverPath(rover_id, x, y);
 }
 
  void RoverGUIPlugin::cameraEventHandler(const sensor_msgs::ImageConstPtr& image)
  {
-     cv_bridge::CvImagePtr cv_image_ptr;
+     ScopedTimer timer("cameraEventHandler");
+     recordMessageAge("cameraEventHandler message age", image->header.stamp);
+
+     if (image->data.empty()) return;
+
+     // The rovers send 8 bit colour images. Wrap the message buffer rather than copying it,
+     // the camera frame keeps the message until it has been replaced and converts the frame
+     // to RGB only when it draws it, at the size it draws it.
+     if (image->encoding == sensor_msgs::image_encodings::BGR8 || image->encoding == sensor_msgs::image_encodings::RGB8)
+     {
+         QImage qimg(&(image->data[0]), image->width, image->height, image->step, QImage::Format_RGB888);
+         ui.camera_frame->setImage(qimg, image, image->encoding == sensor_msgs::image_encodings::BGR8);
+         return;
+     }
+
+     // Anything else has to be converted by cv_bridge first
+     cv_bridge::CvImageConstPtr cv_image_ptr;
 
      try
      {
-        cv_image_ptr = cv_bridge::toCvCopy(image);
+        cv_image_ptr = cv_bridge::toCvShare(image, sensor_msgs::image_encodings::BGR8);
      }
      catch (cv_bridge::Exception &e)
      {
          ROS_ERROR("In rover_gui_plugin.cpp: cv_bridge exception: %s", e.what());
+         return;
      }
 
-     int image_cols = cv_image_ptr->image.cols;
-     int image_rows = cv_image_ptr->image.rows;
-     int image_step = cv_image_ptr->image.step;
-
-     ostringstream cols_stream, rows_stream;
-     cols_stream << image_cols;
-     rows_stream << image_rows;
-
-     // For debugging
-     //QString debug_msg = "Received image ";
-     //debug_msg += "(" + QString::number(image_rows) + " x " + QString::number(image_cols) +")";
-     //cout << debug_msg.toStdString() << endl;
-
-    // ROS_INFO_STREAM("Image received Size:" + rows_stream.str() + "x" + cols_stream.str());
-
-     // Create QImage to hold the image
-     //const uchar* image_buffer = (const uchar*)cv_image_ptr->image.data; // extract the raw data
-     QImage qimg(&(image->data[0]), image_cols, image_rows, image_step, QImage::Format_RGB888);
-     qimg = qimg.rgbSwapped(); // Convert from RGB to BGR which is the output format for the rovers.
-     ui.camera_frame->setImage(qimg);
+     QImage qimg(cv_image_ptr->image.data, cv_image_ptr->image.cols, cv_image_ptr->image.rows, cv_image_ptr->image.step, QImage::Format_RGB888);
+     ui.camera_frame->setImage(qimg, cv_image_ptr, true);
  }
 
-set<string> RoverGUIPlugin::findConnectedRovers()
-{
-    set<string> rovers;
-
-    ros::master::V_TopicInfo master_topics;
-    ros::master::getTopics(master_topics);
-
-    stringstream ss;
-
-   for (ros::master::V_TopicInfo::iterator it = master_topics.begin() ; it != master_topics.end(); it++)
-    {
-        const ros::master::TopicInfo& info = *it;
-
-        string rover_name;
-
-        std::size_t found = info.name.find("/status");
-          if (found!=std::string::npos)
-          {
-            rover_name = info.name.substr(1,found-1);
-
-            found = rover_name.find("/"); // Eliminate potential names with / in them
-            if (found==std::string::npos)
-            {
-                rovers.insert(rover_name);
-            }
-        }
-    }
-
-    return rovers;
-}
-
 // Receives and stores the status update messages from rovers
 void RoverGUIPlugin::statusEventHandler(const ros::MessageEvent<std_msgs::String const> &event)
 {
+    ScopedTimer timer("statusEventHandler");
+    recordMessageAge("statusEventHandler queue wait", event.getReceiptTime());
+
     const ros::M_string& header = event.getConnectionHeader();
     ros::Time receipt_time = event.getReceiptTime();
 
@@ -497,6 +509,9 @@ void RoverGUIPlugin::statusEventHandler(const ros::MessageEvent<std_msgs::String
 // Counts the number of obstacle avoidance calls
 void RoverGUIPlugin::obstacleEventHandler(const ros::MessageEvent<const std_msgs::UInt8> &event)
 {
+    ScopedTimer timer("obstacleEventHandler");
+    recordMessageAge("obstacleEventHandler queue wait", event.getReceiptTime());
+
     const std::string& publisher_name = event.getPublisherName();
     const ros::M_string& header = event.getConnectionHeader();
     ros::Time receipt_time = event.getReceiptTime();
@@ -528,6 +543,7 @@ void RoverGUIPlugin::currentRoverChangedEventHandler(QListWidgetItem *current, Q
     string ui_rover_name = rover_name_and_status.substr(0, rover_name_length);
 
     selected_rover_name = ui_rover_name;
+    selected_rover_id = map_data->getRoverID(selected_rover_name);
 
     string rover_name_msg = "<font color='white'>Rover: " + selected_rover_name + "</font>";
     QString rover_name_msg_qstr = QString::fromStdString(rover_name_msg);
@@ -547,7 +563,7 @@ void RoverGUIPlugin::currentRoverChangedEventHandler(QListWidgetItem *current, Q
     
     //Set up subscribers
     image_transport::ImageTransport it(nh);
-    camera_subscriber = it.subscribe("/"+selected_rover_name+"/targets/image", 1, &RoverGUIPlugin::cameraEventHandler, this, image_transport::TransportHints("theora"));
+    camera_subscriber = it.subscribe("/"+selected_rover_name+"/targets/image", 1, &RoverGUIPlugin::cameraEventHandler, this, image_transport::TransportHints(camera_transport));
     imu_subscriber = nh.subscribe("/"+selected_rover_name+"/imu", 10, &RoverGUIPlugin::IMUEventHandler, this);
     us_center_subscriber = nh.subscribe("/"+selected_rover_name+"/sonarCenter", 10, &RoverGUIPlugin::centerUSEventHandler, this);
     us_left_subscriber = nh.subscribe("/"+selected_rover_name+"/sonarLeft", 10, &RoverGUIPlugin::leftUSEventHandler, this);
@@ -601,223 +617,204 @@ void RoverGUIPlugin::currentRoverChangedEventHandler(QListWidgetItem *current, Q
 
 void RoverGUIPlugin::pollRoversTimerEventHandler()
 {
-    // Returns rovers that have created a status topic
-    set<string>new_rover_names = findConnectedRovers();
+    ScopedTimer timer("pollRoversTimerEventHandler");
 
-    std::set<string> orphaned_rover_names;
+    // Keep the map points queued by the ROS callbacks bounded while the map is not being drawn
+    map_data->lock();
+    map_data->flushReceivedPoints();
+    map_data->unlock();
 
-    // Calculate which of the old rover names are not in the new list of rovers then clear their maps and control states.
-    std::set_difference(rover_names.begin(), rover_names.end(), new_rover_names.begin(), new_rover_names.end(),
-        std::inserter(orphaned_rover_names, orphaned_rover_names.end()));
-
-    for (set<string>::iterator it = orphaned_rover_names.begin(); it != orphaned_rover_names.end(); ++it)
+    // The list rows are in the same order as rover_names. Only rows whose status changed are updated.
+    int row = 0;
+    for(set<string>::const_iterator i = rover_names.begin(); i != rover_names.end(); ++i, ++row)
     {
-        emit sendInfoLogMessage(QString("Clearing interface data for disconnected rover ") + QString::fromStdString(*it));
-        map_data->clear(*it);
-        ui.map_frame->clear(*it);
-        rover_control_state.erase(*it); // Remove the control state for orphaned rovers
-        rover_statuses.erase(*it);
-
-        // If the currently selected rover disconnected, shutdown its subscribers and publishers
-        if (it->compare(selected_rover_name) == 0)
+        QListWidgetItem *rover_item = ui.rover_list->item(row);
+        QListWidgetItem *diags_item = ui.rover_diags_list->item(row);
+
+        RoverStatus rover_status = rover_statuses[*i];
+
+        QString rover_name_and_status = QString::fromStdString(*i) // Add the rover name
+                                                + " (" // Delimiters needed for parsing the rover name and status when read
+                                                +  QString::fromStdString(rover_status.status_msg) // Add the rover status
+                                                + ")";
+
+        if (rover_item->text() != rover_name_and_status) rover_item->setText(rover_name_and_status);
+
+        // If rovers have not sent a status message recently mark them as disconnected
+        if (ros::Time::now() - rover_status.timestamp < disconnect_threshold)
         {
-            camera_subscriber.shutdown();
-            imu_subscriber.shutdown();
-            us_center_subscriber.shutdown();
-            us_left_subscriber.shutdown();
-            us_right_subscriber.shutdown();
-            joystick_publisher.shutdown();
-
-            //Reset selected rover name to empty string
-            selected_rover_name = "";
+            if (rover_item->foreground().color() != Qt::green) rover_item->setForeground(Qt::green);
         }
+        else if (rover_item->foreground().color() != Qt::red)
+        {
+            rover_item->setForeground(Qt::red);
+	    diags_item->setForeground(Qt::red);
 
-        // For the other rovers that disconnected...
-
-        // Shutdown the subscribers
-        status_subscribers[*it].shutdown();
-        encoder_subscribers[*it].shutdown();
-        gps_subscribers[*it].shutdown();
-        ekf_subscribers[*it].shutdown();
-
-        // Delete the subscribers
-        status_subscribers.erase(*it);
-        encoder_subscribers.erase(*it);
-        gps_subscribers.erase(*it);
-        ekf_subscribers.erase(*it);
-        
-        // Shudown Publishers
-        control_mode_publishers[*it].shutdown();
-
-        // Delete Publishers
-        control_mode_publishers.erase(*it);
+	    diags_item->setText("disconnected");
+        }
     }
+}
 
-    // Wait for a rover to connect
-    if (new_rover_names.empty())
-    {
-        //displayLogMessage("Waiting for rover to connect...");
-        selected_rover_name = "";
-        rover_control_state.clear();
-        rover_names.clear();        
-        ui.rover_list->clearSelection();
-        ui.rover_list->clear();
-        ui.rover_diags_list->clear();
-        ui.map_selection_list->clear();
-
-        // Disable control mode group since no rovers are connected
-        ui.autonomous_control_radio_button->setEnabled(false);
-        ui.joystick_control_radio_button->setEnabled(false);
-        ui.all_autonomous_button->setEnabled(false);
-        ui.all_stop_button->setEnabled(false);
-        ui.all_autonomous_button->setStyleSheet("color: grey; border:2px solid grey;");
-        ui.all_stop_button->setStyleSheet("color: grey; border:2px solid grey;");
+void RoverGUIPlugin::roverConnectedEventHandler(QString rover_name)
+{
+    string rover = rover_name.toStdString();
+    if (!rover_names.insert(rover).second) return;
 
-    }
-    else if (new_rover_names == rover_names)
-    {
+    emit sendInfoLogMessage("Rover " + rover_name + " connected");
 
-        // Just update the statuses in ui rover list
-        for(int row = 0; row < ui.rover_list->count(); row++)
-        {
-            QListWidgetItem *item = ui.rover_list->item(row);
+    // The list rows are kept in the same order as rover_names
+    int row = std::distance(rover_names.begin(), rover_names.find(rover));
 
-            // Extract rover name
-            string rover_name_and_status = item->text().toStdString();
+    //Enable all autonomous button
+    ui.all_autonomous_button->setEnabled(true);
+    ui.all_autonomous_button->setStyleSheet("color: white; border:2px solid white;");
 
-            // Rover names start at the begining of the rover name and status string and end at the first space
-            size_t rover_name_length = rover_name_and_status.find_first_of(" ");
-            string ui_rover_name = rover_name_and_status.substr(0, rover_name_length);
+    // The map callbacks are told which rover they are for so they do not have to work it out from the message
+    int rover_id = map_data->registerRover(rover);
 
-            // Get current status
+    //Set up publishers
+    if (rover_id >= (int)command_channels.size()) command_channels.resize(rover_id+1);
+    // Rather than latching the last mode published to this rover, which goes stale after an all stop or all
+    // autonomous, every new subscriber is sent the rover's current mode
+    command_channels[rover_id].current_mode.reset(new std::atomic<int>(-1));
+    command_channels[rover_id].mode = nh.advertise<std_msgs::UInt8>("/"+rover+"/mode", 10,
+        boost::bind(&RoverGUIPlugin::modeSubscriberConnected, _1, command_channels[rover_id].current_mode));
+    command_channels[rover_id].joystick = nh.advertise<sensor_msgs::Joy>("/"+rover+"/joystick", 10);
 
-            RoverStatus updated_rover_status;
-            // Build new ui rover list string
-            try
-            {
-                updated_rover_status = rover_statuses.at(ui_rover_name);
-            }
-            catch (std::out_of_range& e)
-            {
-                emit sendInfoLogMessage("Error: No status entry for rover " + QString::fromStdString(ui_rover_name));
-            }
+    //Set up subscribers
+    status_subscribers[rover] = nh.subscribe("/"+rover+"/status", 10, &RoverGUIPlugin::statusEventHandler, this);
+    obstacle_subscribers[rover] = nh.subscribe("/"+rover+"/obstacle", 10, &RoverGUIPlugin::obstacleEventHandler, this);
+    encoder_subscribers[rover] = nh.subscribe<nav_msgs::Odometry>("/"+rover+"/odom/filtered", 10, boost::bind(&RoverGUIPlugin::encoderEventHandler, this, _1, rover_id));
+    ekf_subscribers[rover] = nh.subscribe<nav_msgs::Odometry>("/"+rover+"/odom/ekf", 10, boost::bind(&RoverGUIPlugin::EKFEventHandler, this, _1, rover_id));
+    gps_subscribers[rover] = nh.subscribe<nav_msgs::Odometry>("/"+rover+"/odom/navsat", 10, boost::bind(&RoverGUIPlugin::GPSEventHandler, this, _1, rover_id));
+    rover_diagnostic_subscribers[rover] = nh.subscribe("/"+rover+"/diagnostics", 10, &RoverGUIPlugin::diagnosticEventHandler, this);
 
+    RoverStatus rover_status;
+    map<string, RoverStatus>::iterator status = rover_statuses.find(rover);
+    if (status != rover_statuses.end()) rover_status = status->second;
 
-            // Build new ui rover list string
-            QString updated_rover_name_and_status = QString::fromStdString(ui_rover_name)
-                                                    + " ("
-                                                    + QString::fromStdString(updated_rover_status.status_msg)
-                                                    + ")";
+    QString rover_name_and_status = rover_name // Add the rover name
+                                            + " (" // Delimiters needed for parsing the rover name and status when read
+                                            +  QString::fromStdString(rover_status.status_msg) // Add the rover status
+                                            + ")";
 
-            // Update the UI
-            item->setText(updated_rover_name_and_status);
-        }
-    }
-    else
-    {
-    rover_names = new_rover_names;
-    
-    emit sendInfoLogMessage("List of connected rovers has changed");
-    selected_rover_name = "";
-    ui.rover_list->clearSelection();
-    ui.rover_list->clear();
-
-    // Also clear the rover diagnostics list
-    ui.rover_diags_list->clear();
-    ui.map_selection_list->clear();
-    
-    //Enable all autonomous button
-    ui.all_autonomous_button->setEnabled(true);
-    ui.all_autonomous_button->setStyleSheet("color: white; border:2px solid white;");
+    QListWidgetItem* new_item = new QListWidgetItem(rover_name_and_status);
+    new_item->setForeground(Qt::green);
+    ui.rover_list->insertItem(row, new_item);
 
-    // This code is from above. Consider moving into a function or restructuring
-    for(set<string>::const_iterator i = rover_names.begin(); i != rover_names.end(); ++i)
-    {
-        //Set up publishers
-        control_mode_publishers[*i]=nh.advertise<std_msgs::UInt8>("/"+*i+"/mode", 10, true); // last argument sets latch to true
-
-        //Set up subscribers
-        status_subscribers[*i] = nh.subscribe("/"+*i+"/status", 10, &RoverGUIPlugin::statusEventHandler, this);
-        obstacle_subscribers[*i] = nh.subscribe("/"+*i+"/obstacle", 10, &RoverGUIPlugin::obstacleEventHandler, this);
-        encoder_subscribers[*i] = nh.subscribe("/"+*i+"/odom/filtered", 10, &RoverGUIPlugin::encoderEventHandler, this);
-        ekf_subscribers[*i] = nh.subscribe("/"+*i+"/odom/ekf", 10, &RoverGUIPlugin::EKFEventHandler, this);
-        gps_subscribers[*i] = nh.subscribe("/"+*i+"/odom/navsat", 10, &RoverGUIPlugin::GPSEventHandler, this);
-        rover_diagnostic_subscribers[*i] = nh.subscribe("/"+*i+"/diagnostics", 10, &RoverGUIPlugin::diagnosticEventHandler, this);
-
-        RoverStatus rover_status;
-        // Build new ui rover list string
-        try
-        {
-            rover_status = rover_statuses.at(*i);
-        }
-        catch (std::out_of_range& e)
-        {
-            emit sendInfoLogMessage("No status entry for rover " + QString::fromStdString(*i));
-        }
+    // Create the corresponding diagnostic data listwidgetitem
+    QListWidgetItem* new_diags_item = new QListWidgetItem("");
 
-        QString rover_name_and_status = QString::fromStdString(*i) // Add the rover name
-                                                + " (" // Delimiters needed for parsing the rover name and status when read
-                                                +  QString::fromStdString(rover_status.status_msg) // Add the rover status
-                                                + ")";
+    // The user shouldn't be able to select the diagnostic output
+    new_diags_item->setFlags(new_diags_item->flags() & ~Qt::ItemIsSelectable);
 
-        QListWidgetItem* new_item = new QListWidgetItem(rover_name_and_status);
-        new_item->setForeground(Qt::green);
-        ui.rover_list->addItem(new_item);
+    ui.rover_diags_list->insertItem(row, new_diags_item);
 
-        // Create the corresponding diagnostic data listwidgetitem
-        QListWidgetItem* new_diags_item = new QListWidgetItem("");
 
-        // The user shouldn't be able to select the diagnostic output
-        new_diags_item->setFlags(new_diags_item->flags() & ~Qt::ItemIsSelectable);
+    // Add the map selection checkbox for this rover
+    QListWidgetItem* new_map_selection_item = new QListWidgetItem("");
 
-        ui.rover_diags_list->addItem(new_diags_item);
+    // set checkable but not selectable flags
+    new_map_selection_item->setFlags(new_map_selection_item->flags() | Qt::ItemIsUserCheckable);
+    new_map_selection_item->setFlags(new_map_selection_item->flags() & ~Qt::ItemIsSelectable);
+    new_map_selection_item->setCheckState(Qt::Unchecked);
 
+    // Add to the widget list
+    ui.map_selection_list->insertItem(row, new_map_selection_item);
+}
 
-        // Add the map selection checkbox for this rover
-        QListWidgetItem* new_map_selection_item = new QListWidgetItem("");
+void RoverGUIPlugin::roverDisconnectedEventHandler(QString rover_name)
+{
+    string rover = rover_name.toStdString();
+    set<string>::iterator found = rover_names.find(rover);
+    if (found == rover_names.end()) return;
 
-        // set checkable but not selectable flags
-        new_map_selection_item->setFlags(new_map_selection_item->flags() | Qt::ItemIsUserCheckable);
-        new_map_selection_item->setFlags(new_map_selection_item->flags() & ~Qt::ItemIsSelectable);
-        new_map_selection_item->setCheckState(Qt::Unchecked);
+    int row = std::distance(rover_names.begin(), found);
+    rover_names.erase(found);
 
-        // Add to the widget list
-        ui.map_selection_list->addItem(new_map_selection_item);
+    emit sendInfoLogMessage(QString("Clearing interface data for disconnected rover ") + rover_name);
 
+    // The rover keeps its ID in case it reconnects
+    int rover_id = map_data->getRoverID(rover);
+    if (rover_id >= 0)
+    {
+        map_data->clear(rover_id);
+        ui.map_frame->clear(rover_id);
     }
-    }
+    rover_control_state.erase(rover); // Remove the control state for orphaned rovers
+    rover_statuses.erase(rover);
 
-    // If rovers have not sent a status message recently mark them as disconnected
-    for(int row = 0; row < ui.rover_list->count(); row++)
+    // If the currently selected rover disconnected, shutdown its subscribers and publishers
+    if (rover.compare(selected_rover_name) == 0)
     {
-        QListWidgetItem *rover_item = ui.rover_list->item(row);
-        QListWidgetItem *diags_item = ui.rover_diags_list->item(row);
+        camera_subscriber.shutdown();
+        imu_subscriber.shutdown();
+        us_center_subscriber.shutdown();
+        us_left_subscriber.shutdown();
+        us_right_subscriber.shutdown();
+        joystick_publisher.shutdown();
+
+        //Reset selected rover name to empty string
+        selected_rover_name = "";
+        selected_rover_id = -1;
 
-        // Extract rover name
-        string rover_name_and_status = rover_item->text().toStdString();
+        // So removing its row does not select another rover
+        ui.rover_list->setCurrentItem(NULL);
+    }
 
-        // Rover names start at the begining of the rover name and status string and end at the first space
-        size_t rover_name_length = rover_name_and_status.find_first_of(" ");
-        string ui_rover_name = rover_name_and_status.substr(0, rover_name_length);
+    // Shutdown the subscribers
+    status_subscribers[rover].shutdown();
+    obstacle_subscribers[rover].shutdown();
+    encoder_subscribers[rover].shutdown();
+    gps_subscribers[rover].shutdown();
+    ekf_subscribers[rover].shutdown();
+    rover_diagnostic_subscribers[rover].shutdown();
+
+    // Delete the subscribers
+    status_subscribers.erase(rover);
+    obstacle_subscribers.erase(rover);
+    encoder_subscribers.erase(rover);
+    gps_subscribers.erase(rover);
+    ekf_subscribers.erase(rover);
+    rover_diagnostic_subscribers.erase(rover);
+
+    // Shudown Publishers, the rover keeps its channel index in case it reconnects
+    if (rover_id >= 0)
+    {
+        command_channels[rover_id].mode.shutdown();
+        command_channels[rover_id].joystick.shutdown();
+        command_channels[rover_id] = RoverCommandChannel();
+    }
 
-        // Check the time of last contact with this rover
-        RoverStatus rover_status = rover_statuses[ui_rover_name];
-        if (ros::Time::now() - rover_status.timestamp < disconnect_threshold)
-        {
-            rover_item->setForeground(Qt::green);
-        }
-        else
-        {
-            rover_item->setForeground(Qt::red);
-	    diags_item->setForeground(Qt::red);
+    // Remove the rover's rows
+    delete ui.rover_list->takeItem(row);
+    delete ui.rover_diags_list->takeItem(row);
+    delete ui.map_selection_list->takeItem(row);
 
-	    diags_item->setText("disconnected");
-        }
+    // Wait for a rover to connect
+    if (rover_names.empty())
+    {
+        //displayLogMessage("Waiting for rover to connect...");
+        selected_rover_name = "";
+        selected_rover_id = -1;
+        rover_control_state.clear();
+        ui.rover_list->clearSelection();
+
+        // Disable control mode group since no rovers are connected
+        ui.autonomous_control_radio_button->setEnabled(false);
+        ui.joystick_control_radio_button->setEnabled(false);
+        ui.all_autonomous_button->setEnabled(false);
+        ui.all_stop_button->setEnabled(false);
+        ui.all_autonomous_button->setStyleSheet("color: grey; border:2px solid grey;");
+        ui.all_stop_button->setStyleSheet("color: grey; border:2px solid grey;");
     }
 }
 
 void RoverGUIPlugin::centerUSEventHandler(const sensor_msgs::Range::ConstPtr& msg)
 {
+    ScopedTimer timer("centerUSEventHandler");
+    recordMessageAge("centerUSEventHandler message age", msg->header.stamp);
+
     // Temp hardcode max and min because setting the max and min on the controller side causes a problem
     float min_range = 0.01;; // meters
     float max_range = 3;
@@ -829,6 +826,9 @@ void RoverGUIPlugin::centerUSEventHandler(const sensor_msgs::Range::ConstPtr& ms
 
 void RoverGUIPlugin::rightUSEventHandler(const sensor_msgs::Range::ConstPtr& msg)
 {
+    ScopedTimer timer("rightUSEventHandler");
+    recordMessageAge("rightUSEventHandler message age", msg->header.stamp);
+
     // Temp hardcode max and min because setting the max and min on the controller side causes a problem
     float min_range = 0.01;
     float max_range = 3;
@@ -842,6 +842,9 @@ void RoverGUIPlugin::rightUSEventHandler(const sensor_msgs::Range::ConstPtr& msg
 
 void RoverGUIPlugin::leftUSEventHandler(const sensor_msgs::Range::ConstPtr& msg)
 {
+    ScopedTimer timer("leftUSEventHandler");
+    recordMessageAge("leftUSEventHandler message age", msg->header.stamp);
+
     // Temp hardcode max and min because setting the max and min on the controller side causes a problem
     float min_range = 0.01;;
     float max_range = 3;
@@ -853,6 +856,9 @@ void RoverGUIPlugin::leftUSEventHandler(const sensor_msgs::Range::ConstPtr& msg)
 
 void RoverGUIPlugin::IMUEventHandler(const sensor_msgs::Imu::ConstPtr& msg)
 {
+    ScopedTimer timer("IMUEventHandler");
+    recordMessageAge("IMUEventHandler message age", msg->header.stamp);
+
     ui.imu_frame->setLinearAcceleration( msg->linear_acceleration.x,
                                          msg->linear_acceleration.y,
                                          msg->linear_acceleration.z );
@@ -878,6 +884,9 @@ void RoverGUIPlugin::IMUEventHandler(const sensor_msgs::Imu::ConstPtr& msg)
 // than continual data readings.
 void RoverGUIPlugin::diagnosticEventHandler(const ros::MessageEvent<const std_msgs::Float32MultiArray> &event) {
 
+    ScopedTimer timer("diagnosticEventHandler");
+    recordMessageAge("diagnosticEventHandler queue wait", event.getReceiptTime());
+
     const std::string& publisher_name = event.getPublisherName();
     const ros::M_string& header = event.getConnectionHeader();
     ros::Time receipt_time = event.getReceiptTime();
@@ -970,6 +979,23 @@ void RoverGUIPlugin::diagnosticEventHandler(const ros::MessageEvent<const std_ms
 
         diagnostic_display += " | " + rate_str + " " + units;
 
+        // Serial bridge health reported through the diagnostics node by abridge
+        if (msg->data.size() >= 7)
+        {
+            int telemetry_rate = static_cast<int>(msg->data[3] + 0.5); // Telemetry frames per second
+            int drop_percent = static_cast<int>(msg->data[4] + 0.5); // Percent of telemetry frames dropped
+            int latency = static_cast<int>(msg->data[5] + 0.5); // 95th percentile telemetry latency in ms
+
+            diagnostic_display += " | " + to_string(telemetry_rate) + " Hz " + to_string(drop_percent) + "% drop " + to_string(latency) + " ms";
+
+            // Show the problem in the text colour if the bridge is dropping frames
+            if (drop_percent > 10)
+            {
+                red = 255;
+                green = 0;
+            }
+        }
+
     }
     else
     {
@@ -1021,7 +1047,7 @@ void RoverGUIPlugin::mapSelectionListItemChangedHandler(QListWidgetItem* changed
 
     emit sendInfoLogMessage("Map selection changed to " + (checked ? QString("true") : QString("false")) + " for rover " + QString::fromStdString(ui_rover_name));
 
-    ui.map_frame->setWhetherToDisplay(ui_rover_name, checked);
+    ui.map_frame->setWhetherToDisplay(map_data->getRoverID(ui_rover_name), checked);
 }
 
 void RoverGUIPlugin::GPSCheckboxToggledEventHandler(bool checked)
@@ -1041,6 +1067,8 @@ void RoverGUIPlugin::encoderCheckboxToggledEventHandler(bool checked)
 
 void RoverGUIPlugin::displayDiagLogMessage(QString msg)
 {
+    ScopedTimer timer("displayDiagLogMessage");
+
     if (msg.isEmpty()) msg = "Message is empty";
     if (msg == NULL) msg = "Message was a NULL pointer";
 
@@ -1063,6 +1091,8 @@ void RoverGUIPlugin::displayDiagLogMessage(QString msg)
 
 void RoverGUIPlugin::displayInfoLogMessage(QString msg)
 {
+    ScopedTimer timer("displayInfoLogMessage");
+
     if (msg.isEmpty()) msg = "Message is empty";
     if (msg == NULL) msg = "Message was a NULL pointer";
 
@@ -1103,12 +1133,15 @@ void RoverGUIPlugin::autonomousRadioButtonEventHandler(bool marked)
 {
     if (!marked) return;
 
+    // Selecting a rover or all autonomous calls this again for a rover already in autonomous mode
+    bool changed = rover_control_state[selected_rover_name] != 2;
     rover_control_state[selected_rover_name] = 2;
 
     std_msgs::UInt8 control_mode_msg;
     control_mode_msg.data = 2; // 2 indicates autonomous control
 
-    control_mode_publishers[selected_rover_name].publish(control_mode_msg);
+    setChannelMode(selected_rover_id, 2);
+    if (changed && selected_rover_id >= 0) command_channels[selected_rover_id].mode.publish(control_mode_msg);
     emit sendInfoLogMessage(QString::fromStdString(selected_rover_name)+" changed to autonomous control");
 
     QString return_msg = stopROSJoyNode();
@@ -1126,11 +1159,13 @@ void RoverGUIPlugin::joystickRadioButtonEventHandler(bool marked)
 {
     if (!marked) return;
 
+    // Selecting a rover or all stop calls this again for a rover already in manual mode
+    bool changed = rover_control_state[selected_rover_name] != 1;
     rover_control_state[selected_rover_name] = 1;
     emit sendInfoLogMessage("Setting up joystick publisher " + QString::fromStdString("/"+selected_rover_name+"/joystick"));
 
-    // Setup joystick publisher
-    joystick_publisher = nh.advertise<sensor_msgs::Joy>("/"+selected_rover_name+"/joystick", 10, this);
+    // Drive the rover through the joystick channel advertised when it connected
+    if (selected_rover_id >= 0) joystick_publisher = command_channels[selected_rover_id].joystick;
 
     // Setup Gripper publishers
 
@@ -1151,7 +1186,8 @@ void RoverGUIPlugin::joystickRadioButtonEventHandler(bool marked)
     std_msgs::UInt8 control_mode_msg;
     control_mode_msg.data = 1; // 1 indicates manual control
 
-    control_mode_publishers[selected_rover_name].publish(control_mode_msg);
+    setChannelMode(selected_rover_id, 1);
+    if (changed && selected_rover_id >= 0) command_channels[selected_rover_id].mode.publish(control_mode_msg);
     emit sendInfoLogMessage(QString::fromStdString(selected_rover_name)+" changed to joystick control");\
 
     QString return_msg = startROSJoyNode();
@@ -1165,33 +1201,57 @@ void RoverGUIPlugin::joystickRadioButtonEventHandler(bool marked)
     ui.joystick_frame->setHidden(false);
 }
 
-void RoverGUIPlugin::allAutonomousButtonEventHandler()
+void RoverGUIPlugin::publishModeToAllRovers(int mode)
 {
-    emit sendInfoLogMessage("changing all rovers to autonomous control...");
+    std_msgs::UInt8 control_mode_msg;
+    control_mode_msg.data = mode;
+
+    // Set before publishing so a mobility node that subscribes meanwhile is sent the new mode
+    for (size_t i = 0; i < command_channels.size(); i++)
+    {
+        setChannelMode(i, mode);
+    }
 
-    std::string remember_selected_rover_name = selected_rover_name;
-    int remember_selected_index = ui.rover_list->currentRow();
-    int selected_index = -1; // zero array indexing, ensure last selected index is in range
+    all_rovers_mode_publisher.publish(control_mode_msg);
 
-    // manually trigger the autonomous radio button event for all rovers
     for (set<string>::iterator it = rover_names.begin(); it != rover_names.end(); it++)
     {
-        selected_index++;
-        selected_rover_name = *it;
-        autonomousRadioButtonEventHandler(true);
+        rover_control_state[*it] = mode;
     }
+}
+
+// Disconnected rovers have no channel
+void RoverGUIPlugin::setChannelMode(int rover_id, int mode)
+{
+    if (rover_id < 0 || rover_id >= (int)command_channels.size() || !command_channels[rover_id].current_mode) return;
+
+    command_channels[rover_id].current_mode->store(mode);
+}
+
+void RoverGUIPlugin::modeSubscriberConnected(const ros::SingleSubscriberPublisher& subscriber, boost::shared_ptr< std::atomic<int> > mode)
+{
+    int current_mode = mode->load();
+    if (current_mode < 0) return;
+
+    std_msgs::UInt8 control_mode_msg;
+    control_mode_msg.data = current_mode;
+    subscriber.publish(control_mode_msg);
+}
 
-    // trigger the current rover changed event:
-    // if we previously selected a rover, keep that rover selected
-    if (remember_selected_index >= 0)
+void RoverGUIPlugin::allAutonomousButtonEventHandler()
+{
+    emit sendInfoLogMessage("changing all rovers to autonomous control...");
+
+    publishModeToAllRovers(2); // 2 indicates autonomous control
+
+    // Update the controls for the selected rover, or select the last rover if none is
+    if (ui.rover_list->currentRow() >= 0)
     {
-        selected_rover_name = remember_selected_rover_name;
-        ui.rover_list->setCurrentItem(ui.rover_list->item(remember_selected_index));
+        autonomousRadioButtonEventHandler(true);
     }
-    // otherwise, default to the last rover in the rover list
     else
     {
-        ui.rover_list->setCurrentItem(ui.rover_list->item(selected_index));
+        ui.rover_list->setCurrentItem(ui.rover_list->item(ui.rover_list->count()-1));
     }
 
     ui.joystick_control_radio_button->setEnabled(true);
@@ -1209,29 +1269,16 @@ void RoverGUIPlugin::allStopButtonEventHandler()
 {
     emit sendInfoLogMessage("changing all rovers to manual control...");
 
-    std::string remember_selected_rover_name = selected_rover_name;
-    int remember_selected_index = ui.rover_list->currentRow();
-    int selected_index = -1; // zero array indexing, ensure last selected index is in range
+    publishModeToAllRovers(1); // 1 indicates manual control
 
-    // manually trigger the manual radio button event for all rovers
-    for (set<string>::iterator it = rover_names.begin(); it != rover_names.end(); it++)
+    // Only the selected rover is driven by the joystick. If none is selected the last rover is.
+    if (ui.rover_list->currentRow() >= 0)
     {
-        selected_index++;
-        selected_rover_name = *it;
         joystickRadioButtonEventHandler(true);
     }
-
-    // trigger the current rover changed event:
-    // if we previously selected a rover, keep that rover selected
-    if (remember_selected_index >= 0)
-    {
-        selected_rover_name = remember_selected_rover_name;
-        ui.rover_list->setCurrentItem(ui.rover_list->item(remember_selected_index));
-    }
-    // otherwise, default to the last rover in the rover list
     else
     {
-        ui.rover_list->setCurrentItem(ui.rover_list->item(selected_index));
+        ui.rover_list->setCurrentItem(ui.rover_list->item(ui.rover_list->count()-1));
     }
 
     ui.joystick_control_radio_button->setEnabled(true);
@@ -1289,6 +1336,31 @@ void RoverGUIPlugin::mapPopoutButtonEventHandler()
     ui.map_frame->popout();
 }
 
+void RoverGUIPlugin::mapReplayButtonEventHandler()
+{
+    QString directory = run_log_path.isEmpty() ? QDir::homePath() : QFileInfo(run_log_path).path();
+    QString path = QFileDialog::getOpenFileName(widget, tr("Replay Run Log"), directory, tr("Run Log (*.runlog)"));
+    if (path.isEmpty()) return;
+
+    // Closes with the GUI, and is deleted when it is closed
+    ReplayWindow* replay_window = new ReplayWindow(widget);
+    replay_window->setAttribute(Qt::WA_DeleteOnClose);
+
+    if (!replay_window->open(path))
+    {
+        delete replay_window;
+        emit sendInfoLogMessage("<font color=red>" + path + " is not a run log</font>");
+        return;
+    }
+
+    replay_window->setDisplayGPSData(ui.gps_checkbox->isChecked());
+    replay_window->setDisplayEncoderData(ui.encoder_checkbox->isChecked());
+    replay_window->setDisplayEKFData(ui.ekf_checkbox->isChecked());
+    replay_window->show();
+
+    emit sendInfoLogMessage("Replaying " + path);
+}
+
 void RoverGUIPlugin::buildSimulationButtonEventHandler()
 {
     emit sendInfoLogMessage("Building simulation...");
@@ -1309,15 +1381,18 @@ void RoverGUIPlugin::buildSimulationButtonEventHandler()
     connect(sim_server_process, SIGNAL(finished(int)), this, SLOT(gazeboServerFinishedEventHandler()));
 
 
+    // The walls, ground plane, collection disk and rovers are queued here and spawned in one batch below
     if (ui.final_radio_button->isChecked())
     {
          arena_dim = 23.1;
-         addFinalsWalls();
+         emit sendInfoLogMessage("Adding final round walls...");
+         ArenaLayout(sim_mgr, arena_dim).queueWalls("barrier_final_round");
     }
     else
     {
         arena_dim = 15;
-        addPrelimsWalls();
+        emit sendInfoLogMessage("Adding preliminary round walls...");
+        ArenaLayout(sim_mgr, arena_dim).queueWalls("barrier_prelim_round");
     }
 
     emit sendInfoLogMessage(QString("Set arena size to ")+QString::number(arena_dim)+"x"+QString::number(arena_dim));
@@ -1325,20 +1400,17 @@ void RoverGUIPlugin::buildSimulationButtonEventHandler()
     if (ui.texture_combobox->currentText() == "Gravel")
     {
     emit sendInfoLogMessage("Adding gravel ground plane...");
-    return_msg = sim_mgr.addGroundPlane("mars_ground_plane");
-    emit sendInfoLogMessage(return_msg);
+    sim_mgr.queueGroundPlane("mars_ground_plane");
     }
     else if (ui.texture_combobox->currentText() == "KSC Concrete")
     {
     emit sendInfoLogMessage("Adding concrete ground plane...");
-    return_msg = sim_mgr.addGroundPlane("concrete_ground_plane");
-    emit sendInfoLogMessage(return_msg);
+    sim_mgr.queueGroundPlane("concrete_ground_plane");
     }
     else if (ui.texture_combobox->currentText() == "Car park")
     {
     emit sendInfoLogMessage("Adding carpark ground plane...");
-    return_msg = sim_mgr.addGroundPlane("carpark_ground_plane");
-    emit sendInfoLogMessage(return_msg);
+    sim_mgr.queueGroundPlane("carpark_ground_plane");
     }
     else
     {
@@ -1348,9 +1420,8 @@ void RoverGUIPlugin::buildSimulationButtonEventHandler()
 
     emit sendInfoLogMessage("Adding collection disk...");
     float collection_disk_radius = 0.5; // meters
-    sim_mgr.addModel("collection_disk", "collection_disk", 0, 0, 0, collection_disk_radius);
+    sim_mgr.queueModel("collection_disk", "collection_disk", 0, 0, 0, collection_disk_radius);
 
-    int n_rovers_created = 0;
     int n_rovers = 3;
     if (ui.final_radio_button->isChecked()) n_rovers = 6;
 
@@ -1358,7 +1429,7 @@ void RoverGUIPlugin::buildSimulationButtonEventHandler()
     if (ui.override_num_rovers_checkbox->isChecked()) n_rovers = ui.custom_num_rovers_combobox->currentText().toInt();
 
     QProgressDialog progress_dialog;
-    progress_dialog.setWindowTitle("Creating rovers");
+    progress_dialog.setWindowTitle("Building the arena and rovers");
     progress_dialog.setCancelButton(NULL); // no cancel button
     progress_dialog.setWindowModality(Qt::ApplicationModal);
     progress_dialog.setWindowFlags(progress_dialog.windowFlags() | Qt::WindowStaysOnTopHint);
@@ -1368,19 +1439,23 @@ void RoverGUIPlugin::buildSimulationButtonEventHandler()
     QString rovers[6] = {"achilles", "aeneas", "ajax", "diomedes", "hector", "paris"};
     QPoint rover_positions[6] = {QPoint(0,1), QPoint(1,1), QPoint(1,0), QPoint(-1,0), QPoint(0,-1), QPoint(-1,-1)};
 
-    // Add rovers to the simulation and start the associated ROS nodes
+    // Add all the rovers to the simulation in the same batch as the arena
     for (int i = 0; i < n_rovers; i++)
     {
         emit sendInfoLogMessage("Adding rover "+rovers[i]+"...");
-        return_msg = sim_mgr.addRover(rovers[i], rover_positions[i].x(), rover_positions[i].y(), 0);
-        emit sendInfoLogMessage(return_msg);
+        sim_mgr.queueRover(rovers[i], rover_positions[i].x(), rover_positions[i].y(), 0);
+    }
 
+    return_msg = spawnQueuedModels(progress_dialog);
+    emit sendInfoLogMessage(return_msg);
+
+    // Start the associated ROS nodes. The launch processes run alongside each other so the rovers
+    // come up together rather than one after another.
+    for (int i = 0; i < n_rovers; i++)
+    {
         emit sendInfoLogMessage("Starting rover node for "+rovers[i]+"...");
         return_msg = sim_mgr.startRoverNode(rovers[i]);
         emit sendInfoLogMessage(return_msg);
-
-        progress_dialog.setValue((++n_rovers_created)*100.0f/n_rovers);
-        qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
     }
 
    if (ui.powerlaw_distribution_radio_button->isChecked())
@@ -1447,19 +1522,31 @@ void RoverGUIPlugin::clearSimulationButtonEventHandler()
     progress_dialog.show();
 
     QString return_msg;
-    float count = 0.0f;
 
-    // Make a copy of the rover names because stopRoverNode will cause the original set to change
-    set<string> rover_names_copy = rover_names;
+    // Make a copy of the rover names because stopping the rover nodes will cause the original set to change
+    QList<QString> rover_names_copy;
+    for(set<string>::const_iterator i = rover_names.begin(); i != rover_names.end(); ++i) rover_names_copy << QString::fromStdString(*i);
+
+    // The rovers are shut down in parallel so this takes as long as the slowest rover
+    QFuture<QString> node_shutdowns = sim_mgr.stopRoverNodes(rover_names_copy);
+
+    while (!node_shutdowns.isFinished())
+    {
+        if (node_shutdowns.progressMaximum() > 0) progress_dialog.setValue(node_shutdowns.progressValue()*100.0f/node_shutdowns.progressMaximum());
+        qApp->processEvents(QEventLoop::ExcludeUserInputEvents, 50);
+        usleep(20000);
+    }
 
-    for(set<string>::const_iterator i = rover_names_copy.begin(); i != rover_names_copy.end(); ++i)
+    QList<QString> node_shutdown_msgs = node_shutdowns.results();
+    for (int i = 0; i < node_shutdown_msgs.size(); i++)
     {
-        return_msg += sim_mgr.stopRoverNode(QString::fromStdString(*i));
+        return_msg += node_shutdown_msgs[i];
         return_msg += "<br>";
-        progress_dialog.setValue((++count)*100.0f/rover_names_copy.size());
-        qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
     }
 
+    return_msg += sim_mgr.stopRoverProcesses();
+    progress_dialog.setValue(100);
+
     // Unsubscribe from topics
 
     emit sendInfoLogMessage("Shutting down subscribers...");
@@ -1487,8 +1574,12 @@ void RoverGUIPlugin::clearSimulationButtonEventHandler()
 
     emit sendInfoLogMessage("Shutting down publishers...");
 
-    for (map<string,ros::Publisher>::iterator it=control_mode_publishers.begin(); it!=control_mode_publishers.end(); ++it) it->second.shutdown();
-    control_mode_publishers.clear();
+    for (size_t i = 0; i < command_channels.size(); i++)
+    {
+        command_channels[i].mode.shutdown();
+        command_channels[i].joystick.shutdown();
+        command_channels[i] = RoverCommandChannel();
+    }
 
     return_msg += sim_mgr.stopGazeboClient();
     return_msg += "<br>";
@@ -1587,40 +1678,16 @@ QString RoverGUIPlugin::addUniformTargets()
     progress_dialog.setWindowTitle("Placing 256 Targets");
     progress_dialog.setCancelButton(NULL); // no cancel button
     progress_dialog.setWindowModality(Qt::ApplicationModal);
-    progress_dialog.resize(500, 50);
     progress_dialog.setWindowFlags(progress_dialog.windowFlags() | Qt::WindowStaysOnTopHint);
+    progress_dialog.resize(500, 50);
     progress_dialog.show();
 
-    QString output;
-
-    float proposed_x;
-    float proposed_y;
-
-    // 256 piles of 1 tag
-
-    // d is the distance from the center of the arena to the boundary minus the barrier clearance, i.e. the region where tags can be placed
-    // is d - U(0,2d) where U(a,b) is a uniform distribition bounded by a and b.
-    // (before checking for collisions including the collection disk at the center)
-    float d = arena_dim/2.0-(barrier_clearance+target_cluster_size_1_clearance);
-
     progress_dialog.setValue(0.0);
     qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
 
-    for (int i = 0; i < 256; i++)
-    {
-        do
-        {
-            emit sendInfoLogMessage("Tried to place target "+QString::number(0)+" at " + QString::number(proposed_x) + " " + QString::number(proposed_y) + "...");
-            proposed_x = d - ((float) rand()) / RAND_MAX*2*d;
-            proposed_y = d - ((float) rand()) / RAND_MAX*2*d;
-        }
-        while (sim_mgr.isLocationOccupied(proposed_x, proposed_y, target_cluster_size_1_clearance));
+    ArenaLayout(sim_mgr, arena_dim).queueUniformTargets();
 
-        emit sendInfoLogMessage("<font color=green>Succeeded.</font>");
-        output = sim_mgr.addModel(QString("at")+QString::number(0),  QString("at")+QString::number(i), proposed_x, proposed_y, 0, target_cluster_size_1_clearance);
-        progress_dialog.setValue(i*100.0f/256);
-        qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
-    }
+    QString output = spawnQueuedModels(progress_dialog);
 
     emit sendInfoLogMessage("Placed 256 single targets");
 
@@ -1637,46 +1704,12 @@ QString RoverGUIPlugin::addClusteredTargets()
     progress_dialog.resize(500, 50);
     progress_dialog.show();
 
-    QString output;
-
-    float proposed_x, proposed_x2;
-    float proposed_y, proposed_y2;
-
-    float d = arena_dim/2.0-(barrier_clearance+target_cluster_size_64_clearance);
-    int cube_index = 0;
-
     progress_dialog.setValue(0.0);
     qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
 
-    // Four piles of 64
-    for (int i = 0; i < 4; i++)
-    {
-        do
-        {
-            emit sendInfoLogMessage("Tried to place cluster "+QString::number(i)+" at " + QString::number(proposed_x) + " " + QString::number(proposed_y));
-            proposed_x = d - ((float) rand()) / RAND_MAX*2*d;
-            proposed_y = d - ((float) rand()) / RAND_MAX*2*d;
-        }
-        while (sim_mgr.isLocationOccupied(proposed_x, proposed_y, target_cluster_size_64_clearance));
+    ArenaLayout(sim_mgr, arena_dim).queueClusteredTargets();
 
-        proposed_y2 = proposed_y - (target_cluster_size_1_clearance * 8);
-
-        for(int j = 0; j < 8; j++) {
-            proposed_x2 = proposed_x - (target_cluster_size_1_clearance * 8);
-
-            for(int k = 0; k < 8; k++) {
-                output += sim_mgr.addModel(QString("at")+QString::number(0),  QString("at")+QString::number(cube_index), proposed_x2, proposed_y2, 0, target_cluster_size_1_clearance);
-                proposed_x2 += target_cluster_size_1_clearance;
-                cube_index++;
-                progress_dialog.setValue(cube_index*100.0f/256);
-                qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
-            }
-
-            proposed_y2 += target_cluster_size_1_clearance;
-        }
-
-        emit sendInfoLogMessage("<font color=green>Succeeded.</font>");
-    }
+    QString output = spawnQueuedModels(progress_dialog);
 
     emit sendInfoLogMessage("Placed four clusters of 64 targets");
 
@@ -1693,196 +1726,33 @@ QString RoverGUIPlugin::addPowerLawTargets()
     progress_dialog.resize(500, 50);
     progress_dialog.show();
 
-
-    float total_number_of_clusters = 85;
-    float clusters_placed = 0;
-    int cube_index = 0;
-
-    QString output = "";
-
-    float proposed_x, proposed_x2;
-    float proposed_y, proposed_y2;
-
-    float d = arena_dim/2.0-(barrier_clearance+target_cluster_size_64_clearance);
-
     progress_dialog.setValue(0.0);
     qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
 
-    // One pile of 64
-    do
-    {
-        emit sendInfoLogMessage("Tried to place cluster "+QString::number(clusters_placed)+" at " + QString::number(proposed_x) + " " + QString::number(proposed_y));
-        proposed_x = d - ((float) rand()) / RAND_MAX*2*d;
-        proposed_y = d - ((float) rand()) / RAND_MAX*2*d;
-    }
-    while (sim_mgr.isLocationOccupied(proposed_x, proposed_y, target_cluster_size_64_clearance));
-
-    proposed_y2 = proposed_y - (target_cluster_size_1_clearance * 8);
-
-    for(int j = 0; j < 8; j++) {
-        proposed_x2 = proposed_x - (target_cluster_size_1_clearance * 8);
-
-        for(int k = 0; k < 8; k++) {
-            output += sim_mgr.addModel(QString("at")+QString::number(0),  QString("at")+QString::number(cube_index), proposed_x2, proposed_y2, 0, target_cluster_size_1_clearance);
-            proposed_x2 += target_cluster_size_1_clearance;
-            cube_index++;
-            progress_dialog.setValue(cube_index*100.0f/256);
-            qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
-        }
-
-        proposed_y2 += target_cluster_size_1_clearance;
-    }
-
-    emit sendInfoLogMessage("<font color=green>Succeeded.</font>");
-    d = arena_dim/2.0-(barrier_clearance+target_cluster_size_16_clearance);
-
-    // Four piles of 16
-    for (int i = 0; i < 4; i++)
-    {
-        do
-        {
-            proposed_x = d - ((float) rand()) / RAND_MAX*2*d;
-            proposed_y = d - ((float) rand()) / RAND_MAX*2*d;
-            emit sendInfoLogMessage("Tried to place cluster "+QString::number(clusters_placed)+" at " + QString::number(proposed_x) + " " + QString::number(proposed_y));
-        }
-        while (sim_mgr.isLocationOccupied(proposed_x, proposed_y, target_cluster_size_16_clearance));
-
-        proposed_y2 = proposed_y - (target_cluster_size_1_clearance * 4);
+    ArenaLayout(sim_mgr, arena_dim).queuePowerLawTargets();
 
-        for(int j = 0; j < 4; j++) {
-            proposed_x2 = proposed_x - (target_cluster_size_1_clearance * 4);
-
-            for(int k = 0; k < 4; k++) {
-                output += sim_mgr.addModel(QString("at")+QString::number(0),  QString("at")+QString::number(cube_index), proposed_x2, proposed_y2, 0, target_cluster_size_1_clearance);
-                proposed_x2 += target_cluster_size_1_clearance;
-                cube_index++;
-                progress_dialog.setValue(cube_index*100.0f/256);
-                qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
-            }
-
-            proposed_y2 += target_cluster_size_1_clearance;
-        }
-
-        emit sendInfoLogMessage("<font color=green>Succeeded.</font>");
-    }
-
-    d = arena_dim/2.0-(barrier_clearance+target_cluster_size_4_clearance);
-
-    // Sixteen piles of 4
-    for (int i = 0; i < 16; i++)
-    {
-        do
-        {
-            emit sendInfoLogMessage("Tried to place cluster "+QString::number(clusters_placed)+" at " + QString::number(proposed_x) + " " + QString::number(proposed_y));
-            proposed_x = d - ((float) rand()) / RAND_MAX*2*d;
-            proposed_y = d - ((float) rand()) / RAND_MAX*2*d;
-        }
-        while (sim_mgr.isLocationOccupied(proposed_x, proposed_y, target_cluster_size_4_clearance));
-
-        proposed_y2 = proposed_y - (target_cluster_size_1_clearance * 2);
-
-        for(int j = 0; j < 2; j++) {
-            proposed_x2 = proposed_x - (target_cluster_size_1_clearance * 2);
-
-            for(int k = 0; k < 2; k++) {
-                output += sim_mgr.addModel(QString("at")+QString::number(0),  QString("at")+QString::number(cube_index), proposed_x2, proposed_y2, 0, target_cluster_size_1_clearance);
-                proposed_x2 += target_cluster_size_1_clearance;
-                cube_index++;
-                progress_dialog.setValue(cube_index*100.0f/256);
-                qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
-            }
-
-            proposed_y2 += target_cluster_size_1_clearance;
-        }
-
-        emit sendInfoLogMessage("<font color=green>Succeeded.</font>");
-    }
-
-    d = arena_dim/2.0-(barrier_clearance+target_cluster_size_1_clearance);
-
-    // Sixty-four piles of 1 (using tags 192 through 255 to avoid duplication with piles above)
-    for (int i = 192; i < 256; i++)
-    {
-        do
-        {
-            emit sendInfoLogMessage("Tried to place target "+QString::number(clusters_placed)+" at " + QString::number(proposed_x) + " " + QString::number(proposed_y));
-            proposed_x = d - ((float) rand()) / RAND_MAX*2*d;
-            proposed_y = d - ((float) rand()) / RAND_MAX*2*d;
-        }
-        while (sim_mgr.isLocationOccupied(proposed_x, proposed_y, target_cluster_size_1_clearance));
-
-        progress_dialog.setValue(i*100.0f/256);
-        qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
-        emit sendInfoLogMessage("<font color=green>Succeeded.</font>");
-        output+= sim_mgr.addModel(QString("at")+QString::number(0), QString("at")+QString::number(i), proposed_x, proposed_y, 0, target_cluster_size_1_clearance);
-    }
+    QString output = spawnQueuedModels(progress_dialog);
 
     return output;
 }
 
-// Add a cinder block wall to the simulation
-QString RoverGUIPlugin::addFinalsWalls()
-{
-    QProgressDialog progress_dialog;
-    progress_dialog.setWindowTitle("Placing Barriers");
-    progress_dialog.setCancelButton(NULL); // no cancel button
-    progress_dialog.setWindowModality(Qt::ApplicationModal);
-    progress_dialog.setWindowFlags(progress_dialog.windowFlags() | Qt::WindowStaysOnTopHint);
-    progress_dialog.resize(500, 50);
-    progress_dialog.show();
-
-    QString output;
-
-    // Setting wall clearance to zero - radius of a wall does not make sense. Barrier clearance values ensure models are not placed on the walls.
-    output += sim_mgr.addModel("barrier_final_round", "Barrier_West", -arena_dim/2, 0, 0, 0 );
-    progress_dialog.setValue(1*100.0f/4);
-    qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
-
-   output += sim_mgr.addModel("barrier_final_round", "Barrier_North", 0, -arena_dim/2, 0, 0, 0, M_PI/2, 0);
-       progress_dialog.setValue(2*100.0f/4);
-       qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
-
-   output += sim_mgr.addModel("barrier_final_round", "Barrier_East", arena_dim/2, 0, 0, 0 );
-       progress_dialog.setValue(3*100.0f/4);
-       qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
-
-   output += sim_mgr.addModel("barrier_final_round", "Barrier_South", 0, arena_dim/2, 0, 0, 0, M_PI/2, 0);
-       progress_dialog.setValue(4*100.0f/4);
-       qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
-
-   return output;
-}
-
-QString RoverGUIPlugin::addPrelimsWalls()
+// Spawns the models queued with the simulation manager, such as the rovers or the targets placed by
+// the add*Targets functions, in one batch. The spawning happens on a worker thread so this only keeps
+// the progress dialog and the rest of the GUI up to date while it waits.
+QString RoverGUIPlugin::spawnQueuedModels(QProgressDialog& progress_dialog)
 {
-    QProgressDialog progress_dialog;
-    progress_dialog.setWindowTitle("Placing Barriers");
-    progress_dialog.setCancelButton(NULL); // no cancel button
-    progress_dialog.setWindowModality(Qt::ApplicationModal);
-    progress_dialog.setWindowFlags(progress_dialog.windowFlags() | Qt::WindowStaysOnTopHint);
-    progress_dialog.resize(500, 50);
-    progress_dialog.show();
-
-    // Setting wall clearance to zero - radius of a wall does not make sense. Barrier clearance values ensure models are not placed on the walls.
-
-   QString output;
-   output += sim_mgr.addModel("barrier_prelim_round", "Barrier_West", -arena_dim/2, 0, 0, 0 );
-   progress_dialog.setValue(1*100.0f/4);
-   qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
-
-   output += sim_mgr.addModel("barrier_prelim_round", "Barrier_North", 0, -arena_dim/2, 0, 0, 0, M_PI/2, 0);
-   progress_dialog.setValue(2*100.0f/4);
-   qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
+    QFuture<QString> spawn = sim_mgr.spawnQueuedModels();
 
-   output += sim_mgr.addModel("barrier_prelim_round", "Barrier_East", arena_dim/2, 0, 0, 0 );
-   progress_dialog.setValue(3*100.0f/4);
-   qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
+    while (!spawn.isFinished())
+    {
+        progress_dialog.setValue(sim_mgr.getSpawnProgress()*100.0f);
+        qApp->processEvents(QEventLoop::ExcludeUserInputEvents, 50);
+        usleep(20000);
+    }
 
-   output += sim_mgr.addModel("barrier_prelim_round", "Barrier_South", 0, arena_dim/2, 0, 0, 0, M_PI/2, 0);
-   progress_dialog.setValue(4*100.0f/4);
-   qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
+    progress_dialog.setValue(100);
 
-   return output;
+    return spawn.result();
 }
 
 void RoverGUIPlugin::checkAndRepositionRover(QString rover_name, float x, float y)
@@ -2213,6 +2083,9 @@ void RoverGUIPlugin::receiveDiagLogMessage(QString msg)
 
 void RoverGUIPlugin::infoLogMessageEventHandler(const ros::MessageEvent<std_msgs::String const>& event)
 {
+    ScopedTimer timer("infoLogMessageEventHandler");
+    recordMessageAge("infoLogMessageEventHandler queue wait", event.getReceiptTime());
+
     const std::string& publisher_name = event.getPublisherName();
     const ros::M_string& header = event.getConnectionHeader();
     ros::Time receipt_time = event.getReceiptTime();
@@ -2229,6 +2102,9 @@ void RoverGUIPlugin::infoLogMessageEventHandler(const ros::MessageEvent<std_msgs
 
 void RoverGUIPlugin::diagLogMessageEventHandler(const ros::MessageEvent<std_msgs::String const>& event)
 {
+    ScopedTimer timer("diagLogMessageEventHandler");
+    recordMessageAge("diagLogMessageEventHandler queue wait", event.getReceiptTime());
+
     const std::string& publisher_name = event.getPublisherName();
     const ros::M_string& header = event.getConnectionHeader();
     ros::Time receipt_time = event.getReceiptTime();
@@ -2247,9 +2123,48 @@ void RoverGUIPlugin::overrideNumRoversCheckboxToggledEventHandler(bool checked)
     else ui.custom_num_rovers_combobox->setStyleSheet("color: grey; border:1px solid grey;");
 }
 
+void RoverGUIPlugin::profilerCheckboxToggledEventHandler(bool checked)
+{
+    GUIProfiler::instance().setEnabled(checked);
+
+    if (checked)
+    {
+        // Start from a clean slate so the figures only cover the time being looked at
+        GUIProfiler::instance().clear();
+        profiler_timer->start(1000);
+        emit sendInfoLogMessage("Profiling the GUI callbacks and paint events");
+    }
+    else
+    {
+        profiler_timer->stop();
+        emit sendInfoLogMessage("Stopped profiling the GUI");
+    }
+}
+
+void RoverGUIPlugin::profilerTimerEventHandler()
+{
+    // Keep the scroll position so the table can be read while it updates
+    int scroll = ui.profiler_log->verticalScrollBar()->value();
+    ui.profiler_log->setHtml(GUIProfiler::instance().summary());
+    ui.profiler_log->verticalScrollBar()->setValue(scroll);
+}
+
+void RoverGUIPlugin::profilerExportButtonEventHandler()
+{
+    QString path = QFileDialog::getSaveFileName(widget, tr("Export Profile"),
+                                                    QDir::homePath() + "/rover_gui_profile.csv",
+                                                    tr("CSV File (*.csv)"));
+    if (path.isEmpty()) return;
+
+    if (GUIProfiler::instance().exportToFile(path)) emit sendInfoLogMessage("Exported the GUI profile to " + path);
+    else emit sendInfoLogMessage("<font color=red>Could not write the GUI profile to " + path + "</font>");
+}
+
 // Slot used to update the GUI diagnostic data output. Ensures we update from the correct process.
 void RoverGUIPlugin::receiveDiagsDataUpdate(QString rover_name, QString text, QColor colour)
 {
+    ScopedTimer timer("receiveDiagsDataUpdate");
+
     if (!diag_update_mutex.try_lock()) return;
 
     // Find the row in the rover list that corresponds to the rover that sent us the diagnostics message
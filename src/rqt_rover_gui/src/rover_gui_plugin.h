@@ -48,7 +48,10 @@
 #include <QProcess>
 #include <map>
 #include <set>
+#include <vector>
 #include <mutex>
+#include <atomic>
+#include <boost/shared_ptr.hpp>
 
 
 //ROS msg types
@@ -57,14 +60,17 @@
 
 #include <QWidget>
 #include <QTimer>
+#include <QThread>
 #include <QLabel>
 
 #include "GazeboSimManager.h"
 #include "JoystickGripperInterface.h"
+#include "RoverDiscovery.h"
 
 
 // Forward declarations
 class MapData;
+class QProgressDialog;
 
 using namespace std;
 
@@ -103,9 +109,10 @@ namespace rqt_rover_gui {
     void statusEventHandler(const ros::MessageEvent<std_msgs::String const>& event);
     void joyEventHandler(const sensor_msgs::Joy::ConstPtr& joy_msg);
     void cameraEventHandler(const sensor_msgs::ImageConstPtr& image);
-    void EKFEventHandler(const ros::MessageEvent<const nav_msgs::Odometry> &event);
-    void GPSEventHandler(const ros::MessageEvent<const nav_msgs::Odometry> &event);
-    void encoderEventHandler(const ros::MessageEvent<const nav_msgs::Odometry> &event);
+    // The rover ID from MapData::registerRover is bound in when the rover connects
+    void EKFEventHandler(const nav_msgs::Odometry::ConstPtr& msg, int rover_id);
+    void GPSEventHandler(const nav_msgs::Odometry::ConstPtr& msg, int rover_id);
+    void encoderEventHandler(const nav_msgs::Odometry::ConstPtr& msg, int rover_id);
     void obstacleEventHandler(const ros::MessageEvent<std_msgs::UInt8 const>& event);
     void diagnosticEventHandler(const ros::MessageEvent<std_msgs::Float32MultiArray const> &event);
 
@@ -122,8 +129,7 @@ namespace rqt_rover_gui {
     QString addPowerLawTargets();
     QString addUniformTargets();
     QString addClusteredTargets();
-    QString addFinalsWalls();
-    QString addPrelimsWalls();
+    QString spawnQueuedModels(QProgressDialog& progress_dialog);
 
 
    // void targetDetectedEventHandler( rover_onboard_target_detection::ATag tagInfo ); //rover_onboard_target_detection::ATag msg );
@@ -132,7 +138,6 @@ namespace rqt_rover_gui {
     void setupPublishers();
 
     // Detect rovers that are broadcasting information
-    set<string> findConnectedRovers();
 
   signals:
 
@@ -161,6 +166,8 @@ namespace rqt_rover_gui {
     void receiveDiagLogMessage(QString);
     void currentRoverChangedEventHandler(QListWidgetItem *current, QListWidgetItem *previous);
     void pollRoversTimerEventHandler();
+    void roverConnectedEventHandler(QString rover_name);
+    void roverDisconnectedEventHandler(QString rover_name);
     void GPSCheckboxToggledEventHandler(bool checked);
     void EKFCheckboxToggledEventHandler(bool checked);
     void encoderCheckboxToggledEventHandler(bool checked);
@@ -170,6 +177,7 @@ namespace rqt_rover_gui {
     void mapAutoRadioButtonEventHandler(bool marked);
     void mapManualRadioButtonEventHandler(bool marked);
     void mapPopoutButtonEventHandler();
+    void mapReplayButtonEventHandler();
 
     void joystickRadioButtonEventHandler(bool marked);
     void autonomousRadioButtonEventHandler(bool marked);
@@ -185,6 +193,11 @@ namespace rqt_rover_gui {
     void displayInfoLogMessage(QString msg);
     void displayDiagLogMessage(QString msg);
 
+    // Show the callback and paint timings collected by the GUIProfiler
+    void profilerCheckboxToggledEventHandler(bool checked);
+    void profilerTimerEventHandler();
+    void profilerExportButtonEventHandler();
+
     // Needed to refocus the keyboard events when the user clicks on the widget list
     // to the main widget so keyboard manual control is handled properly
     void refocusKeyboardEventHandler();
@@ -194,9 +207,28 @@ namespace rqt_rover_gui {
     void checkAndRepositionRover(QString rover_name, float x, float y);
     void readRoverModelXML(QString path);
 
+    // Sets the mode of every connected rover with a single publish on the topic all the mobility
+    // nodes listen to
+    void publishModeToAllRovers(int mode);
+    void setChannelMode(int rover_id, int mode);
+
+    // Sends a mobility node that subscribes to its rover's mode topic the rover's current mode. Called
+    // from the ROS spinner thread, so the mode is read from the atomic rather than rover_control_state.
+    static void modeSubscriberConnected(const ros::SingleSubscriberPublisher& subscriber, boost::shared_ptr< std::atomic<int> > mode);
+
+    // Advertised when a rover connects so selecting it or changing its mode does not wait for
+    // a new publisher to connect
+    struct RoverCommandChannel
+    {
+        ros::Publisher mode;
+        ros::Publisher joystick;
+        boost::shared_ptr< std::atomic<int> > current_mode; // -1 until the rover is given a mode
+    };
+
     // ROS Publishers
-    map<string,ros::Publisher> control_mode_publishers;
-    ros::Publisher joystick_publisher;
+    vector<RoverCommandChannel> command_channels; // Indexed by the MapData rover ID
+    ros::Publisher all_rovers_mode_publisher;
+    ros::Publisher joystick_publisher; // A copy of the selected rover's joystick channel
 
     // ROS Subscribers
     ros::Subscriber joystick_subscriber;
@@ -214,15 +246,23 @@ namespace rqt_rover_gui {
     map<string,ros::Subscriber> status_subscribers;
     map<string,ros::Subscriber> obstacle_subscribers;
     image_transport::Subscriber camera_subscriber;
+    string camera_transport; // The image_transport used for the camera, e.g. theora, compressed or raw
+    QString run_log_path; // Where the map is recorded, empty if it is not
 
     string selected_rover_name;
+    int selected_rover_id; // -1 when no rover is selected
     set<string> rover_names;
     ros::NodeHandle nh;
     QWidget* widget;
     Ui::RoverGUI ui;
 
     QProcess* joy_process;
-    QTimer* rover_poll_timer; // for rover polling
+    QTimer* rover_poll_timer; // for rover status updates
+    QTimer* profiler_timer; // refreshes the profiler tab while profiling
+
+    // Finds rovers connecting and disconnecting without blocking the GUI thread
+    QThread* rover_discovery_thread;
+    RoverDiscovery* rover_discovery;
 
     QString info_log_messages;
     QString diag_log_messages;
@@ -237,13 +277,8 @@ namespace rqt_rover_gui {
     bool display_sim_visualization;
 
     // Object clearance. These values are used to quickly determine where objects can be placed int time simulation
-    float target_cluster_size_64_clearance;
-    float target_cluster_size_16_clearance;
-    float target_cluster_size_4_clearance;
-    float target_cluster_size_1_clearance;
     float rover_clearance;
     float collection_disk_clearance;
-    float barrier_clearance;
 
     unsigned long obstacle_call_count;
 